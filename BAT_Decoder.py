@@ -0,0 +1,541 @@
+"""
+BAT_Decoder.py
+
+Descodificador dos registos binários do Bat-mon (LOG_DEFERRED=1).
+
+Cada registo chega pela UART como 0x00 + COBS(payload + CRC16) + 0x00 e pode
+vir intercalado com texto normal. O payload de um log é:
+
+    [0x01][nível << 4 | nargs][id varint][timestamp 4B][ms varint][args zigzag varint...]
+
+O texto das mensagens vem de firmware_v1.0/Core/Inc/log_strings.h, lido em
+tempo de execução, e a saída reproduz as linhas coloridas do log_write().
+
+decode_series() lê os blocos de séries temporais de series.h: uma âncora com o
+tempo e a primeira amostra, depois uma secção por chunk com as larguras em bits
+e os deltas zigzag empacotados. Uma secção quantizada traz os passos e o bloco
+sai com um aviso "arredondado a".
+
+O uplink BLE (uplink.h, USART2) usa as mesmas frames com outro tipo, cada uma
+com um lote de leituras:
+
+    [0x02][flags][seq u16 LE][bloco de série]
+
+Lido da porta do módulo BLE, ou do pty do batmon_sim -b, a saída é uma linha
+por leitura e um aviso quando falta um seq.
+
+Com LOG_TELEMETRY=1 cada DATA_READ sai também como uma frame com os valores
+exatos (centésimas de °C e %RH, mg), lida pelo BAT_Signal.py:
+
+    [0x03][seq u16 LE][flags][timestamp 4B][ms varint][temp zigzag][hum][x][y][z zigzag]
+
+Uso:
+    python BAT_Decoder.py --port COM3
+    python BAT_Decoder.py --file captura.bin
+    batmon_sim -v | python BAT_Decoder.py --file -
+    python BAT_Decoder.py --series 5a58...            (bloco do uplink)
+    python BAT_Decoder.py --series 5a58... --eeprom   (registos MEM_SERIES_*)
+    batmon_sim -b    ->    python BAT_Decoder.py --port /dev/pts/N
+"""
+
+import argparse
+import datetime
+import os
+import re
+import sys
+
+FRAME_DELIM = 0x00
+FRAME_TYPE_LOG = 0x01
+FRAME_TYPE_UPLINK = 0x02
+FRAME_TYPE_TELEMETRY = 0x03
+
+UPLINK_HEADER_SIZE = 4
+UPLINK_FLAG_ANOMALY = 0x01
+UPLINK_FLAG_VIBRATION = 0x02
+VIB_BANDS_HZ = (3, 6, 11, 19)   # centro das bandas de vibration.h a 50 Hz
+
+TELEMETRY_FLAG_TEMP = 0x01
+TELEMETRY_FLAG_HUM = 0x02
+TELEMETRY_FLAG_VIB = 0x04
+TELEMETRY_FLAG_SHOCK = 0x08
+
+CRC16_INIT = 0xFFFF
+
+RESET_COLOR = "\033[1;0m"
+
+# Igual a log_list[] em logger.c
+LOG_LEVELS = {
+    0: ("ERROR", "\033[1;31m"),
+    1: ("INFO ", "\033[0;32m"),
+    2: ("DEBUG", "\033[0;36m"),
+    3: ("WARNING", "\033[0;33m"),
+}
+
+YEAR_COEF = 2000
+
+# Igual a series.h: canais (temp e hum em centésimas, accel em mg). O passo de
+# quantização vem em cada secção (L), sem ele é 1, sem perdas
+SERIES_CHANNELS = ("temp", "hum", "x", "y", "z")
+SERIES_UNITS = ("°C", "%RH", "mg", "mg", "mg")
+SERIES_STEP_CODES = (1, 2, 4, 5, 10, 20, 50, 100)
+SERIES_STEP_BITS = 3
+SERIES_TIME_WIDTH_BITS = 6
+SERIES_WIDTH_BITS = 4
+SERIES_WIDTH_WIDE = 15
+SERIES_WIDE = 17
+SERIES_EPOCH = datetime.datetime(YEAR_COEF, 1, 1)
+
+# Parâmetros de cada série: bytes por chunk, canais e passo nominal em segundos
+UPLINK_SERIES = (96, 5, 0)          # uplink.h: UPLINK_BLOCK_SIZE, um só chunk
+MEM_SERIES = (8, 2, 15 * 60)        # mal.h: MEM_SERIES_CHUNK, _CHANNELS, _STEP
+
+DEFAULT_STRINGS = os.path.join(os.path.dirname(os.path.abspath(__file__)),
+                               "firmware_v1.0", "Core", "Inc", "log_strings.h")
+
+_ENTRY_RE = re.compile(r'X\(\s*(\w+)\s*,\s*"((?:[^"\\]|\\.)*)"\s*\)')
+
+
+def load_log_strings(path=DEFAULT_STRINGS):
+    """Lê a tabela X(ID, "formato") pela ordem: o índice é o ID do registo"""
+    with open(path, encoding="utf-8") as f:
+        source = f.read()
+
+    table = []
+    for name, fmt in _ENTRY_RE.findall(source):
+        fmt = fmt.encode("utf-8").decode("unicode_escape")
+        table.append((name, fmt))
+    return table
+
+
+def _crc16_table():
+    table = []
+    for byte in range(256):
+        crc = byte << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) if crc & 0x8000 else (crc << 1)
+        table.append(crc & 0xFFFF)
+    return table
+
+
+# Uma entrada por byte em vez de 8 passos por bit: o BAT_Ingest.py valida o CRC
+# de todas as frames de todos os dispositivos no mesmo core
+_CRC16_TABLE = _crc16_table()
+
+
+def crc16_ccitt(data, crc=CRC16_INIT):
+    """CRC-16/CCITT-FALSE, igual a crc16_ccitt() em frame.c"""
+    for byte in data:
+        crc = ((crc << 8) & 0xFFFF) ^ _CRC16_TABLE[(crc >> 8) ^ byte]
+    return crc
+
+
+def cobs_decode(data):
+    """Devolve os bytes descodificados ou None se o bloco não for COBS válido"""
+    out = bytearray()
+    i = 0
+    while i < len(data):
+        code = data[i]
+        if code == 0 or i + code > len(data):
+            return None
+        out += data[i + 1:i + code]
+        i += code
+        if code < 0xFF and i < len(data):
+            out.append(0)
+    return bytes(out)
+
+
+def read_varint(data, pos):
+    value = 0
+    shift = 0
+    while True:
+        if pos >= len(data) or shift > 28:
+            raise ValueError("varint truncado")
+        byte = data[pos]
+        pos += 1
+        value |= (byte & 0x7F) << shift
+        if not byte & 0x80:
+            return value, pos
+        shift += 7
+
+
+def zigzag_decode(value):
+    return (value >> 1) ^ -(value & 1)
+
+
+def unpack_timestamp(packed):
+    """Inverso de pack_timestamp() em mal.c -> (ano, mês, dia, hora, min, seg)"""
+    return ((packed >> 26) & 0x3F) + YEAR_COEF, (packed >> 22) & 0x0F, (packed >> 17) & 0x1F, \
+        (packed >> 12) & 0x1F, (packed >> 6) & 0x3F, packed & 0x3F
+
+
+def get_bits(block, pos, bits):
+    """bits bits a partir do bit pos, o menos significativo primeiro (put_bits() em series.c)"""
+    value = 0
+    for i in range(bits):
+        if block[(pos + i) >> 3] >> ((pos + i) & 7) & 1:
+            value |= 1 << i
+    return value
+
+
+def quantise(value, step):
+    """Passo mais próximo, metades para longe do zero, como quantise() em series.c"""
+    q = (abs(value) + step // 2) // step
+    return q if value >= 0 else -q
+
+
+def series_sections(block, chunk, channels, step, pos):
+    """Secções do bloco a partir do bit pos -> (E, passos, [(passo de tempo, deltas)])"""
+    count_bits = (chunk * 8).bit_length()
+    while pos < len(block) * 8:
+        end = min((pos // 8 // chunk + 1) * chunk, len(block)) * 8
+
+        def read(bits):
+            nonlocal pos
+            if pos + bits > end:
+                raise ValueError("secção de série truncada")
+            value = get_bits(block, pos, bits)
+            pos += bits
+            return value
+
+        # Enchimento: resto do chunk da âncora, último chunk curto ou EEPROM apagada
+        full = read(1) if pos < end else 0
+        count = read(count_bits) if not full and pos + count_bits <= end else 0
+        if not full and count == 0:
+            pos = end
+            continue
+
+        linked = read(1)
+        lossy = read(1)
+        steps = tuple(SERIES_STEP_CODES[read(SERIES_STEP_BITS)] if lossy else 1 for _ in range(channels))
+        base, time_width = step, 0
+        if not read(1):
+            base = zigzag_decode(read(read(SERIES_TIME_WIDTH_BITS)))
+            time_width = read(SERIES_TIME_WIDTH_BITS)
+        widths = []
+        for _ in range(channels):
+            code = read(SERIES_WIDTH_BITS)
+            widths.append(SERIES_WIDE if code == SERIES_WIDTH_WIDE else code)
+
+        # F: tantas amostras quantas cabem no resto do chunk
+        if full:
+            bits = time_width + sum(widths)
+            if bits == 0:
+                raise ValueError("secção de série inválida")
+            count = (end - pos) // bits
+
+        samples = []
+        for _ in range(count):
+            dt = base + zigzag_decode(read(time_width))
+            samples.append((dt, [zigzag_decode(read(width)) for width in widths]))
+        pos = end
+        yield linked, steps, samples
+
+
+def format_steps(steps):
+    """Aviso de perda de precisão, vazio se o bloco é exato"""
+    if all(step == 1 for step in steps):
+        return ""
+    return "arredondado a " + ", ".join(f"{step / (100 if c < 2 else 1):g} {SERIES_UNITS[c]}"
+                                        for c, step in enumerate(steps))
+
+
+def decode_series(block, series=UPLINK_SERIES):
+    """Bloco de series.c -> (passos, lista de (datetime, {canal: valor})), valores em unidades
+    naturais. passos: os da última secção, um por canal (1: exato)"""
+    chunk, channels, step = series
+    if len(block) * 8 < 32 + 16 * channels:
+        raise ValueError("âncora de série truncada")
+    time = get_bits(block, 0, 32)
+    last = []
+    for c in range(channels):
+        value = get_bits(block, 32 + 16 * c, 16)
+        last.append(value - 0x10000 if value & 0x8000 else value)
+
+    def sample():
+        values = {SERIES_CHANNELS[c]: last[c] / (100 if c < 2 else 1) for c in range(channels)}
+        return SERIES_EPOCH + datetime.timedelta(seconds=time), values
+
+    samples = [sample()]
+    steps = (1,) * channels
+    for _, steps, section in series_sections(block, chunk, channels, step, 32 + 16 * channels):
+        for dt, deltas in section:
+            time = (time + dt) & 0xFFFFFFFF
+            last = [(quantise(last[c], steps[c]) + deltas[c]) * steps[c] for c in range(channels)]
+            samples.append(sample())
+    return steps, samples
+
+
+def decode_frame(block):
+    """COBS + CRC -> payload sem CRC, ou None se não for uma frame válida"""
+    payload = cobs_decode(block)
+    if payload is None or len(payload) < 3:
+        return None
+    body, crc = payload[:-2], (payload[-2] << 8) | payload[-1]
+    if crc16_ccitt(body) != crc:
+        return None
+    return body
+
+
+def decode_log(payload):
+    """Payload FRAME_TYPE_LOG -> dict com nível, id, timestamp e argumentos"""
+    level = payload[1] >> 4
+    nargs = payload[1] & 0x0F
+    string_id, pos = read_varint(payload, 2)
+    if pos + 4 > len(payload):
+        raise ValueError("timestamp truncado")
+    packed = int.from_bytes(payload[pos:pos + 4], "big")
+    ms, pos = read_varint(payload, pos + 4)
+
+    args = []
+    for _ in range(nargs):
+        value, pos = read_varint(payload, pos)
+        args.append(zigzag_decode(value))
+
+    return {"level": level, "id": string_id, "time": unpack_timestamp(packed), "ms": ms, "args": args}
+
+
+def decode_telemetry(payload):
+    """Payload FRAME_TYPE_TELEMETRY -> dict com seq, flags, timestamp e os valores em unidades naturais"""
+    if len(payload) < 8:
+        raise ValueError("telemetria truncada")
+    seq = int.from_bytes(payload[1:3], "little")
+    flags = payload[3]
+    packed = int.from_bytes(payload[4:8], "big")
+    ms, pos = read_varint(payload, 8)
+
+    values = []
+    for signed in (True, False, True, True, True):
+        value, pos = read_varint(payload, pos)
+        values.append(zigzag_decode(value) if signed else value)
+
+    return {"seq": seq, "flags": flags, "time": unpack_timestamp(packed), "ms": ms,
+            "temperature": values[0] / 100, "humidity": values[1] / 100,
+            "accel_x": values[2], "accel_y": values[3], "accel_z": values[4]}
+
+
+def format_telemetry(record):
+    """Linha legível de uma frame de telemetria"""
+    year, month, day, hour, minute, second = record["time"]
+    alerts = "".join(f" {name}" for bit, name in ((TELEMETRY_FLAG_TEMP, "TEMP!"), (TELEMETRY_FLAG_HUM, "HUM!"),
+                                                        (TELEMETRY_FLAG_VIB, "VIB!"), (TELEMETRY_FLAG_SHOCK, "SHOCK!"))
+                     if record["flags"] & bit)
+    return (f"[TELEMETRIA #{record['seq']}] {record['temperature']:.2f} C {record['humidity']:.2f} % "
+            f"X {record['accel_x']} Y {record['accel_y']} Z {record['accel_z']} mg{alerts}"
+            f" @ {hour:02d}:{minute:02d}:{second:02d}.{record['ms']:03d} - {day:02d}/{month:02d}/{year:02d}\r\n")
+
+
+def decode_vibration(payload, pos):
+    """Resumo de vibração do lote (máximos): rms, p-p e crest X/Y/Z e as bandas"""
+    fields = []
+    for _ in range(3 * 3 + len(VIB_BANDS_HZ)):
+        value, pos = read_varint(payload, pos)
+        fields.append(value)
+    return {"rms": fields[0:3], "peak_to_peak": fields[3:6],
+            "crest": [c / 100 for c in fields[6:9]], "bands": fields[9:]}, pos
+
+
+def decode_uplink(payload):
+    """Payload FRAME_TYPE_UPLINK -> dict com seq, flags, o resumo de vibração
+    (None sem UPLINK_FLAG_VIBRATION) e as leituras do lote"""
+    if len(payload) < UPLINK_HEADER_SIZE:
+        raise ValueError("cabeçalho de uplink truncado")
+    flags = payload[1]
+    vibration, pos = None, UPLINK_HEADER_SIZE
+    if flags & UPLINK_FLAG_VIBRATION:
+        vibration, pos = decode_vibration(payload, pos)
+    steps, samples = decode_series(payload[pos:])
+    return {"flags": flags, "seq": int.from_bytes(payload[2:4], "little"),
+            "vibration": vibration, "steps": steps, "samples": samples}
+
+
+class UplinkTracker:
+    """Conta lotes e leituras e deteta frames perdidas pelos saltos de seq"""
+
+    def __init__(self):
+        self.next_seq = None
+        self.frames = 0
+        self.readings = 0
+        self.lost = 0
+
+    def feed(self, batch):
+        """Devolve quantas frames faltam antes desta"""
+        gap = 0
+        if self.next_seq is not None:
+            gap = (batch["seq"] - self.next_seq) & 0xFFFF
+        self.next_seq = (batch["seq"] + 1) & 0xFFFF
+        self.frames += 1
+        self.readings += len(batch["samples"])
+        self.lost += gap
+        return gap
+
+
+def format_uplink(batch, gap, color=True):
+    """Uma linha por leitura, com o seq do lote e a marca de anomalia"""
+    anomaly = batch["flags"] & UPLINK_FLAG_ANOMALY
+    lines = []
+    if gap:
+        lines.append(f"[UPLINK] {gap} frame(s) perdida(s) antes do seq {batch['seq']}\r\n")
+    vib = batch.get("vibration")
+    if vib:
+        bands = " ".join(f"{hz}Hz={mg}" for hz, mg in zip(VIB_BANDS_HZ, vib["bands"]))
+        lines.append(f"[UPLINK #{batch['seq']} VIBRAÇÃO] rms X/Y/Z {'/'.join(map(str, vib['rms']))} mg, "
+                     f"p-p {'/'.join(map(str, vib['peak_to_peak']))} mg, "
+                     f"crest {'/'.join(f'{c:.2f}' for c in vib['crest'])}, bandas {bands} mg\r\n")
+    steps = format_steps(batch["steps"])
+    if steps:
+        lines.append(f"[UPLINK #{batch['seq']}] {steps}\r\n")
+    for when, values in batch["samples"]:
+        text = " ".join(f"{k}={v:g}" for k, v in values.items())
+        line = f"[UPLINK #{batch['seq']}{' ANOMALIA' if anomaly else ''}] {when.isoformat(sep=' ')} {text}"
+        if color and anomaly:
+            line = f"{LOG_LEVELS[3][1]}{line}{RESET_COLOR}"
+        lines.append(line + "\r\n")
+    return "".join(lines)
+
+
+def format_log(record, strings, color=True):
+    """Reconstrói a linha tal como o log_write() a formataria"""
+    name, code = LOG_LEVELS.get(record["level"], ("?????", ""))
+    if record["id"] < len(strings):
+        fmt = strings[record["id"]][1]
+        try:
+            msg = fmt % tuple(record["args"])
+        except (TypeError, ValueError):
+            msg = f"{fmt} {record['args']}"
+    else:
+        msg = f"<string {record['id']} desconhecida> {record['args']}"
+
+    year, month, day, hour, minute, second = record["time"]
+    stamp = f" @ {hour:02d}:{minute:02d}:{second:02d}.{record['ms']:03d} - {day:02d}/{month:02d}/{year:02d}\r\n"
+
+    if color:
+        return f"{code}[{name}] {msg}{RESET_COLOR}{stamp}"
+    return f"[{name}] {msg}{stamp}"
+
+
+class FrameSplitter:
+    """Separa o fluxo da UART em texto e frames binárias.
+
+    O fluxo é partido em cada 0x00: um bloco que descodifica como COBS com
+    CRC válido é uma frame, o resto passa como texto.
+    """
+
+    def __init__(self, max_block=1024):
+        self.buffer = bytearray()
+        self.max_block = max_block
+        self.crc_errors = 0
+        self.in_frame = False  # paridade dos 0x00: entre os dois de uma frame
+
+    def feed(self, data):
+        """Devolve uma lista de ("text", bytes) e ("frame", payload)"""
+        out = []
+        buffer = self.buffer
+        buffer += data
+        start = 0
+
+        while True:
+            end = buffer.find(FRAME_DELIM, start)
+            if end < 0:
+                break
+
+            block = bytes(buffer[start:end])
+            start = end + 1
+            self.in_frame = not self.in_frame
+
+            if not block:
+                continue
+
+            payload = decode_frame(block)
+            if payload is not None:
+                out.append(("frame", payload))
+                self.in_frame = False
+            else:
+                if len(block) < 256 and not block.endswith(b"\n"):
+                    self.crc_errors += 1
+                out.append(("text", block))
+
+        # Um só corte por leitura, seja qual for o número de frames
+        del buffer[:start]
+
+        # Texto sem frames: não é preciso esperar por um 0x00. Dentro de uma
+        # frame um 0x0A no fim de uma leitura não é fim de linha
+        if len(buffer) > self.max_block or (not self.in_frame and buffer.endswith(b"\n")):
+            out.append(("text", bytes(buffer)))
+            buffer.clear()
+        return out
+
+
+def open_source(args):
+    if args.port:
+        import serial
+        return serial.Serial(args.port, args.baudrate, timeout=1)
+    if args.file == "-":
+        return sys.stdin.buffer
+    return open(args.file, "rb")
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Descodificador dos logs binários do Bat-mon")
+    source = parser.add_mutually_exclusive_group(required=True)
+    source.add_argument("--port", help="porta série (ex. COM3, /dev/ttyUSB0)")
+    source.add_argument("--file", help="ficheiro capturado, '-' para stdin")
+    source.add_argument("--series", metavar="HEX", help="descodifica um bloco de série em hexadecimal")
+    parser.add_argument("--eeprom", action="store_true", help="o bloco de --series vem dos registos MEM_SERIES_*")
+    parser.add_argument("--baudrate", type=int, default=115200)
+    parser.add_argument("--strings", default=DEFAULT_STRINGS, help="caminho para log_strings.h")
+    parser.add_argument("--no-color", action="store_true", help="sem códigos de cor ANSI")
+    args = parser.parse_args()
+
+    if args.series:
+        steps, samples = decode_series(bytes.fromhex(args.series), MEM_SERIES if args.eeprom else UPLINK_SERIES)
+        if format_steps(steps):
+            print(format_steps(steps))
+        for when, values in samples:
+            print(when.isoformat(sep=" "), " ".join(f"{k}={v:g}" for k, v in values.items()))
+        return
+
+    strings = load_log_strings(args.strings)
+    splitter = FrameSplitter()
+    uplink = UplinkTracker()
+    stream = open_source(args)
+    out = sys.stdout
+
+    try:
+        while True:
+            data = stream.read(256) if not hasattr(stream, "in_waiting") else stream.read(max(1, stream.in_waiting))
+            if not data:
+                if args.port:
+                    continue
+                break
+            for kind, item in splitter.feed(data):
+                if kind == "text":
+                    out.write(item.decode("utf-8", errors="replace"))
+                elif item[0] == FRAME_TYPE_LOG:
+                    try:
+                        out.write(format_log(decode_log(item), strings, not args.no_color))
+                    except ValueError as e:
+                        out.write(f"[frame inválida: {e}]\r\n")
+                elif item[0] == FRAME_TYPE_TELEMETRY:
+                    try:
+                        out.write(format_telemetry(decode_telemetry(item)))
+                    except ValueError as e:
+                        out.write(f"[frame inválida: {e}]\r\n")
+                elif item[0] == FRAME_TYPE_UPLINK:
+                    try:
+                        batch = decode_uplink(item)
+                        out.write(format_uplink(batch, uplink.feed(batch), not args.no_color))
+                    except ValueError as e:
+                        out.write(f"[frame inválida: {e}]\r\n")
+            out.flush()
+    except KeyboardInterrupt:
+        pass
+    finally:
+        if stream is not sys.stdin.buffer:
+            stream.close()
+        if uplink.frames:
+            sys.stderr.write(f"uplink: {uplink.frames} frames, {uplink.readings} leituras, "
+                             f"{uplink.lost} frames perdidas, {splitter.crc_errors} erros de CRC\n")
+
+
+if __name__ == "__main__":
+    main()
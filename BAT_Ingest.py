@@ -0,0 +1,412 @@
+"""
+BAT_Ingest.py
+
+Serviço de ingestão para uma frota de Bat-mon, sem interface gráfica.
+
+Lê muitas portas série/pty em simultâneo, com uma tarefa asyncio por porta e
+um único event loop, sem threads nem pyserial. Cada leitura é marcada com o
+ID do dispositivo e vai para uma base SQLite partilhada, escrita em lote.
+
+Aceita as frames do BAT_Decoder.py:
+    - telemetria (LOG_TELEMETRY=1, UART de debug), uma leitura por frame
+    - uplink (USART2, módulo BLE), um lote de leituras por frame
+O texto e os logs que venham na mesma porta são só contados.
+
+Periodicamente escreve para stderr uma linha por dispositivo: leituras/s,
+bytes/s, frames perdidas (saltos de seq), erros de CRC e a latência. A
+latência é o atraso de chegada em relação ao melhor já visto para esse
+dispositivo, o que dispensa relógios sincronizados.
+
+Uso:
+    python BAT_Ingest.py --db frota.db armazem1=/dev/ttyUSB0 camiao7=/dev/ttyACM0
+    batmon_sim -b    ->    python BAT_Ingest.py --db sim.db sim=/dev/pts/N
+    python BAT_Ingest.py --db /tmp/teste.db --simulate 100 --rate 10
+
+--simulate N cria N pares de pty com dispositivos sintéticos que emitem
+frames de telemetria, para testar o serviço sem hardware.
+
+Só POSIX: as portas são configuradas com termios e lidas pelo event loop.
+"""
+
+import argparse
+import asyncio
+import calendar
+import os
+import random
+import sqlite3
+import sys
+import termios
+import time
+import tty
+
+from BAT_Decoder import (FrameSplitter, UplinkTracker, FRAME_TYPE_LOG, FRAME_TYPE_UPLINK,
+                         FRAME_TYPE_TELEMETRY, UPLINK_FLAG_ANOMALY, YEAR_COEF,
+                         crc16_ccitt, decode_telemetry, decode_uplink)
+
+READ_SIZE = 4096
+REOPEN_DELAY = 2.0
+
+SCHEMA = """
+CREATE TABLE IF NOT EXISTS samples(
+    device TEXT NOT NULL,
+    source TEXT NOT NULL,       -- 'telemetry' ou 'uplink'
+    time REAL NOT NULL,         -- hora do dispositivo (s desde 1970, sem fuso)
+    received REAL NOT NULL,     -- hora de chegada ao gateway
+    seq INTEGER,
+    flags INTEGER,
+    temperature REAL,
+    humidity REAL,
+    accel_x REAL,
+    accel_y REAL,
+    accel_z REAL
+);
+CREATE INDEX IF NOT EXISTS samples_device_time ON samples(device, time);
+"""
+
+
+def device_seconds(year, month, day, hour, minute, second):
+    """Hora do RTC do dispositivo em segundos, tratada como UTC"""
+    return calendar.timegm((year, month, day, hour, minute, second, 0, 0, 0))
+
+
+def open_port(path, baudrate):
+    """Abre uma porta série/pty em modo raw e não bloqueante"""
+    fd = os.open(path, os.O_RDWR | os.O_NOCTTY | os.O_NONBLOCK)
+    try:
+        tty.setraw(fd)
+        attrs = termios.tcgetattr(fd)
+        speed = getattr(termios, f"B{baudrate}")
+        attrs[4] = attrs[5] = speed
+        termios.tcsetattr(fd, termios.TCSANOW, attrs)
+    except (termios.error, AttributeError):
+        os.close(fd)
+        raise OSError(f"não foi possível configurar {path} a {baudrate} bps")
+    return fd
+
+
+class Store:
+    """Base SQLite partilhada: as leituras acumulam em memória e são escritas
+    numa só transação a cada flush, seja qual for o número de dispositivos"""
+
+    def __init__(self, path):
+        self.db = sqlite3.connect(path)
+        self.db.execute("PRAGMA journal_mode=WAL")
+        self.db.execute("PRAGMA synchronous=NORMAL")
+        self.db.executescript(SCHEMA)
+        self.pending = []
+        self.written = 0
+        self.flush_time = 0.0
+
+    def add(self, row):
+        self.pending.append(row)
+
+    def flush(self):
+        if not self.pending:
+            return
+        started = time.perf_counter()
+        with self.db:
+            self.db.executemany("INSERT INTO samples VALUES (?,?,?,?,?,?,?,?,?,?,?)", self.pending)
+        self.written += len(self.pending)
+        self.pending = []
+        self.flush_time = time.perf_counter() - started
+
+    def close(self):
+        self.flush()
+        self.db.close()
+
+
+class Device:
+    """Uma porta: separa as frames, valida os seq e passa as leituras à base"""
+
+    def __init__(self, device_id, path, store, baudrate=115200):
+        self.id = device_id
+        self.path = path
+        self.store = store
+        self.baudrate = baudrate
+        self.splitter = FrameSplitter()
+        self.uplink = UplinkTracker()
+        self.next_seq = None
+        self.connected = False
+
+        self.bytes = 0
+        self.samples = 0
+        self.lost = 0
+        self.invalid = 0
+        self.logs = 0
+        self.last_rx = None
+        self.offset = None      # menor (chegada - hora do dispositivo) já visto
+
+        # Janela do relatório
+        self.window_bytes = 0
+        self.window_samples = 0
+        self.window_lag = 0.0
+
+    def track_lag(self, received, device_time):
+        offset = received - device_time
+        if self.offset is None or offset < self.offset:
+            self.offset = offset
+        self.window_lag = max(self.window_lag, offset - self.offset)
+
+    def add_telemetry(self, payload, received):
+        record = decode_telemetry(payload)
+        if self.next_seq is not None and record["seq"] != self.next_seq:
+            self.lost += (record["seq"] - self.next_seq) & 0xFFFF
+        self.next_seq = (record["seq"] + 1) & 0xFFFF
+
+        when = device_seconds(*record["time"]) + record["ms"] / 1000
+        self.store.add((self.id, "telemetry", when, received, record["seq"], record["flags"],
+                        record["temperature"], record["humidity"],
+                        record["accel_x"], record["accel_y"], record["accel_z"]))
+        self.samples += 1
+        self.window_samples += 1
+        self.track_lag(received, when)
+
+    def add_uplink(self, payload, received):
+        batch = decode_uplink(payload)
+        self.lost += self.uplink.feed(batch)
+        flags = batch["flags"] & UPLINK_FLAG_ANOMALY
+
+        when = None
+        for stamp, values in batch["samples"]:
+            when = calendar.timegm(stamp.timetuple())
+            self.store.add((self.id, "uplink", when, received, batch["seq"], flags,
+                            values.get("temp"), values.get("hum"),
+                            values.get("x"), values.get("y"), values.get("z")))
+        self.samples += len(batch["samples"])
+        self.window_samples += len(batch["samples"])
+        # O lote sai quando enche: conta a latência da leitura mais recente
+        if when is not None:
+            self.track_lag(received, when)
+
+    def feed(self, data):
+        received = time.time()
+        self.bytes += len(data)
+        self.window_bytes += len(data)
+        self.last_rx = received
+
+        for kind, item in self.splitter.feed(data):
+            if kind != "frame":
+                continue
+            try:
+                if item[0] == FRAME_TYPE_TELEMETRY:
+                    self.add_telemetry(item, received)
+                elif item[0] == FRAME_TYPE_UPLINK:
+                    self.add_uplink(item, received)
+                elif item[0] == FRAME_TYPE_LOG:
+                    self.logs += 1
+            except ValueError:
+                self.invalid += 1
+
+    async def run(self):
+        """Tarefa da porta: lê enquanto houver dados e reabre se a porta cair"""
+        loop = asyncio.get_running_loop()
+        while True:
+            try:
+                fd = open_port(self.path, self.baudrate)
+            except OSError as e:
+                print(f"[{self.id}] {self.path}: {e}", file=sys.stderr)
+                await asyncio.sleep(REOPEN_DELAY)
+                continue
+
+            ready = asyncio.Event()
+            loop.add_reader(fd, ready.set)
+            self.connected = True
+            try:
+                while True:
+                    await ready.wait()
+                    ready.clear()
+                    try:
+                        data = os.read(fd, READ_SIZE)
+                    except BlockingIOError:
+                        continue
+                    if not data:
+                        raise OSError("fim dos dados")
+                    self.feed(data)
+            except OSError as e:
+                print(f"[{self.id}] {self.path}: {e}, a reabrir", file=sys.stderr)
+            finally:
+                self.connected = False
+                loop.remove_reader(fd)
+                os.close(fd)
+            await asyncio.sleep(REOPEN_DELAY)
+
+    def report(self, interval):
+        """Linha do relatório e reinício da janela"""
+        age = f"{time.time() - self.last_rx:5.1f}s" if self.last_rx else "   --"
+        line = (f"{self.id:<12} {self.window_samples / interval:8.1f} leit/s {self.window_bytes / interval:9.0f} B/s "
+                f"lat {1000 * self.window_lag:6.0f} ms  última {age}  perdidas {self.lost}  "
+                f"CRC {self.splitter.crc_errors}  inválidas {self.invalid}"
+                f"{'' if self.connected else '  DESLIGADO'}")
+        self.window_bytes = 0
+        self.window_samples = 0
+        self.window_lag = 0.0
+        return line
+
+
+#---- DISPOSITIVOS SIMULADOS ----
+
+def cobs_encode(data):
+    """Inverso de cobs_decode(), igual a cobs_encode() em frame.c"""
+    out = bytearray([0])
+    code_pos = 0
+    code = 1
+    for byte in data:
+        if byte == 0:
+            out[code_pos] = code
+            code_pos = len(out)
+            out.append(0)
+            code = 1
+            continue
+        out.append(byte)
+        code += 1
+        if code == 0xFF:
+            out[code_pos] = code
+            code_pos = len(out)
+            out.append(0)
+            code = 1
+    out[code_pos] = code
+    return bytes(out)
+
+
+def put_varint(value):
+    out = bytearray()
+    while value >= 0x80:
+        out.append((value & 0x7F) | 0x80)
+        value >>= 7
+    out.append(value)
+    return out
+
+
+def zigzag_encode(value):
+    return (value << 1) ^ (value >> 31)
+
+
+def pack_timestamp(t):
+    """Igual a pack_timestamp() em mal.c"""
+    return ((t.tm_year - YEAR_COEF) << 26) | (t.tm_mon << 22) | (t.tm_mday << 17) | \
+        (t.tm_hour << 12) | (t.tm_min << 6) | t.tm_sec
+
+
+def telemetry_frame(seq, now, temp, hum, accel):
+    """Frame FRAME_TYPE_TELEMETRY tal como log_telemetry() a envia"""
+    t = time.gmtime(now)
+    payload = bytearray([FRAME_TYPE_TELEMETRY, seq & 0xFF, (seq >> 8) & 0xFF, 0])
+    payload += pack_timestamp(t).to_bytes(4, "big")
+    payload += put_varint(int(now * 1000) % 1000)
+    payload += put_varint(zigzag_encode(temp)) + put_varint(hum)
+    for value in accel:
+        payload += put_varint(zigzag_encode(value))
+    crc = crc16_ccitt(payload)
+    return b"\x00" + cobs_encode(payload + bytes([crc >> 8, crc & 0xFF])) + b"\x00"
+
+
+async def simulate_device(master, rate):
+    """Escreve frames de telemetria no lado master de um pty ao ritmo pedido"""
+    loop = asyncio.get_running_loop()
+    temp, hum, seq = random.randint(1800, 2600), random.randint(3500, 6500), 0
+    period = 1 / rate
+    await asyncio.sleep(random.random() * period)
+    next_time = loop.time()
+    while True:
+        temp += random.randint(-2, 2)
+        hum += random.randint(-5, 5)
+        accel = (random.randint(-8, 8), random.randint(-8, 8), 1000 + random.randint(-8, 8))
+        try:
+            os.write(master, telemetry_frame(seq, time.time(), temp, max(hum, 0), accel))
+        except BlockingIOError:
+            pass  # ninguém a ler: o pty encheu, a frame perde-se como na UART
+        seq += 1
+        next_time += period
+        await asyncio.sleep(max(0.0, next_time - loop.time()))
+
+
+def create_simulated(count):
+    """Pares de pty: o master fica para o simulador, o slave é a "porta" lida"""
+    pairs = []
+    for i in range(count):
+        master, slave = os.openpty()
+        os.set_blocking(master, False)
+        pairs.append((f"sim{i:03d}", os.ttyname(slave), master, slave))
+    return pairs
+
+
+#---- SERVIÇO ----
+
+async def flush_loop(store, interval):
+    while True:
+        await asyncio.sleep(interval)
+        store.flush()
+
+
+async def report_loop(devices, store, interval):
+    cpu, wall = time.process_time(), time.perf_counter()
+    while True:
+        await asyncio.sleep(interval)
+        now_cpu, now_wall = time.process_time(), time.perf_counter()
+        elapsed = now_wall - wall
+        lines = [device.report(elapsed) for device in devices]
+        total = sum(d.samples for d in devices)
+        lines.append(f"== {len(devices)} dispositivos, {total} leituras, {store.written} na base, "
+                     f"último flush {1000 * store.flush_time:.1f} ms, CPU {100 * (now_cpu - cpu) / elapsed:.0f}%")
+        print("\n".join(lines), file=sys.stderr, flush=True)
+        cpu, wall = now_cpu, now_wall
+
+
+async def serve(args):
+    store = Store(args.db)
+    devices = []
+    for spec in args.ports:
+        device_id, _, path = spec.rpartition("=")
+        devices.append(Device(device_id or os.path.basename(path), path, store, args.baudrate))
+
+    simulated = create_simulated(args.simulate)
+    for device_id, path, _, _ in simulated:
+        devices.append(Device(device_id, path, store, args.baudrate))
+
+    if not devices:
+        print("Nenhuma porta: indique ID=PORTA ou --simulate N", file=sys.stderr)
+        return
+
+    tasks = [asyncio.create_task(device.run()) for device in devices]
+    tasks += [asyncio.create_task(simulate_device(master, args.rate)) for _, _, master, _ in simulated]
+    tasks.append(asyncio.create_task(flush_loop(store, args.flush)))
+    tasks.append(asyncio.create_task(report_loop(devices, store, args.report)))
+
+    try:
+        if args.duration:
+            await asyncio.sleep(args.duration)
+        else:
+            await asyncio.Event().wait()
+    finally:
+        for task in tasks:
+            task.cancel()
+        await asyncio.gather(*tasks, return_exceptions=True)
+        store.close()
+        for _, _, master, slave in simulated:
+            os.close(master)
+            os.close(slave)
+        print(f"{sum(d.samples for d in devices)} leituras de {len(devices)} dispositivos, "
+              f"{sum(d.lost for d in devices)} frames perdidas, {store.written} na base",
+              file=sys.stderr)
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Ingestão de uma frota de Bat-mon para SQLite")
+    parser.add_argument("ports", nargs="*", metavar="ID=PORTA", help="porta série ou pty, com o ID do dispositivo")
+    parser.add_argument("--db", default="batmon.db", help="base SQLite partilhada")
+    parser.add_argument("--baudrate", type=int, default=115200)
+    parser.add_argument("--flush", type=float, default=1.0, help="segundos entre escritas na base")
+    parser.add_argument("--report", type=float, default=10.0, help="segundos entre relatórios")
+    parser.add_argument("--simulate", type=int, default=0, metavar="N", help="N dispositivos simulados em pty")
+    parser.add_argument("--rate", type=float, default=1.0, help="frames/s de cada dispositivo simulado")
+    parser.add_argument("--duration", type=float, default=0, help="termina ao fim de N segundos (0: nunca)")
+    args = parser.parse_args()
+
+    try:
+        asyncio.run(serve(args))
+    except KeyboardInterrupt:
+        pass
+
+
+if __name__ == "__main__":
+    main()
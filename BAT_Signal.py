@@ -1,12 +1,13 @@
 import re
 import matplotlib.pyplot as plt
-import matplotlib.animation as animation
-from collections import deque
+import numpy as np
 from datetime import datetime
 import threading
 import queue
 import time
 
+from BAT_Decoder import FrameSplitter, FRAME_TYPE_TELEMETRY, decode_telemetry
+
 try:
     import serial
     SERIAL_AVAILABLE = True
@@ -14,24 +15,112 @@ except ImportError:
     print("pyserial não instalado. Use: pip install pyserial")
     SERIAL_AVAILABLE = False
 
+# Colunas do histórico: tempo (s) seguido dos canais na ordem da telemetria
+CHANNELS = ('temperature', 'humidity', 'accel_x', 'accel_y', 'accel_z')
+
+# Os valores atuais são lidos por humanos: rasterizar o texto a cada tick
+# custaria mais do que as linhas, por isso só é refeito a esta cadência
+READOUT_PERIOD = 0.2
+
+# Linha de texto sem '\n' maior do que isto é lixo (baudrate errado, ruído)
+MAX_LINE = 4096
+
+
+class RingBuffer:
+    """Histórico pré-alocado de tamanho fixo, uma linha do array por coluna.
+
+    Cada amostra é escrita duas vezes (em i e em i + capacity), por isso a
+    janela cronológica é sempre uma fatia contígua: view() não copia nada e
+    extend() não realoca, seja qual for o ritmo de chegada."""
+
+    def __init__(self, capacity, columns):
+        self.capacity = capacity
+        self.data = np.zeros((columns, 2 * capacity))
+        self.head = 0
+        self.count = 0
+
+    def __len__(self):
+        return self.count
+
+    def clear(self):
+        self.head = 0
+        self.count = 0
+
+    def extend(self, rows):
+        """Acrescenta um lote de amostras (n x colunas) de uma só vez"""
+        rows = np.asarray(rows, dtype=float)
+        if len(rows) > self.capacity:
+            rows = rows[-self.capacity:]
+        n = len(rows)
+        if n == 0:
+            return
+        index = (self.head + np.arange(n)) % self.capacity
+        self.data[:, index] = rows.T
+        self.data[:, index + self.capacity] = rows.T
+        self.head = (self.head + n) % self.capacity
+        self.count = min(self.count + n, self.capacity)
+
+    def view(self):
+        """Amostras em ordem cronológica, sem cópia (colunas x count)"""
+        end = self.head + self.capacity
+        return self.data[:, end - self.count:end]
+
+
+def envelope(x, y, columns):
+    """Reduz uma série a 2 pontos (mínimo e máximo, pela ordem original) por
+    bloco: com um bloco a cada 2 pixels o traço é o mesmo à vista, mas o custo
+    do desenho deixa de crescer com o tamanho do histórico."""
+    chunk = len(y) // max(int(columns), 1)
+    if chunk < 3:
+        return x, y
+    # As amostras mais antigas que não enchem um bloco ficam de fora (< 1 pixel)
+    used = (len(y) // chunk) * chunk
+    xs = x[len(x) - used:].reshape(-1, chunk)
+    ys = y[len(y) - used:].reshape(-1, chunk)
+    low, high = ys.argmin(axis=1), ys.argmax(axis=1)
+    index = np.stack((np.minimum(low, high), np.maximum(low, high)), axis=1)
+    rows = np.arange(len(ys))[:, None]
+    return xs[rows, index].ravel(), ys[rows, index].ravel()
+
+
 class BatSignalMonitor:
-    def __init__(self, port='COM3', baudrate=115200, max_points=50):
+    def __init__(self, port='COM3', baudrate=115200, max_points=20000, render_hz=30, queue_size=4096):
         self.max_points = max_points
-        self.data_queue = queue.Queue()
+        self.render_interval = int(1000 / render_hz)
+        # Fila limitada entre a leitura e o render: se o render não acompanhar
+        # descartam-se os pontos mais antigos em vez de crescer sem limite
+        self.data_queue = queue.Queue(maxsize=queue_size)
+        self.queue_peak = 0
+        self.dropped_points = 0
+        self.bytes_read = 0
+        self.text_buffer = bytearray()
         self.serial_running = True
         self.start_time = None
         self.monitoring_started = False
         self.current_cycle_data = {}  # Armazena todos os dados do ciclo atual
         self.awaiting_cycle_completion = False
+
+        # Frames de telemetria (firmware com LOG_TELEMETRY=1): quando aparecem
+        # substituem o parse do texto, que fica só para leitura humana
+        self.splitter = FrameSplitter()
+        self.binary_mode = False
+        self.next_seq = None
+        self.lost_frames = 0
         
-        # Arrays para dados (apenas inteiros)
-        self.timestamps = deque(maxlen=max_points)
-        self.seconds = deque(maxlen=max_points)
-        self.temperature = deque(maxlen=max_points)
-        self.humidity = deque(maxlen=max_points)
-        self.accel_x = deque(maxlen=max_points)
-        self.accel_y = deque(maxlen=max_points)
-        self.accel_z = deque(maxlen=max_points)
+        # Histórico: a leitura só enfileira, o render drena em lote a cada tick
+        self.history = RingBuffer(max_points, 1 + len(CHANNELS))
+        self.last_values = dict.fromkeys(CHANNELS, 0)
+        self.background = None
+        self.readout_regions = []
+        self.readout_time = 0.0
+        self.x_limit = None
+
+        # Estatística de ingestão/render impressa periodicamente
+        self.points_total = 0
+        self.stats_points = 0
+        self.stats_renders = 0
+        self.stats_render_time = 0.0
+        self.stats_time = time.perf_counter()
         
         # Configurar tema dark moderno
         self.setup_dark_theme()
@@ -86,6 +175,9 @@ class BatSignalMonitor:
     
     def parse_stm32_line(self, line):
         """Extrai dados da linha da STM32"""
+        if self.binary_mode:
+            return None
+
         try:
             # Verifica se é o primeiro READ SENSORS
             if 'Current State -> 1 - READ SENSORS' in line and not self.monitoring_started:
@@ -142,33 +234,97 @@ class BatSignalMonitor:
             print(f"Erro no parse: {e} - Linha: {line}")
             return None
     
+    def parse_telemetry(self, payload):
+        """Frame binária de um DATA_READ: valores exatos com a hora do dispositivo"""
+        try:
+            record = decode_telemetry(payload)
+            year, month, day, hour, minute, second = record['time']
+            timestamp = datetime(year, month, day, hour, minute, second, record['ms'] * 1000)
+        except ValueError as e:
+            print(f"Frame de telemetria inválida: {e}")
+            return
+
+        if not self.binary_mode:
+            # O eixo do tempo passa a ser o do dispositivo
+            self.binary_mode = True
+            self.monitoring_started = True
+            self.start_time = timestamp
+            self.enqueue({'state': 'start_monitoring'})
+        elif record['seq'] != self.next_seq:
+            lost = (record['seq'] - self.next_seq) & 0xFFFF
+            self.lost_frames += lost
+            print(f"⚠️  {lost} frame(s) de telemetria perdida(s) antes do seq {record['seq']}")
+        self.next_seq = (record['seq'] + 1) & 0xFFFF
+
+        point = {key: record[key] for key in ('temperature', 'humidity', 'accel_x', 'accel_y', 'accel_z')}
+        point['timestamp'] = timestamp
+        self.enqueue(point)
+
+    def enqueue(self, item):
+        """Entrega um ponto ao render sem nunca bloquear a leitura da porta"""
+        while True:
+            try:
+                self.data_queue.put_nowait(item)
+                break
+            except queue.Full:
+                # Backpressure: perde-se o ponto mais antigo, não bytes da UART
+                try:
+                    self.data_queue.get_nowait()
+                    self.dropped_points += 1
+                except queue.Empty:
+                    pass
+        self.queue_peak = max(self.queue_peak, self.data_queue.qsize())
+
+    def feed_text(self, data):
+        """Junta o texto recebido e processa CADA LINHA completa individualmente"""
+        buffer = self.text_buffer
+        buffer += data
+        start = 0
+        while True:
+            end = buffer.find(b'\n', start)
+            if end < 0:
+                break
+            line = buffer[start:end].decode('utf-8', errors='ignore').strip()
+            start = end + 1
+
+            if line:
+                print(f"Linha recebida: {line}")
+                parsed_data = self.parse_stm32_line(line)
+                if parsed_data:
+                    # Envia APENAS UM PONTO COMPLETO por ciclo
+                    self.enqueue(parsed_data)
+                    print(f"✅ Ponto completo preparado: {parsed_data}")
+
+        # Um só corte por leitura em vez de um por linha
+        del buffer[:start]
+        if len(buffer) > MAX_LINE:
+            buffer.clear()
+
     def read_serial_data(self):
-        """Lê dados da STM32 LINHA A LINHA"""
+        """Lê dados da STM32: frames de telemetria e texto LINHA A LINHA.
+
+        A leitura bloqueia no driver até chegar um byte (ou expirar o timeout
+        da porta) e depois leva tudo o que já estiver no buffer: sem dados a
+        thread dorme em vez de ocupar um core a perguntar in_waiting."""
         if not self.ser:
             print("Porta serial não disponível.")
             return
-            
-        buffer = ""
+
         while self.serial_running:
             try:
-                if self.ser and self.ser.in_waiting:
-                    # Lê dados disponíveis
-                    data = self.ser.read(self.ser.in_waiting).decode('utf-8', errors='ignore')
-                    buffer += data
-                    
-                    # Processa CADA LINHA individualmente
-                    while '\n' in buffer:
-                        line, buffer = buffer.split('\n', 1)
-                        line = line.strip()
-                        
-                        if line:
-                            print(f"Linha recebida: {line}")
-                            parsed_data = self.parse_stm32_line(line)
-                            if parsed_data:
-                                # Envia APENAS UM PONTO COMPLETO por ciclo
-                                self.data_queue.put(parsed_data)
-                                print(f"✅ Ponto completo preparado: {parsed_data}")
-                                
+                data = self.ser.read(self.ser.in_waiting or 1)
+                if not data:
+                    continue
+                self.bytes_read += len(data)
+
+                # Separa as frames binárias do texto
+                for kind, item in self.splitter.feed(data):
+                    if kind == "frame":
+                        if item[0] == FRAME_TYPE_TELEMETRY:
+                            self.parse_telemetry(item)
+                    else:
+                        self.feed_text(item)
+
             except Exception as e:
                 print(f"Erro serial: {e}")
                 time.sleep(1)
@@ -198,9 +354,7 @@ class BatSignalMonitor:
         self.ax1.set_xlabel('Time (seconds)', color=self.colors['text_secondary'], fontsize=10)
         self.ax1.grid(True, color=self.colors['grid'], alpha=0.3, linestyle='--')
         self.line_temp, = self.ax1.plot([], [], color=self.colors['temp'], 
-                                       linewidth=3, marker='o', markersize=6,
-                                       markerfacecolor=self.colors['temp'],
-                                       markeredgecolor='white', markeredgewidth=1)
+                                       linewidth=2, animated=True)
         self.ax1.tick_params(colors=self.colors['text_secondary'])
         self.ax1.yaxis.set_major_locator(plt.MaxNLocator(integer=True))
         
@@ -210,7 +364,8 @@ class BatSignalMonitor:
                                       fontsize=12, fontweight='bold',
                                       bbox=dict(boxstyle="round,pad=0.3", 
                                               facecolor=self.colors['background'], 
-                                              alpha=0.8))
+                                              alpha=0.8),
+                                      animated=True)
         
         # Gráfico 2: Humidade - Design moderno
         self.ax2 = plt.subplot(2, 2, 2, facecolor=self.colors['card'])
@@ -220,9 +375,7 @@ class BatSignalMonitor:
         self.ax2.set_xlabel('Time (seconds)', color=self.colors['text_secondary'], fontsize=10)
         self.ax2.grid(True, color=self.colors['grid'], alpha=0.3, linestyle='--')
         self.line_hum, = self.ax2.plot([], [], color=self.colors['humidity'], 
-                                      linewidth=3, marker='s', markersize=6,
-                                      markerfacecolor=self.colors['humidity'],
-                                      markeredgecolor='white', markeredgewidth=1)
+                                      linewidth=2, animated=True)
         self.ax2.tick_params(colors=self.colors['text_secondary'])
         self.ax2.yaxis.set_major_locator(plt.MaxNLocator(integer=True))
         
@@ -232,7 +385,8 @@ class BatSignalMonitor:
                                      fontsize=12, fontweight='bold',
                                      bbox=dict(boxstyle="round,pad=0.3", 
                                              facecolor=self.colors['background'], 
-                                             alpha=0.8))
+                                             alpha=0.8),
+                                     animated=True)
         
         # Gráfico 3: Aceleração XYZ - Design moderno
         self.ax3 = plt.subplot(2, 1, 2, facecolor=self.colors['card'])
@@ -244,11 +398,11 @@ class BatSignalMonitor:
         
         # Linhas com cores modernas
         self.line_x, = self.ax3.plot([], [], color=self.colors['accel_x'], 
-                                    linewidth=2.5, label='X-Axis', alpha=0.9)
+                                    linewidth=1.5, label='X-Axis', alpha=0.9, animated=True)
         self.line_y, = self.ax3.plot([], [], color=self.colors['accel_y'], 
-                                    linewidth=2.5, label='Y-Axis', alpha=0.9)
+                                    linewidth=1.5, label='Y-Axis', alpha=0.9, animated=True)
         self.line_z, = self.ax3.plot([], [], color=self.colors['accel_z'], 
-                                    linewidth=2.5, label='Z-Axis', alpha=0.9)
+                                    linewidth=1.5, label='Z-Axis', alpha=0.9, animated=True)
         
         # Legenda moderna
         self.ax3.legend(loc='upper right', facecolor=self.colors['background'],
@@ -268,7 +422,16 @@ class BatSignalMonitor:
                                        fontsize=11, fontweight='bold',
                                        bbox=dict(boxstyle="round,pad=0.3", 
                                                facecolor=self.colors['background'], 
-                                               alpha=0.8))
+                                               alpha=0.8),
+                                       animated=True)
+
+        self.lines = (self.line_temp, self.line_hum, self.line_x, self.line_y, self.line_z)
+        self.readouts = (self.temp_text, self.hum_text, self.accel_text)
+        # (eixo, colunas do histórico) para o autoscale
+        self.axes_columns = ((self.ax1, slice(1, 2)), (self.ax2, slice(2, 3)), (self.ax3, slice(3, 6)))
+
+        # Cada redesenho completo recaptura o fundo usado no blit
+        self.fig.canvas.mpl_connect('draw_event', self.on_draw)
     
     def get_elapsed_seconds(self, timestamp):
         """Calcula segundos desde o início do monitoring"""
@@ -276,89 +439,140 @@ class BatSignalMonitor:
             return (timestamp - self.start_time).total_seconds()
         return 0
     
-    def update_plots(self, frame):
-        """Atualiza gráficos com dados da STM32 - UM PONTO POR CICLO"""
-        # Processa APENAS UM ponto completo por vez
-        if not self.data_queue.empty():
-            data = self.data_queue.get()
-            
+    def on_draw(self, event):
+        """Depois de um redesenho completo: guarda o fundo e desenha as linhas"""
+        self.background = self.fig.canvas.copy_from_bbox(self.fig.bbox)
+        for line in self.lines:
+            self.fig.draw_artist(line)
+        self.draw_readouts()
+
+    def draw_readouts(self):
+        """Desenha os valores atuais e guarda os seus pixels para os ticks seguintes"""
+        self.readout_regions = []
+        for text in self.readouts:
+            self.fig.draw_artist(text)
+            extent = text.get_bbox_patch().get_window_extent().padded(2)
+            self.readout_regions.append(self.fig.canvas.copy_from_bbox(extent))
+
+    def drain_queue(self):
+        """Retira TODOS os pontos pendentes da fila como um lote de linhas"""
+        rows = []
+        while True:
+            try:
+                data = self.data_queue.get_nowait()
+            except queue.Empty:
+                return rows
+
             # Verifica se é o sinal para iniciar monitoring
-            if 'state' in data and data['state'] == 'start_monitoring':
+            if data.get('state') == 'start_monitoring':
                 print("⏱️  Contador de tempo iniciado em 0!")
-                # Limpa dados anteriores se houver
-                self.timestamps.clear()
-                self.seconds.clear()
-                self.temperature.clear()
-                self.humidity.clear()
-                self.accel_x.clear()
-                self.accel_y.clear()
-                self.accel_z.clear()
+                # Descarta dados anteriores se houver
+                rows = []
+                self.history.clear()
+                self.x_limit = None
+                continue
+
+            # Usa o último valor se algum sensor não tiver dados neste ciclo
+            for key in CHANNELS:
+                if key in data:
+                    self.last_values[key] = data[key]
+            elapsed_seconds = self.get_elapsed_seconds(data.get('timestamp', datetime.now()))
+            rows.append([elapsed_seconds] + [self.last_values[key] for key in CHANNELS])
+
+    @staticmethod
+    def padded(low, high):
+        """Limites com margem de 10% (mínimo 1 unidade)"""
+        margin = max(high - low, 1.0) * 0.1
+        return low - margin, high + margin
+
+    def rescale(self, new):
+        """Autoscale incremental: só mexe nos limites quando os dados saem deles.
+
+        O eixo X avança aos saltos de 25% da janela e, nesse salto, o Y é
+        recalculado sobre todo o histórico (pode encolher); entre saltos o Y
+        só cresce e apenas as amostras novas são verificadas.
+        Devolve True se algum limite mudou (é preciso um redesenho completo)."""
+        data = self.history.view()
+        t_first, t_last = data[0, 0], data[0, -1]
+
+        if self.x_limit is None or t_last > self.x_limit[1]:
+            span = max(t_last - t_first, 10.0)
+            self.x_limit = (t_first, t_last + span * 0.25)
+            for ax, columns in self.axes_columns:
+                ax.set_xlim(*self.x_limit)
+                ax.set_ylim(*self.padded(data[columns].min(), data[columns].max()))
+            return True
+
+        changed = False
+        for ax, columns in self.axes_columns:
+            low, high = ax.get_ylim()
+            new_low, new_high = new[columns].min(), new[columns].max()
+            if new_low < low or new_high > high:
+                ax.set_ylim(*self.padded(min(new_low, data[columns].min()),
+                                         max(new_high, data[columns].max())))
+                changed = True
+        return changed
+
+    def render(self):
+        """Tick do render (render_hz): ingere o lote pendente e redesenha por blit"""
+        started = time.perf_counter()
+        rows = self.drain_queue()
+        if not rows:
+            return
+        self.history.extend(rows)
+        self.points_total += len(rows)
+        self.stats_points += len(rows)
+
+        seconds, temperature, humidity, accel_x, accel_y, accel_z = self.history.view()
+        columns = self.ax1.bbox.width / 2
+        self.line_temp.set_data(*envelope(seconds, temperature, columns))
+        self.line_hum.set_data(*envelope(seconds, humidity, columns))
+        columns = self.ax3.bbox.width / 2
+        self.line_x.set_data(*envelope(seconds, accel_x, columns))
+        self.line_y.set_data(*envelope(seconds, accel_y, columns))
+        self.line_z.set_data(*envelope(seconds, accel_z, columns))
+
+        refresh = started - self.readout_time >= READOUT_PERIOD
+        if refresh:
+            self.readout_time = started
+            self.temp_text.set_text(f'Current: {temperature[-1]:g}°C')
+            self.hum_text.set_text(f'Current: {humidity[-1]:g}%')
+            self.accel_text.set_text(f'X: {accel_x[-1]:g}  Y: {accel_y[-1]:g}  Z: {accel_z[-1]:g}')
+
+        canvas = self.fig.canvas
+        if self.rescale(np.asarray(rows).T) or self.background is None:
+            # Eixos mudaram: redesenho completo, on_draw recaptura o fundo
+            canvas.draw_idle()
+        else:
+            canvas.restore_region(self.background)
+            for line in self.lines:
+                self.fig.draw_artist(line)
+            if refresh:
+                self.draw_readouts()
             else:
-                # Adiciona APENAS UM PONTO com todos os dados do ciclo
-                self.update_arrays(data)
-                print(f"📊 Ponto adicionado | Total: {len(self.temperature)} | Tempo: {self.seconds[-1]:.1f}s")
-        
-        # Atualiza gráficos se tiver dados E monitoring iniciado
-        if self.monitoring_started and self.temperature:
-            # Usa SEGUNDOS no eixo X (começando em 0)
-            x_data = list(self.seconds)
-            
-            # Gráfico Temperatura
-            self.line_temp.set_data(x_data, list(self.temperature))
-            self.ax1.relim()
-            self.ax1.autoscale_view()
-            self.temp_text.set_text(f'Current: {self.temperature[-1]}°C')
-            
-            # Gráfico Humidade
-            self.line_hum.set_data(x_data, list(self.humidity))
-            self.ax2.relim()
-            self.ax2.autoscale_view()
-            self.hum_text.set_text(f'Current: {self.humidity[-1]}%')
-            
-            # Gráfico Aceleração
-            self.line_x.set_data(x_data, list(self.accel_x))
-            self.line_y.set_data(x_data, list(self.accel_y))
-            self.line_z.set_data(x_data, list(self.accel_z))
-            self.ax3.relim()
-            self.ax3.autoscale_view()
-            self.accel_text.set_text(f'X: {self.accel_x[-1]}  Y: {self.accel_y[-1]}  Z: {self.accel_z[-1]}')
-            
-            # Atualiza título principal
-            self.fig.suptitle(
-                'BAT-SIGNAL • REAL-TIME MONITORING PLATFORM',
-                fontsize=18,
-                fontweight='bold',
-                color=self.colors['text_primary'],
-                y=0.985,
-                fontfamily='monospace'
-            )
-        
-        # Atualiza título se ainda não começou
-        elif not self.monitoring_started:
-            self.fig.suptitle(
-                'BAT-SIGNAL • REAL-TIME MONITORING PLATFORM\n',
-                fontsize=18,
-                fontweight='bold',
-                color=self.colors['text_primary'],
-                y=0.985,
-                fontfamily='monospace'
-            )
-    
-    def update_arrays(self, data):
-        """Atualiza arrays com UM PONTO COMPLETO do ciclo"""
-        timestamp = data.get('timestamp', datetime.now())
-        elapsed_seconds = self.get_elapsed_seconds(timestamp)
-        
-        # Adiciona APENAS UM PONTO com todos os dados
-        self.timestamps.append(timestamp)
-        self.seconds.append(elapsed_seconds)
-        
-        # Usa valores padrão se algum sensor não tiver dados
-        self.temperature.append(data.get('temperature', self.temperature[-1] if self.temperature else 0))
-        self.humidity.append(data.get('humidity', self.humidity[-1] if self.humidity else 0))
-        self.accel_x.append(data.get('accel_x', self.accel_x[-1] if self.accel_x else 0))
-        self.accel_y.append(data.get('accel_y', self.accel_y[-1] if self.accel_y else 0))
-        self.accel_z.append(data.get('accel_z', self.accel_z[-1] if self.accel_z else 0))
+                for region in self.readout_regions:
+                    canvas.restore_region(region)
+            canvas.blit(self.fig.bbox)
+            canvas.flush_events()
+
+        self.stats_renders += 1
+        self.stats_render_time += time.perf_counter() - started
+        self.print_stats()
+
+    def print_stats(self):
+        """Uma linha de estado a cada ~2 s em vez de um print por ponto"""
+        elapsed = time.perf_counter() - self.stats_time
+        if elapsed < 2.0:
+            return
+        print(f"📊 Total: {self.points_total} pontos | {self.stats_points / elapsed:.0f} pontos/s | "
+              f"render {1000 * self.stats_render_time / self.stats_renders:.1f} ms | "
+              f"fila máx. {self.queue_peak}/{self.data_queue.maxsize} | descartados: {self.dropped_points} | "
+              f"frames perdidas: {self.lost_frames} | {self.bytes_read} bytes")
+        self.queue_peak = 0
+        self.stats_points = 0
+        self.stats_renders = 0
+        self.stats_render_time = 0.0
+        self.stats_time = time.perf_counter()
     
     def start(self):
         """Inicia a aplicação"""
@@ -367,16 +581,18 @@ class BatSignalMonitor:
         print("Porta: COM3 | Baudrate: 115200")
         print("📈 MODO: 1 PONTO POR CICLO DE LEITURA")
         print("⏱️  Tempo começará em 0 no primeiro READ SENSORS")
+        print("🔢 Firmware com LOG_TELEMETRY=1: valores exatos pelas frames binárias")
+        print(f"🖼️  Render a {1000 // self.render_interval} Hz | histórico de {self.max_points} pontos")
         print("=" * 65)
         
         # Thread para ler dados
         data_thread = threading.Thread(target=self.read_serial_data, daemon=True)
         data_thread.start()
         
-        # Animação dos gráficos
-        ani = animation.FuncAnimation(
-            self.fig, self.update_plots, interval=100, cache_frame_data=False
-        )
+        # Render desacoplado da leitura: timer do próprio canvas + blit
+        self.timer = self.fig.canvas.new_timer(interval=self.render_interval)
+        self.timer.add_callback(self.render)
+        self.timer.start()
         
         try:
             plt.show()
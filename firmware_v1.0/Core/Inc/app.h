@@ -12,32 +12,72 @@
 //#include "system.h"
 #include "sensors.h"
 #include "logger.h"
+#include "uplink.h"
+#include "stats.h"
+#include "vibration.h"
+#include "capture.h"
 
 // ----- Thresholds define --------
-#define TEMP_HIGH_ALERT_VAL 35.00
-#define HUM_HIGH_ALERT_VAL  79.00
+#define TEMP_HIGH_ALERT_VAL 35
+#define HUM_HIGH_ALERT_VAL  79
+#define VIB_HIGH_ALERT_VAL  250		// mg RMS, any axis
 
 // ----- App timing define --------
 #define APP_DELAY 5000
 #define DEBOUNCE_DELAY 100
+// EEPROM sensor snapshot period: each word of the MEM_SLOTS ring is
+// rewritten every MEM_SLOTS periods -> 100k cycles last decades
+#define MEM_SENSOR_PERIOD_MS (MEM_SERIES_STEP * 1000UL)
 
 // ----- GPIO define --------
 #define USER_BTN GPIO_PIN_12
 #define INT_HDC2080_PIN GPIO_PIN_11
+#define INT_ADXL343_PIN GPIO_PIN_5
 
 #define USER_LED_PIN GPIO_PIN_3
 #define SYS_LED_PIN GPIO_PIN_2
 
 #define ALARM_PWM_PIN GPIO_PIN_8
 
+// ----- FSM define --------
+#define FSM_ANY 0xFF				// transition source: any state, taken on interrupt events
+#define BUTTON_ANY 0				// on_button() arg: any number of presses
+
 // --------------------------------
-enum states{IDLE, DATA_READ, COMMS, ANOMALY, RECONNECT, LOGS, CLEAN_MEM};
+enum states{IDLE, DATA_READ, COMMS, ANOMALY, RECONNECT, LOGS, CLEAN_MEM, SHOCK, STATE_COUNT};
+
+typedef uint8_t (*fsm_action)();
+typedef bool (*fsm_guard)(uint8_t arg);
+
+// One state: run() once per step, on_entry() only when the state changes
+typedef struct{
+	fsm_action run;
+	void (*on_entry)();		// may be NULL
+}fsm_state;
+
+// from -> to when guard(arg) holds (NULL guard = always)
+typedef struct{
+	uint8_t from;		// enum states or FSM_ANY
+	fsm_guard guard;
+	uint8_t arg;
+	uint8_t to;
+}fsm_transition;
+
+typedef struct{
+	uint32_t entries;		// transitions into the state from another one
+	uint32_t runs;
+	uint64_t run_us;		// total time in run()
+	uint32_t max_run_us;	// worst case
+}fsm_state_stats;
 
 // CONFIG
 uint8_t init_device();
 
 // APPLICATION
 void app_fsm();
+void app_wait(uint32_t ms);
+fsm_state_stats get_fsm_stats(uint8_t state);
+channel_stats get_sensor_stats(uint8_t channel);
 uint8_t state_idle();
 uint8_t state_read_sensors();
 uint8_t state_comms();
@@ -45,6 +85,7 @@ uint8_t state_anomaly();
 uint8_t state_reconnect();
 uint8_t state_print_logs();
 uint8_t state_clean_memory();
+uint8_t state_shock();
 
 // ERROR
 void error_handler(uint8_t error_code);
@@ -0,0 +1,54 @@
+/*
+ * capture.h
+ *
+ *  Black-box capture of the ADXL343 stream around a shock. Every FIFO entry
+ *  goes into a ring of the last CAPTURE_PRE samples; an INT_SOURCE with one
+ *  of the CAPTURE_TRIGGER_INTS freezes that ring and the CAPTURE_POST
+ *  samples that follow into one window, handed to the FSM once complete and
+ *  stored as a single MEM_CAPTURE record:
+ *
+ *    peak       largest |a| of the window, CAPTURE_MG_STEP units
+ *    peak_at    samples from the trigger to the peak (negative: before it)
+ *    disturbed  samples off CAPTURE_REST_MG by CAPTURE_DISTURBED_MG or more
+ *
+ *  Everything up to the trigger is already in RAM (the INT1 collector
+ *  drains the FIFO before it reads the sources), so nothing waits on it.
+ *  One window at a time: triggers while one is open or not taken yet are
+ *  left to the MEM_EVENT_SHOCK record alone. Only ADXL343_EVENT_MODE feeds it.
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: dst2001055
+ */
+
+#ifndef INC_CAPTURE_H_
+#define INC_CAPTURE_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define CAPTURE_PRE 8				// samples before the trigger: 160 ms at 50 Hz
+#define CAPTURE_POST 16				// samples from the trigger on: 320 ms
+#define CAPTURE_SAMPLES (CAPTURE_PRE + CAPTURE_POST)
+#define CAPTURE_SAMPLE_MS 20		// 50 Hz ODR (ACCEL_BW_RATE)
+#define CAPTURE_MG_STEP 32			// |a| resolution, 8160 mg full scale
+#define CAPTURE_REST_MG 1000		// |a| at rest, 1 g
+#define CAPTURE_DISTURBED_MG 500	// |a| this far from rest: the box is moving (free fall included)
+
+// | ADXL343_INT_ACTIVITY captures every motion start as well, at one EEPROM record each
+#define CAPTURE_TRIGGER_INTS (ADXL343_INT_SINGLE_TAP | ADXL343_INT_FREE_FALL)
+
+typedef struct{
+	uint32_t tick;			// HAL_GetTick() at the trigger
+	uint8_t source;			// INT_SOURCE bits of the trigger
+	uint8_t peak;			// CAPTURE_MG_STEP units
+	int8_t peak_at;			// samples from the trigger
+	uint8_t disturbed;		// samples
+}capture_window;
+
+void capture_reset();
+void capture_add(const int16_t raw[3]);
+bool capture_trigger(uint8_t source);
+bool capture_collecting();
+bool capture_take(capture_window *window);
+
+#endif /* INC_CAPTURE_H_ */
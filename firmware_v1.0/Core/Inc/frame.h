@@ -0,0 +1,41 @@
+/*
+ * frame.h
+ *
+ *  Binary frames on the serial links: CRC-16/CCITT-FALSE appended to the
+ *  payload, COBS encoded and wrapped in 0x00 delimiters, so frames can be
+ *  interleaved with plain text and the receiver resyncs on the next 0x00.
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: dst2001055
+ */
+
+#ifndef INC_FRAME_H_
+#define INC_FRAME_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define FRAME_DELIM 0x00
+
+// First payload byte
+#define FRAME_TYPE_LOG 0x01
+#define FRAME_TYPE_UPLINK 0x02
+#define FRAME_TYPE_TELEMETRY 0x03
+
+#define FRAME_CRC_SIZE 2
+#define FRAME_MAX_PAYLOAD 64
+// COBS adds one byte per 254 + delimiters at both ends
+#define FRAME_ENCODED_SIZE(payload) ((payload) + FRAME_CRC_SIZE + ((payload) + FRAME_CRC_SIZE) / 254 + 1 + 2)
+#define FRAME_MAX_ENCODED FRAME_ENCODED_SIZE(FRAME_MAX_PAYLOAD)
+
+#define VARINT_MAX_SIZE 5
+
+uint16_t crc16_ccitt(const uint8_t *data, uint16_t len, uint16_t crc);
+uint16_t encode_frame(uint8_t *payload, uint16_t len, uint8_t *out, uint16_t out_size);
+
+uint8_t put_varint(uint8_t *buf, uint32_t value);
+bool get_varint(const uint8_t *buf, uint16_t len, uint16_t *pos, uint32_t *value);
+uint32_t zigzag_encode(int32_t value);
+int32_t zigzag_decode(uint32_t value);
+
+#endif /* INC_FRAME_H_ */
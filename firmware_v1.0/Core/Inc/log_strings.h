@@ -0,0 +1,64 @@
+/*
+ * log_strings.h
+ *
+ *  Every message the firmware logs, as X(ID, format) entries. The IDs are
+ *  the enum log_string_id values, in order, and are what a deferred log
+ *  record carries instead of the text. BAT_Decoder.py parses this file, so
+ *  keep one entry per line and only append: reordering changes the IDs of
+ *  records already in the field.
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: dst2001055
+ */
+
+#ifndef INC_LOG_STRINGS_H_
+#define INC_LOG_STRINGS_H_
+
+#define LOG_STRING_TABLE(X) \
+	X(LOG_STARTUP,        "------------ BAT-MON v1 startup ------------") \
+	X(LOG_STATE_IDLE,     "Current State -> %d - IDLE") \
+	X(LOG_STATE_READ,     "Current State -> %d - READ SENSORS") \
+	X(LOG_STATE_COMMS,    "Current State -> %d - COMMS") \
+	X(LOG_STATE_ANOMALY,  "Current State -> %d - ANOMALY") \
+	X(LOG_TEMPERATURE,    "Current Temperature ----> %u C") \
+	X(LOG_HUMIDITY,       "Current Humidity -------> %u %%") \
+	X(LOG_ACCEL_X,        "Current X Acceleration -> %d mg") \
+	X(LOG_ACCEL_Y,        "Current Y Acceleration -> %d mg") \
+	X(LOG_ACCEL_Z,        "Current Z Acceleration -> %d mg") \
+	X(LOG_VALUES_OK,      "Sensor Values Inside Defined Margin!") \
+	X(LOG_TEMP_THRESHOLD, "Temperature Threshold!") \
+	X(LOG_HUM_THRESHOLD,  "Humidity Threshold!") \
+	X(LOG_MEM_COUNT,      "EEPROM: %u of %u records") \
+	X(LOG_MEM_DATE,       "Record %u - %02u/%02u/%u") \
+	X(LOG_MEM_SENSOR,     "  %02u:%02u -> %d C %u %%") \
+	X(LOG_MEM_EVENT,      "  %02u:%02u -> alert %u, value %d") \
+	X(LOG_MEM_RANGE,      "Stored range: %d..%d C, %u..%u %%") \
+	X(LOG_MEM_ERROR,      "EEPROM record %u unreadable") \
+	X(LOG_MEM_WIPED,      "EEPROM wiped, %u records cleared") \
+	X(LOG_STATS_COUNT,    "Since start-up: %u readings") \
+	X(LOG_STATS_TEMP,     "Temperature: mean %d, sd %u (0.01 C)") \
+	X(LOG_STATS_HUM,      "Humidity: mean %u, sd %u (0.01 %%)") \
+	X(LOG_STATS_ACCEL,    "%c Acceleration: mean %d, sd %u mg") \
+	X(LOG_STATS_MIN,      "  min %d on %02u/%02u %02u:%02u") \
+	X(LOG_STATS_MAX,      "  max %d on %02u/%02u %02u:%02u") \
+	X(LOG_VIB_RMS,        "Vibration rms: X %u Y %u Z %u mg") \
+	X(LOG_VIB_PEAK,       "Vibration peak: p-p %u mg, crest %u.%02u") \
+	X(LOG_VIB_BANDS,      "Vibration bands: %u %u %u %u mg (3/6/11/19 Hz)") \
+	X(LOG_VIB_THRESHOLD,  "Vibration Threshold!") \
+	X(LOG_STATE_SHOCK,    "Current State -> %d - SHOCK") \
+	X(LOG_SHOCK,          "Shock detected!") \
+	X(LOG_FREE_FALL,      "Free fall detected!") \
+	X(LOG_ACCEL_MOVING,   "Motion started") \
+	X(LOG_ACCEL_PARKED,   "Parked: accelerometer watermark off") \
+	X(LOG_MEM_CAPTURE,    "  %02u:%02u -> shock 0x%02X, peak %u mg") \
+	X(LOG_MEM_CAPTURE_AT, "    peak at %d ms, %u ms off rest") \
+	X(LOG_MEM_STEPS,      "  rounded to %u.%02u C, %u.%02u %% steps")
+
+#define LOG_STRING_ID(id, fmt) id,
+
+enum log_string_id{
+	LOG_STRING_TABLE(LOG_STRING_ID)
+	LOG_STRING_COUNT
+};
+
+#endif /* INC_LOG_STRINGS_H_ */
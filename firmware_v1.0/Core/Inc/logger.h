@@ -9,6 +9,21 @@
 #define INC_LOGGER_H_
 
 #include "mal.h"
+#include "frame.h"
+#include "log_strings.h"
+
+// 1 -> log records leave the UART as binary frames (string ID, packed
+// timestamp, raw arguments) and BAT_Decoder.py rebuilds the text on the host
+// 0 -> log_write() formats the text on the device
+#ifndef LOG_DEFERRED
+#define LOG_DEFERRED 0
+#endif
+
+// 1 -> every DATA_READ result also leaves the debug UART as one binary frame
+// with the exact values, for BAT_Signal.py. The text lines stay as they are
+#ifndef LOG_TELEMETRY
+#define LOG_TELEMETRY 0
+#endif
 
 #define ERROR_LOG	0
 #define INFO_LOG	1
@@ -20,6 +35,26 @@
 
 #define RESET_COLOR "\033[1;0m"
 
+#define LOG_MAX_ARGS 5
+#define LOG_RECORD_SIZE (1 + 1 + VARINT_MAX_SIZE + 4 + 2 + LOG_MAX_ARGS * VARINT_MAX_SIZE)
+
+#define TELEMETRY_FLAG_TEMP 0x01	// over TEMP_HIGH_ALERT_VAL
+#define TELEMETRY_FLAG_HUM 0x02		// over HUM_HIGH_ALERT_VAL
+#define TELEMETRY_FLAG_VIB 0x04		// vibration RMS over VIB_HIGH_ALERT_VAL
+#define TELEMETRY_FLAG_SHOCK 0x08	// ADXL343 shock / free fall since the last reading
+#define TELEMETRY_RECORD_SIZE (1 + 2 + 1 + 4 + 2 + 5 * VARINT_MAX_SIZE)
+
+// Argument count of a LOG_WRITE() call, 0 to LOG_MAX_ARGS
+#define LOG_NARGS(...) LOG_NARGS_(0, ##__VA_ARGS__, 5, 4, 3, 2, 1, 0)
+#define LOG_NARGS_(_0, _1, _2, _3, _4, _5, N, ...) N
+
+// Log by string ID: LOG_WRITE(INFO_LOG, LOG_TEMPERATURE, temp)
+#if LOG_DEFERRED
+#define LOG_WRITE(log_type, id, ...) log_record((log_type), (id), LOG_NARGS(__VA_ARGS__), ##__VA_ARGS__)
+#else
+#define LOG_WRITE(log_type, id, ...) log_write((log_type), log_strings[(id)], ##__VA_ARGS__)
+#endif
+
 
 typedef struct{
     uint8_t ID;
@@ -27,6 +62,14 @@ typedef struct{
     const char* code;
 }color;
 
+// One DATA_READ result
+typedef struct{
+	int16_t temp;			// centi-degC
+	uint16_t hum;			// centi-%RH
+	int16_t accel[3];		// mg, X Y Z
+	uint8_t flags;			// TELEMETRY_FLAG_*
+}telemetry_record;
+
 typedef struct{
 	uint8_t log_num;
 	const char* name_type;
@@ -36,6 +79,12 @@ typedef struct{
 extern const color reg_colors[8];
 extern const log_struct log_list[8];
 
+#if !LOG_DEFERRED
+extern const char* const log_strings[LOG_STRING_COUNT];
+#endif
+
 uint8_t log_write(uint8_t log_type, const char* log_msg, ...);
+uint8_t log_record(uint8_t log_type, uint16_t id, uint8_t nargs, ...);
+uint8_t log_telemetry(const telemetry_record *reading);
 
 #endif /* INC_LOGGER_H_ */
@@ -18,6 +18,7 @@
 #include "gpio.h"
 #include "tim.h"
 #include "i2c.h"
+#include "series.h"
 
 //------------------------------- SYSTEM DEFINE -----------------------------
 
@@ -25,14 +26,26 @@
 #define HDC2080_ADDR (0x40 << 1)
 #define ADXL343_ADDR (0x53 << 1)
 
+#define I2C_QUEUE_LEN 4				// pending jobs, must be a power of two
+#define I2C_LATENCY_BINS 8
+#define I2C_LATENCY_BASE_US 128		// upper edge of bin 0, doubles per bin
+#define I2C_SEQUENCE_MAX 16			// register writes chained by write_i2c_sequence() (ADXL343 event mode)
+
+#define EVENT_QUEUE_LEN 8			// ISR -> FSM events, must be a power of two
+
 #define DEBUG_UART_NUM 1
 #define DEBUG_UART &hlpuart1
 
+#define UART_TX_BUF_SIZE 1024		// must be a power of two, holds a whole DATA_READ burst (~800 B)
+#define UART_TX_RESERVE 48			// kept free for send_UART_priority() (telemetry frames)
+#define UART_TX_FLUSH_MS 100
+
 #define COMMS_UART_NUM 2
 #define COMMS_UART &huart2
 
 #define RTC_RETURN_ERR 99
 #define YEAR_COEF 2000
+#define TIME_CACHE_MAX_AGE_MS 60000	// re-read the RTC at least this often (tick drift)
 
 #define BUTTON_TIMER_NUM 2
 #define BUTTON_TIMER &htim21
@@ -45,6 +58,17 @@
 
 #define ERROR_DELAY_MS 1000
 
+#define RTC_WAKEUP_HZ 2048			// LSE / 16 (RTC_WAKEUPCLOCK_RTCCLK_DIV16)
+#define STOP_MAX_MS 30000			// 16-bit wake-up counter -> 32 s at RTC_WAKEUP_HZ
+#define STOP_MIN_MS 5				// shorter waits stay in sleep (WFI) with SysTick running
+
+#define MEM_RECORD_SIZE 12			// three data EEPROM words, see mem_record
+#define MEM_SLOTS ((DATA_EEPROM_END - DATA_EEPROM_BASE + 1) / MEM_RECORD_SIZE)
+#define MEM_SERIES_CHUNK 8			// series bytes per record
+#define MEM_SERIES_BLOCK (8 * MEM_SERIES_CHUNK)		// one anchor record, the rest continue from the block before
+#define MEM_SERIES_CHANNELS 2		// SERIES_TEMP, SERIES_HUM
+#define MEM_SERIES_STEP (15 * 60)	// s, nominal time step of the series (MEM_SENSOR_PERIOD_MS)
+
 //---------------------------------------------------------
 
 enum errorTypes{
@@ -61,7 +85,8 @@ enum errorTypes{
 	GPIO_LED_ERROR,
 	CONFIG_BUZZ_ERROR,
 	GPIO_BUZZ_ERROR,
-	PWR_MANAGE_ERROR
+	PWR_MANAGE_ERROR,
+	EEPROM_ERROR
 };
 
 enum wireless_module_mode{
@@ -71,7 +96,48 @@ enum wireless_module_mode{
 
 enum i2c_sensors{
 	HDC2080,	// TEMP + HUM
-	ADXL343		// ACCEL
+	ADXL343,	// ACCEL
+	I2C_DEV_COUNT
+};
+
+enum i2c_ops{
+	I2C_OP_WRITE,
+	I2C_OP_READ,
+	I2C_OP_REG_WRITE,		// reg + data, registers auto-increment
+	I2C_OP_REG_READ			// reg, repeated START, data
+};
+
+// NVIC priority of every IRQ that calls post_event() (EXTI4_15, I2C1, TIM21).
+// The queue takes no lock because these cannot preempt each other: change
+// one in CubeMX and the rest must follow (batmon_bench checks them)
+#define EVENT_IRQ_PRIORITY 0
+
+// Posted from interrupts and serve_sensors(), served by app_fsm() and app_wait()
+enum event_types{
+	EVENT_TH_THRESHOLD,		// HDC2080 TH/HH seen by the DRDY collector, value = INT_DRDY
+	EVENT_SENSOR_INT,		// HDC2080 INT line (trigger mode), source not read yet
+	EVENT_BUTTON,			// USER_BTN gesture ended, value = presses
+	EVENT_ACCEL_SHOCK,		// ADXL343 single tap / free fall, value = INT_SOURCE bits
+	EVENT_SENSOR_DATA,		// sensor I2C job done, serve_sensors() takes it from there
+	EVENT_TYPE_COUNT
+};
+
+// Erased data EEPROM reads 0 -> MEM_EMPTY
+enum mem_record_types{
+	MEM_EMPTY,
+	MEM_SENSOR,			// single snapshot, superseded by MEM_SERIES_*
+	MEM_EVENT,
+	MEM_SERIES_START,	// series block anchor
+	MEM_SERIES,			// next chunk of the same block, decodes on its own
+	MEM_CAPTURE,		// shock with its capture summary, see capture.h
+	MEM_WIPED			// wipe_memory() marker: nothing older is valid, never read back
+};
+
+enum mem_events{
+	MEM_EVENT_TEMP_ALERT,		// value = centi-degC
+	MEM_EVENT_HUM_ALERT,		// value = centi-%RH
+	MEM_EVENT_VIB_ALERT,		// value = mg RMS, largest axis
+	MEM_EVENT_SHOCK				// arg = ADXL343 INT_SOURCE bits, no capture (else MEM_CAPTURE)
 };
 
 enum led_number{
@@ -92,6 +158,89 @@ enum power_modes{
 
 //---------------------------------------------------------
 
+typedef struct{
+	uint32_t bytes_queued;
+	uint32_t bytes_dropped;		// whole messages are dropped when the ring is full
+	uint32_t messages_dropped;	// each one returned DEBUG_UART_ERROR
+	uint32_t dma_transfers;
+	uint16_t high_water;
+}uart_tx_stats;
+
+// One bus transaction: START + address + [reg] + data + STOP
+typedef struct{
+	uint8_t device;		// enum i2c_sensors
+	uint8_t op;			// enum i2c_ops
+	uint8_t reg;		// I2C_OP_REG_* only
+	uint8_t *data;
+	uint16_t len;
+}i2c_xfer;
+
+typedef struct{
+	uint8_t reg;
+	uint8_t value;
+}i2c_reg_write;
+
+typedef void (*i2c_job_done)(uint8_t error, void *ctx);
+
+// Transfers run back-to-back in order, the first error ends the job.
+// job and xfers must stay valid until done() is called
+typedef struct{
+	const i2c_xfer *xfers;
+	uint8_t count;
+	i2c_job_done done;		// from the I2C interrupt, may be NULL
+	void *ctx;
+}i2c_job;
+
+typedef struct{
+	uint32_t transactions;
+	uint32_t errors;
+	uint32_t bytes;
+	uint32_t latency[I2C_LATENCY_BINS];	// bin n: < I2C_LATENCY_BASE_US << n, last bin open
+}i2c_dev_stats;
+
+typedef struct{
+	uint8_t type;			// enum event_types
+	uint8_t value;
+	uint32_t tick;			// HAL_GetTick() when posted
+}app_event;
+
+typedef struct{
+	uint32_t posted;
+	uint32_t dropped;		// queue full
+	uint32_t max_latency_ms;	// post -> pop
+	uint8_t high_water;
+}event_queue_stats;
+
+// One slot of the EEPROM record store. Little endian words, header last
+typedef struct{
+	uint16_t seq;			// +1 per record, finds head/tail at boot
+	uint8_t type;			// enum mem_record_types
+	uint8_t check;			// CRC-16 low byte over the other 11 bytes
+	union{
+		struct{
+			uint32_t timestamp;		// pack_timestamp()
+			union{
+				struct{
+					int16_t temp;		// centi-degC
+					uint16_t hum;		// centi-%RH
+				}sensor;
+				struct{
+					uint8_t code;		// enum mem_events
+					uint8_t arg;
+					int16_t value;
+				}event;
+				struct{
+					uint8_t source;		// ADXL343 INT_SOURCE bits of the trigger
+					uint8_t peak;		// CAPTURE_MG_STEP units
+					int8_t peak_at;		// samples from the trigger
+					uint8_t disturbed;	// samples away from rest
+				}capture;
+			};
+		};
+		uint8_t chunk[MEM_SERIES_CHUNK];	// MEM_SERIES_START / MEM_SERIES
+	};
+}mem_record;
+
 typedef struct{
 	uint8_t hour;
 	uint8_t minute;
@@ -105,10 +254,25 @@ typedef struct{
 
 //---------------------- SYSTEM -------------------------------
 void wait_delay(uint32_t ms);
+void idle_delay(uint32_t ms);
+uint32_t get_tick_us();
+
+//---------------------- EVENTS -------------------------------
+bool post_event(uint8_t type, uint8_t value);
+bool pop_event(app_event *event);
+bool event_pending(uint8_t type);
+event_queue_stats get_event_stats();
 
 //---------------------- COMMS -------------------------------
 	// USER DEBUG
 uint8_t send_UART_msg(uint8_t uart, const char* msg);
+uint8_t send_UART_data(uint8_t uart, const uint8_t *data, uint16_t len);
+uint8_t send_UART_priority(const uint8_t *data, uint16_t len);
+uint8_t flush_UART_tx(uint32_t timeout_ms);
+void UART_tx_complete(UART_HandleTypeDef *huart);
+uart_tx_stats get_UART_tx_stats();
+bool comms_UART_busy();
+uint8_t wait_comms_UART(uint32_t timeout_ms);
 
 	// BLE COMMS
 uint8_t config_ble_comms(uint8_t mode);
@@ -123,21 +287,38 @@ uint8_t stop_timer(TIM_HandleTypeDef *timer);
 //---------------------- RTC ---------------------------------
 uint8_t config_rtc(rtc_calendar date_time);
 rtc_calendar get_sys_time();
+uint8_t latch_sys_time();
+rtc_calendar get_cached_time(uint16_t *ms);
+uint32_t get_timestamp(uint16_t *ms);
+uint32_t pack_timestamp(rtc_calendar date_time);
+rtc_calendar unpack_timestamp(uint32_t packed);
+uint32_t calendar_to_seconds(rtc_calendar date_time);
+rtc_calendar seconds_to_calendar(uint32_t seconds);
 
 //---------------------- SENSORS ----------------------
 uint8_t read_i2c_sensor(uint16_t addr, uint8_t *pData, uint16_t size);
 uint8_t write_i2c_sensor(uint16_t addr, uint8_t *pData, uint16_t size);
+uint8_t read_i2c_register(uint16_t addr, uint8_t reg, uint8_t *pData, uint16_t size);
+uint8_t write_i2c_registers(uint16_t addr, uint8_t reg, uint8_t *pData, uint16_t size);
+uint8_t write_i2c_sequence(uint16_t addr, const i2c_reg_write *seq, uint8_t count);
+uint8_t submit_i2c_job(i2c_job *job);
+uint8_t run_i2c_xfers(const i2c_xfer *xfers, uint8_t count);
+void I2C_xfer_complete(I2C_HandleTypeDef *hi2c, uint8_t error);
+i2c_dev_stats get_i2c_stats(uint8_t device);
 
 //---------------------- POWER -------------------------------
-// uint8_t power_manage(uint8_t power_mode);
+uint8_t power_manage(uint8_t power_mode);
 	//MODE -> Stop Mode c/ RTC	|	Normal Mode
+uint8_t enter_stop_mode(uint32_t sleep_ms);
 
 //---------------------- EEPROM ------------------------------
-
-// Memory read and write
-// uint8_t mem_read(addr, data, size);
-// uint8_t mem_write(addr, data, size);
-// wipe_mem();
+uint8_t config_mem();
+uint8_t mem_write(mem_record *record);
+uint8_t mem_read(uint16_t index, mem_record *record);
+uint16_t mem_count();
+uint8_t wipe_memory();
+uint8_t mem_store_sample(const series_sample *sample);
+uint16_t mem_series_pending(uint8_t *block, uint16_t *start_seq, bool *start_stored);
 
 //---------------------- INTERFACEs --------------------------
 //uint8_t config_buzzer(uint16_t autoreload, uint16_t prescaler, uint16_t pulse);
@@ -10,6 +10,29 @@
 
 #include "mal.h"
 
+// 1 -> HDC2080 auto measurement (AMM) at 1 Hz, results collected on DRDY
+// 0 -> trigger + SENSOR_DELAY_MS wait for every sample
+#ifndef HDC2080_AMM_MODE
+#define HDC2080_AMM_MODE 1
+#endif
+
+// 1 -> ADXL343 FIFO in stream mode at ACCEL_BW_RATE, drained on the watermark (INT1)
+// 0 -> SAMPLE_SIZE snapshots ACCEL_DELAY_MS apart on every read
+#ifndef ADXL343_FIFO_MODE
+#define ADXL343_FIFO_MODE 1
+#endif
+
+// 1 -> activity/inactivity (linked), shock (single tap) and free fall on INT1 too.
+//      The watermark is only enabled while in motion: a parked unit is not woken
+// 0 -> watermark only
+#ifndef ADXL343_EVENT_MODE
+#define ADXL343_EVENT_MODE ADXL343_FIFO_MODE
+#endif
+
+#if ADXL343_EVENT_MODE && !ADXL343_FIFO_MODE
+#error "ADXL343_EVENT_MODE shares INT1 with the FIFO collector, it needs ADXL343_FIFO_MODE"
+#endif
+
 #define SAMPLE_SIZE 5
 #define SENSOR_DELAY_MS 50
 #define ACCEL_DELAY_MS 10
@@ -26,35 +49,114 @@
 
 #define TEMP_INT_BIT 6
 #define HUM_INT_BIT 4
+#define DRDY_INT_BIT 7
+
+#define HDC2080_DRDY_READ_SIZE 5	// TEMP L/H, HUM L/H, INT_DRDY (read clears it)
+
+#define HDC2080_REG_TEMP_LOW    0x00
+#define HDC2080_REG_INT_DRDY    0x04
+#define HDC2080_REG_INT_CONFIG  0x07
+#define HDC2080_REG_TEMP_MAX    0x0B
+#define HDC2080_REG_HUM_MAX     0x0D
+#define HDC2080_REG_RESET_DRDY  0x0E
+#define HDC2080_REG_MEASURE     0x0F
 
 #define ADXL343_REG_DEVID       0x00
+#define ADXL343_REG_THRESH_TAP  0x1D
+#define ADXL343_REG_DUR         0x21
+#define ADXL343_REG_THRESH_ACT  0x24
+#define ADXL343_REG_THRESH_INACT 0x25
+#define ADXL343_REG_TIME_INACT  0x26
+#define ADXL343_REG_ACT_INACT_CTL 0x27
+#define ADXL343_REG_THRESH_FF   0x28
+#define ADXL343_REG_TIME_FF     0x29
+#define ADXL343_REG_TAP_AXES    0x2A
+#define ADXL343_REG_ACT_TAP_STATUS 0x2B
+#define ADXL343_REG_BW_RATE     0x2C
 #define ADXL343_REG_POWER_CTL   0x2D
+#define ADXL343_REG_INT_ENABLE  0x2E
+#define ADXL343_REG_INT_MAP     0x2F
+#define ADXL343_REG_INT_SOURCE  0x30
 #define ADXL343_REG_DATA_FORMAT 0x31
 #define ADXL343_REG_DATAX0      0x32
-
-#define ACCEL_SENSE 0.004f // 256 LSB/g -> full resolution
-#define ACCEL_MG_FACTOR 1000
+#define ADXL343_REG_FIFO_CTL    0x38
+#define ADXL343_REG_FIFO_STATUS 0x39
+
+#define ACCEL_BW_RATE 0x09			// 50 Hz ODR
+#define ACCEL_FIFO_DEPTH 32
+#define ACCEL_FIFO_WATERMARK 16		// INT1 every 320 ms, 16 entries of headroom
+#define ACCEL_SAMPLE_BYTES 6		// X0..Z1, one FIFO entry per read
+
+#define ACCEL_MG_PER_LSB 4 // 256 LSB/g -> full resolution (0.004 g)
+
+// INT_ENABLE / INT_SOURCE bits
+#define ADXL343_INT_SINGLE_TAP  0x40
+#define ADXL343_INT_ACTIVITY    0x10
+#define ADXL343_INT_INACTIVITY  0x08
+#define ADXL343_INT_FREE_FALL   0x04
+#define ADXL343_INT_WATERMARK   0x02
+
+#define ADXL343_POWER_LINK      0x20
+#define ADXL343_POWER_MEASURE   0x08
+
+// Event mode thresholds. Activity and inactivity are ac-coupled (gravity out),
+// shock and free fall compare the raw axes
+#define ACCEL_ACT_MG 250			// motion starts
+#define ACCEL_INACT_MG 125			// ...and ends once every axis stays under this
+#define ACCEL_INACT_S 30			// for this long
+#define ACCEL_SHOCK_MG 3000			// single tap above this...
+#define ACCEL_SHOCK_MS 20			// ...for no longer than this
+#define ACCEL_FF_MG 438				// free fall: every axis under this...
+#define ACCEL_FF_MS 100				// ...for this long, about a 5 cm drop
+
+#define ACCEL_THRESH_CODE(mg) (((mg) * 2 + 62) / 125)	// 62.5 mg/LSB
+#define ACCEL_DUR_CODE(ms) (((ms) * 1000UL + 312) / 625)	// 625 us/LSB
+#define ACCEL_FF_TIME_CODE(ms) (((ms) + 2) / 5)			// 5 ms/LSB
+#define ACCEL_MAX_SAMPLES (0xFFFF - ACCEL_FIFO_DEPTH) // keeps the mg sums inside int32_t
+
+// Fixed point: temperature in centi-degC, humidity in centi-%RH, acceleration in mg
+#define TEMP_OFFSET_CENTI 4062 // 40.5 + 0.08 * (3.3 - 1.8) supply compensation
+#define CENTI 100
 
 // --------------------------------------------------------------
 
 typedef struct{
-	float x_axis_accel;
-	float y_axis_accel;
-	float z_axis_accel;
+	int16_t x_axis_accel;
+	int16_t y_axis_accel;
+	int16_t z_axis_accel;
 }accel_axis;
 
 
 // -------------------------------------------------------------	HDC2080 - T/H Sensor		------------------------------------------------
 uint8_t config_T_H_sensor(uint8_t temp_max, uint8_t hum_max);
 uint8_t sample_temp_hum();
-float	get_temperature();
-float	get_humidity();
+int16_t	get_temperature();
+uint16_t get_humidity();
+int16_t get_temperature_whole();
+uint16_t get_humidity_whole();
 uint8_t set_thresholds_T_H(uint8_t temp_max, uint8_t hum_max);
+uint8_t collect_temp_hum();
+uint8_t average_temp_hum(int16_t *temp, uint16_t *hum);
 
 // -------------------------------------------------------------	ADXL343 - Accel	Sensor	------------------------------------------------
 uint8_t config_ACCEL_sensor();
 uint8_t sample_accel();
 accel_axis get_accel();
+uint8_t collect_accel();
+bool accel_in_motion();
+
+void serve_sensors();
+
+// -------------------------------------------------------------	Conversions		--------------------------------------------------------
+int16_t convert_temperature(uint16_t raw);
+uint16_t convert_humidity(uint16_t raw);
+int16_t convert_temperature_whole(uint16_t raw);
+uint16_t convert_humidity_whole(uint16_t raw);
+int16_t convert_accel(int32_t raw_sum, uint16_t samples);
+uint8_t temp_threshold_code(uint8_t temp_max);
+uint8_t hum_threshold_code(uint8_t hum_max);
+int32_t div_round(int32_t num, int32_t den);
+uint32_t isqrt_round(uint32_t value);
 
 // --------------------------------------------------------------------------------------------------------------------------------
 bool check_threshold_active();
@@ -0,0 +1,130 @@
+/*
+ * series.h
+ *
+ *  Compact encoding of sensor time series, shared by the EEPROM store and
+ *  the uplink. A block is bit-packed (LSB first) in chunks of a fixed size,
+ *  one EEPROM record each or the whole uplink block:
+ *
+ *    anchor    first sample: time (u32) and each channel (int16), chunk 0
+ *    section   one per chunk at most, never crossing into the next one:
+ *                F         its samples fill the chunk: no count, the
+ *                          decoder takes as many as the chunk holds
+ *                count     otherwise, samples in it, 0 for padding
+ *                E         the next block starts from its last sample
+ *                L         lossy: a step code per channel (series_step_codes)
+ *                R         time step is the nominal one, otherwise width and
+ *                          zig-zag value of the base step, then the width of
+ *                          the zig-zag residuals
+ *                widths    per channel (SERIES_WIDTH_BITS)
+ *              then count samples: time residual, zig-zag value deltas
+ *
+ *  A section carries everything needed to read it, so the records of a block
+ *  whose anchor was overwritten in the ring still decode: with E set in the
+ *  last of them, series_open_orphans() integrates them back from the anchor
+ *  of the next block, which repeats their last sample (series_continue()).
+ *
+ *  Each channel is stored in SERIES_*_STEP units. The default step of 1
+ *  keeps every reading exact. A build with coarser steps (-DSERIES_TEMP_STEP=10
+ *  for 0.1 degC, ...) rounds the rest of each reading away and says so in each
+ *  section. series_next() and BAT_Decoder.py decode_series() scale back with
+ *  the section's own steps.
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: dst2001055
+ */
+
+#ifndef INC_SERIES_H_
+#define INC_SERIES_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define SERIES_MAX_CHANNELS 5
+#define SERIES_ANCHOR_BITS(channels) (32 + 16 * (channels))
+
+#define SERIES_STEP_BITS 3			// index in series_step_codes
+#define SERIES_TIME_WIDTH_BITS 6
+#define SERIES_WIDTH_BITS 4
+#define SERIES_WIDTH_WIDE 15		// width code of a full 17 bit delta
+
+// Quantisation of each channel in the units of series_sample, one of
+// 1, 2, 4, 5, 10, 20, 50, 100. 1 is lossless; 10 / 50 / 4 give 0.1 degC,
+// 0.5 %RH (HDC2080 is +-2 %RH) and one ADXL343 LSB (batmon_bench "series")
+#ifndef SERIES_TEMP_STEP
+#define SERIES_TEMP_STEP 1			// centi-degC
+#endif
+#ifndef SERIES_HUM_STEP
+#define SERIES_HUM_STEP 1			// centi-%RH
+#endif
+#ifndef SERIES_ACCEL_STEP
+#define SERIES_ACCEL_STEP 1			// mg
+#endif
+
+#define SERIES_LOSSY (SERIES_TEMP_STEP != 1 || SERIES_HUM_STEP != 1 || SERIES_ACCEL_STEP != 1)
+
+// Channel order: series with fewer channels keep the first ones
+enum series_channels{
+	SERIES_TEMP,		// centi-degC
+	SERIES_HUM,			// centi-%RH
+	SERIES_ACCEL_X,		// mg
+	SERIES_ACCEL_Y,
+	SERIES_ACCEL_Z
+};
+
+typedef struct{
+	uint32_t time;		// seconds since 2000-01-01 (calendar_to_seconds())
+	int16_t value[SERIES_MAX_CHANNELS];
+}series_sample;
+
+typedef struct{
+	uint8_t *buf;
+	uint16_t size;
+	uint16_t chunk;			// bytes per chunk
+	uint8_t channels;
+	uint8_t count_bits;
+	int32_t step;			// nominal time step, 0: none
+	uint16_t len;			// bytes up to the end of the last closed chunk
+	uint16_t samples;
+	uint32_t time;
+	int16_t last[SERIES_MAX_CHANNELS];		// quantised
+	uint16_t start;			// open section: bit offset of its header
+	uint16_t end;			// bit offset of its chunk end
+	uint16_t count;			// samples in it, 0: none open
+	bool full;				// laid out with F: count left out
+	int32_t base;			// time step of its first sample
+	uint8_t time_width;
+	uint8_t width[SERIES_MAX_CHANNELS];
+}series_encoder;
+
+typedef struct{
+	const uint8_t *buf;
+	uint16_t len;
+	uint16_t chunk;
+	uint8_t channels;
+	uint8_t count_bits;
+	int32_t step;
+	uint16_t pos;			// bit offset
+	uint16_t end;			// bit offset of the current chunk end
+	uint16_t count;			// samples left in the section
+	bool anchor;			// anchor sample not returned yet
+	bool linked;			// E of the last section read
+	int32_t base;
+	uint8_t time_width;
+	uint8_t width[SERIES_MAX_CHANNELS];
+	uint32_t time;
+	int16_t last[SERIES_MAX_CHANNELS];
+	uint8_t value_step[SERIES_MAX_CHANNELS];	// SERIES_*_STEP of the last section read
+}series_decoder;
+
+void series_begin(series_encoder *enc, uint8_t *buf, uint16_t size, uint16_t chunk, uint8_t channels, int32_t step);
+void series_continue(series_encoder *enc);
+bool series_linkable(const series_encoder *enc, const series_sample *sample);
+bool series_add(series_encoder *enc, const series_sample *sample);
+uint16_t series_finish(series_encoder *enc, bool linked);
+
+bool series_open(series_decoder *dec, const uint8_t *buf, uint16_t len, uint16_t chunk, uint8_t channels, int32_t step);
+bool series_open_orphans(series_decoder *dec, const uint8_t *buf, uint16_t len, uint16_t chunk, uint8_t channels,
+						 int32_t step, const series_sample *next);
+bool series_next(series_decoder *dec, series_sample *sample);
+
+#endif /* INC_SERIES_H_ */
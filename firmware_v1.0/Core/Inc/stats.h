@@ -0,0 +1,40 @@
+/*
+ * stats.h
+ *
+ *  Streaming statistics of one sensor channel: min and max with the time
+ *  they were seen, count, mean and variance. Each reading updates them in
+ *  O(1), so LOGS and the uplink read a summary without going back through
+ *  the stored history. The mean comes from the exact sum: a fixed-point
+ *  Welford mean stops moving once delta / count rounds to zero. The
+ *  variance is Welford's M2 on that mean.
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: dst2001055
+ */
+
+#ifndef INC_STATS_H_
+#define INC_STATS_H_
+
+#include <stdint.h>
+
+#define STATS_FRAC_BITS 4		// mean kept in 1/16 of the channel unit
+
+typedef struct{
+	uint32_t count;
+	int16_t min;
+	int16_t max;
+	uint32_t min_time;		// calendar_to_seconds() of the first reading at min
+	uint32_t max_time;
+	int64_t sum;
+	int32_t mean;			// sum / count << STATS_FRAC_BITS
+	uint64_t m2;			// sum of squared deviations, << 2 * STATS_FRAC_BITS, saturates
+}channel_stats;
+
+void stats_reset(channel_stats *stats);
+void stats_add(channel_stats *stats, int16_t value, uint32_t time);
+
+int16_t stats_mean(const channel_stats *stats);
+uint32_t stats_variance(const channel_stats *stats);
+uint16_t stats_stddev(const channel_stats *stats);
+
+#endif /* INC_STATS_H_ */
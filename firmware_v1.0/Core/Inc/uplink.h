@@ -0,0 +1,57 @@
+/*
+ * uplink.h
+ *
+ *  Batched sensor uplink to the BLE module on the COMMS UART. Readings are
+ *  collected in one series block (series.h, all channels, 1 s resolution,
+ *  one chunk of UPLINK_BLOCK_SIZE, no nominal time step)
+ *  and sent as a single frame (frame.h) once the batch is full, so the
+ *  module wakes the radio once per batch instead of once per reading:
+ *
+ *    [FRAME_TYPE_UPLINK][flags][seq u16 LE][vibration][series block] + CRC-16
+ *
+ *  A reading passed with UPLINK_FLAG_ANOMALY is sent at once together with
+ *  the batch it closes. With UPLINK_FLAG_VIBRATION the series block follows
+ *  the largest vibration features of the batch (vibration.h) as varints:
+ *  rms, peak_to_peak and crest X/Y/Z, then the bands. BAT_Decoder.py
+ *  decodes the frames on the gateway.
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: dst2001055
+ */
+
+#ifndef INC_UPLINK_H_
+#define INC_UPLINK_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "series.h"
+#include "vibration.h"
+
+#ifndef UPLINK_BATCH
+#define UPLINK_BATCH 8				// default readings per frame
+#endif
+#define UPLINK_BATCH_MAX 32
+
+#define UPLINK_HEADER_SIZE 4		// type, flags, seq
+#define UPLINK_BLOCK_SIZE 96		// a full block is sent before the batch is
+#define UPLINK_TX_WAIT_MS 50		// for the previous frame to leave
+#define UPLINK_VIB_FIELDS (3 * 3 + VIB_BANDS)
+#define UPLINK_VIB_SIZE (UPLINK_VIB_FIELDS * 3)	// u16 varints, worst case
+
+#define UPLINK_FLAG_ANOMALY 0x01
+#define UPLINK_FLAG_VIBRATION 0x02
+
+typedef struct{
+	uint32_t frames;
+	uint32_t anomaly_frames;
+	uint32_t readings;
+	uint32_t bytes;			// on the wire, delimiters included
+	uint32_t dropped;		// frames lost: UART still busy or not started
+}uplink_stats;
+
+void uplink_config(uint8_t batch);
+uint8_t uplink_add(const series_sample *sample, const vibration_features *vibration, uint8_t flags);
+uint8_t uplink_flush(uint8_t flags);
+uplink_stats get_uplink_stats();
+
+#endif /* INC_UPLINK_H_ */
@@ -0,0 +1,54 @@
+/*
+ * vibration.h
+ *
+ *  Vibration features of the ADXL343 FIFO stream. The mean get_accel()
+ *  reports is mostly gravity and averages the oscillation away, so every
+ *  FIFO entry also goes through here and a DATA_READ window comes out as:
+ *
+ *    rms           per axis, around the window mean (gravity removed)
+ *    peak_to_peak  per axis, max - min
+ *    crest         per axis, largest excursion from the mean / rms
+ *    band          RMS of the three axes together in VIB_BANDS bands
+ *
+ *  The bands come from integer Goertzel filters on VIB_BLOCK sample blocks:
+ *  bins k = 1..VIB_BINS, k * ODR / VIB_BLOCK apart (3.125 Hz at 50 Hz),
+ *  bin energies summed into the bands of vib_band_of_bin[]. Partial blocks
+ *  carry over to the next window. Only the ADXL343_FIFO_MODE stream feeds
+ *  it, the snapshot mode leaves the features at zero.
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: dst2001055
+ */
+
+#ifndef INC_VIBRATION_H_
+#define INC_VIBRATION_H_
+
+#include <stdint.h>
+
+#define VIB_BLOCK 16		// samples per Goertzel block: 0.32 s at 50 Hz
+#define VIB_BINS 7			// k = 1..7, DC and Nyquist left out
+#define VIB_BANDS 4
+#define VIB_COEF_BITS 12	// Goertzel coefficients 2cos(2 pi k / VIB_BLOCK) in Q12
+
+// Bands at the 50 Hz ODR
+enum vibration_bands{
+	VIB_BAND_SWAY,		// bin 1:     3 Hz, load sway and handling
+	VIB_BAND_LOW,		// bin 2:     6 Hz, suspension
+	VIB_BAND_MID,		// bins 3-4:  9-13 Hz, engine and road
+	VIB_BAND_HIGH		// bins 5-7: 16-22 Hz, rattle and loose parts
+};
+
+typedef struct{
+	uint16_t samples;			// FIFO entries in the window, 0 -> no features
+	uint16_t rms[3];			// mg
+	uint16_t peak_to_peak[3];	// mg
+	uint16_t crest[3];			// x100
+	uint16_t band[VIB_BANDS];	// mg RMS
+}vibration_features;
+
+void vibration_reset();
+void vibration_add(const int16_t raw[3]);
+vibration_features vibration_take();
+uint16_t vibration_max(const uint16_t axis[3]);
+
+#endif /* INC_VIBRATION_H_ */
@@ -25,6 +25,32 @@ extern enum errorTypes ERROR_CODE;
 
 bool flag_anomaly_temp = false;
 bool flag_anomaly_hum = false;
+bool flag_anomaly_vib = false;
+bool flag_anomaly_shock = false;
+
+// Last DATA_READ averages, kept for the EEPROM records
+static int16_t last_temp = 0;		// centi-degC
+static uint16_t last_hum = 0;		// centi-%RH
+static accel_axis last_accel = {0};	// mg
+static vibration_features last_vibration = {0};
+static bool last_in_motion = true;
+
+// Set on ANOMALY entry, cleared when COMMS finds every value back in range.
+// Meanwhile the ANOMALY -> DATA_READ -> COMMS loop follows the readings and
+// a threshold event has nothing to add
+static bool anomaly_latched = false;
+
+// An alert is stored once when it starts, not on every ANOMALY pass
+static bool alert_temp_stored = false;
+static bool alert_hum_stored = false;
+static bool alert_vib_stored = false;
+
+// Streaming statistics of every DATA_READ since start-up, in series channel order
+static channel_stats sensor_stats[SERIES_MAX_CHANNELS];
+
+static bool mem_sensor_stored = false;
+static uint32_t mem_sensor_tick = 0;
+static uint32_t mem_sensor_time = 0;		// calendar_to_seconds() of the last sample
 
 rtc_calendar system_time = {
 	.hour = SYSTEM_HOUR,
@@ -39,7 +65,11 @@ rtc_calendar system_time = {
 uint8_t init_device(){
 
 	// Config COMMS (BLE)
+	uplink_config(UPLINK_BATCH);
 
+	for(uint8_t c = 0; c < SERIES_MAX_CHANNELS; c++){
+		stats_reset(&sensor_stats[c]);
+	}
 
 
 	//Config RTC - get info from BLE COMMS or Manual Input from user
@@ -59,6 +89,10 @@ uint8_t init_device(){
 	// Config PWR
 
 	// Config EEPROM
+	ERROR_CODE = config_mem();
+	if(ERROR_CODE != NO_ERROR){
+		error_handler(ERROR_CODE);
+	}
 
 	// Config Sensors -> TEMP & HUM SENSOR + ACCELOMETER
 	ERROR_CODE = config_T_H_sensor(TEMP_HIGH_ALERT_VAL, HUM_HIGH_ALERT_VAL);
@@ -83,58 +117,307 @@ uint8_t init_device(){
 }
 
 
+//-------------------------------------------------------------------------- EVENTS --------------------------------------------------------------------
+
+// What the interrupts posted since the last step, read by the FSM_ANY guards
+// and cleared once they ran
+typedef struct{
+	bool anomaly;
+	bool button;
+	bool sensor_int;
+	uint8_t presses;
+}fsm_inputs;
+
+static fsm_inputs inputs;
+
+// INT_SOURCE bits of the last ADXL343 shock / free fall, kept until SHOCK stores them
+static uint8_t shock_source = 0;
+
+// Everything the interrupts posted so far, served in one go. The sensor job
+// results may post FSM events, popped by the same loop. True if one of those
+// came: the FSM has something to react to
+static bool serve_events(){
+
+	app_event event;
+	bool fsm_event = false;
+	bool sensor_int = false;
+
+	// Also catches a job whose event did not fit in the queue
+	serve_sensors();
+
+	while(pop_event(&event)){
+		fsm_event |= (event.type != EVENT_SENSOR_DATA);
+
+		switch(event.type){
+			// Popped first: a job finishing meanwhile posts a fresh one
+			case EVENT_SENSOR_DATA:
+				serve_sensors();
+				break;
+
+			case EVENT_TH_THRESHOLD:
+				inputs.anomaly = true;
+				break;
+
+			case EVENT_SENSOR_INT:
+				sensor_int = true;
+				break;
+
+			case EVENT_BUTTON:
+				inputs.button = true;
+				inputs.presses = event.value;		// latest gesture wins
+				break;
+
+			case EVENT_ACCEL_SHOCK:
+				shock_source |= event.value;
+				break;
+
+			default:
+				break;
+		}
+	}
+
+	// Trigger mode INT: read the source once, however many edges came
+	if(sensor_int){
+		inputs.sensor_int = true;
+		if(check_threshold_active()){
+			inputs.anomaly = true;
+		}
+	}
+
+	return fsm_event;
+}
+
+// The main loop's wait between steps: sensor data is served as it arrives,
+// an FSM event ends the wait early
+void app_wait(uint32_t ms){
+
+	uint32_t deadline = HAL_GetTick() + ms;
+	int32_t remaining;
+
+	while((remaining = (int32_t)(deadline - HAL_GetTick())) > 0){
+		if(serve_events()){
+			return;
+		}
+		idle_delay(remaining);
+	}
+}
+
+//---- GUARDS ----
+// Latched: a limit held across samples must not re-enter ANOMALY every step
+// and starve the DATA_READ / COMMS rows behind it
+static bool on_anomaly(uint8_t arg){
+	(void)arg;
+	return inputs.anomaly && !anomaly_latched;
+}
+
+// USER_BTN gesture of arg presses, BUTTON_ANY for any other count
+static bool on_button(uint8_t arg){
+	return inputs.button && (arg == BUTTON_ANY || inputs.presses == arg);
+}
+
+// IDLE only: from DATA_READ it would preempt COMMS and drop the reading just
+// taken, and every other state returns to IDLE on its own
+static bool on_sensor_int(uint8_t arg){
+	(void)arg;
+	return inputs.sensor_int && CURRENT_STATE == IDLE;
+}
+
+static bool on_shock(uint8_t arg){
+	(void)arg;
+	return shock_source != 0;
+}
+
+static bool values_out_of_range(uint8_t arg){
+	(void)arg;
+	return flag_anomaly_temp || flag_anomaly_hum || flag_anomaly_vib || flag_anomaly_shock;
+}
+
+//---- ENTRY ACTIONS ----
+// SYS_LED stays on until COMMS finds every value back in range
+static void alarm_led_on(){
+	HAL_GPIO_WritePin(GPIOA, SYS_LED_PIN, GPIO_PIN_SET);
+}
+
+static void anomaly_entry(){
+	anomaly_latched = true;
+	alarm_led_on();
+}
+
 //-------------------------------------------------------------------------- STATE MACHINE --------------------------------------------------------------------
-void app_fsm(){
 
-	//Get current RTC timestamp
-	get_sys_time();
+#define FSM_INITIAL IDLE
+
+// X(p, from, guard, arg, to), p is passed through to X. Rows from FSM_ANY are
+// checked on every step before the state runs, the others when the state
+// returns; the first row whose guard holds wins, so order is priority:
+// shock > anomaly > button > sensor INT > periodic. An FSM_ANY row overrides
+// the state rows, so its guard must consume or latch what it reacts to: a
+// condition that holds on every step would keep the FSM in its target
+#define FSM_TRANSITIONS(X, p) \
+	X(p, FSM_ANY,   on_shock,            0,          SHOCK) \
+	X(p, FSM_ANY,   on_anomaly,          0,          ANOMALY) \
+	X(p, FSM_ANY,   on_button,           1,          DATA_READ) \
+	X(p, FSM_ANY,   on_button,           2,          LOGS) \
+	X(p, FSM_ANY,   on_button,           3,          RECONNECT) \
+	X(p, FSM_ANY,   on_button,           5,          CLEAN_MEM) \
+	X(p, FSM_ANY,   on_button,           BUTTON_ANY, IDLE) \
+	X(p, FSM_ANY,   on_sensor_int,       0,          IDLE) \
+	X(p, IDLE,      NULL,                0,          DATA_READ) \
+	X(p, DATA_READ, NULL,                0,          COMMS) \
+	X(p, COMMS,     values_out_of_range, 0,          ANOMALY) \
+	X(p, COMMS,     NULL,                0,          IDLE) \
+	X(p, ANOMALY,   NULL,                0,          DATA_READ) \
+	X(p, RECONNECT, NULL,                0,          IDLE) \
+	X(p, LOGS,      NULL,                0,          IDLE) \
+	X(p, CLEAN_MEM, NULL,                0,          IDLE) \
+	X(p, SHOCK,     NULL,                0,          DATA_READ)
+
+#define FSM_ROW(p, from, guard, arg, to) {from, guard, arg, to},
+
+static const fsm_transition fsm_transitions[] = {
+	FSM_TRANSITIONS(FSM_ROW, ~)
+};
 
-	CURRENT_STATE = NEXT_STATE;
+static const fsm_state fsm_states[STATE_COUNT] = {
+	[IDLE]      = {state_idle,          NULL},
+	[DATA_READ] = {state_read_sensors,  NULL},
+	[COMMS]     = {state_comms,         NULL},
+	[ANOMALY]   = {state_anomaly,       anomaly_entry},
+	[RECONNECT] = {state_reconnect,     NULL},
+	[LOGS]      = {state_print_logs,    NULL},
+	[CLEAN_MEM] = {state_clean_memory,  NULL},
+	[SHOCK]     = {state_shock,         alarm_led_on},
+};
 
-	switch(CURRENT_STATE){
-	  case IDLE:
-		  ERROR_CODE = state_idle();
-		  break;
+//---- BUILD TIME CHECKS ----
+// Over the state rows only (an FSM_ANY row reaches every state by itself):
+// forward from FSM_INITIAL and the event targets, every state is entered;
+// backward from FSM_INITIAL, every state finds its way back without an event.
+// One transition deeper per step
+#define FSM_STATE_BIT(state) (1U << ((state) & 0x1F))
+#define FSM_ALL_STATES (FSM_STATE_BIT(STATE_COUNT) - 1U)
+#define FSM_REACH_ROW(reached, from, guard, arg, to) \
+	| (((from) != FSM_ANY && ((reached) & FSM_STATE_BIT(from))) ? FSM_STATE_BIT(to) : 0U)
+#define FSM_REACH(reached) ((reached) FSM_TRANSITIONS(FSM_REACH_ROW, reached))
+#define FSM_RETURN_ROW(reached, from, guard, arg, to) \
+	| (((from) != FSM_ANY && ((reached) & FSM_STATE_BIT(to))) ? FSM_STATE_BIT(from) : 0U)
+#define FSM_RETURN(reached) ((reached) FSM_TRANSITIONS(FSM_RETURN_ROW, reached))
+#define FSM_EVENT_ROW(p, from, guard, arg, to) | ((from) == FSM_ANY ? FSM_STATE_BIT(to) : 0U)
+#define FSM_SOURCE_ROW(p, from, guard, arg, to) | ((from) == FSM_ANY ? 0U : FSM_STATE_BIT(from))
+
+enum{
+	FSM_REACH_0 = FSM_STATE_BIT(FSM_INITIAL) | (0U FSM_TRANSITIONS(FSM_EVENT_ROW, ~)),
+	FSM_REACH_1 = FSM_REACH(FSM_REACH_0),
+	FSM_REACH_2 = FSM_REACH(FSM_REACH_1),
+	FSM_REACH_3 = FSM_REACH(FSM_REACH_2),
+	FSM_REACH_4 = FSM_REACH(FSM_REACH_3),
+	FSM_REACH_5 = FSM_REACH(FSM_REACH_4),
+	FSM_REACH_6 = FSM_REACH(FSM_REACH_5),
+	FSM_REACH_7 = FSM_REACH(FSM_REACH_6),
+
+	FSM_RETURN_0 = FSM_STATE_BIT(FSM_INITIAL),
+	FSM_RETURN_1 = FSM_RETURN(FSM_RETURN_0),
+	FSM_RETURN_2 = FSM_RETURN(FSM_RETURN_1),
+	FSM_RETURN_3 = FSM_RETURN(FSM_RETURN_2),
+	FSM_RETURN_4 = FSM_RETURN(FSM_RETURN_3),
+	FSM_RETURN_5 = FSM_RETURN(FSM_RETURN_4),
+	FSM_RETURN_6 = FSM_RETURN(FSM_RETURN_5),
+	FSM_RETURN_7 = FSM_RETURN(FSM_RETURN_6)
+};
 
-	  case DATA_READ:
-		  ERROR_CODE = state_read_sensors();
-		  break;
+_Static_assert(STATE_COUNT <= 8, "FSM: add FSM_REACH / FSM_RETURN steps, one per state past the first");
+_Static_assert(FSM_REACH_7 == FSM_ALL_STATES, "FSM: state entered by no event and no transition");
+_Static_assert(FSM_RETURN_7 == FSM_ALL_STATES, "FSM: state that never returns to FSM_INITIAL on its own");
+_Static_assert((0U FSM_TRANSITIONS(FSM_SOURCE_ROW, ~)) == FSM_ALL_STATES, "FSM: state without an outgoing transition");
 
-	  case COMMS:
-		  ERROR_CODE = state_comms();
-		  break;
+static fsm_state_stats fsm_stats[STATE_COUNT];
+static uint8_t fsm_last_state = STATE_COUNT;		// none run yet
 
-	  case ANOMALY:
-		  ERROR_CODE = state_anomaly();
-		  break;
+// First row from 'from' whose guard holds, 'fallback' if none
+static uint8_t fsm_select(uint8_t from, uint8_t fallback){
 
-	  case RECONNECT:
-		  ERROR_CODE = state_reconnect();
-		  break;
+	for(uint8_t i = 0; i < sizeof(fsm_transitions) / sizeof(fsm_transitions[0]); i++){
+		const fsm_transition *row = &fsm_transitions[i];
 
-	  case LOGS:
-		  ERROR_CODE = state_print_logs();
-		  break;
+		if(row->from == from && (row->guard == NULL || row->guard(row->arg))){
+			return row->to;
+		}
+	}
 
-	  case CLEAN_MEM:
-		  ERROR_CODE = state_clean_memory();
-		  break;
+	return fallback;
+}
+
+void app_fsm(){
+
+	// Latch the RTC once per wake-up, logs run from the cache
+	latch_sys_time();
+
+	serve_events();
 
-	  default:
-		  NEXT_STATE = IDLE;
-		  break;
+	// Interrupt events override the transition picked when the last state returned
+	NEXT_STATE = fsm_select(FSM_ANY, NEXT_STATE);
+	if(NEXT_STATE >= STATE_COUNT){
+		NEXT_STATE = FSM_INITIAL;
 	}
+	memset(&inputs, 0, sizeof(inputs));
+
+	if(NEXT_STATE != fsm_last_state){
+		fsm_stats[NEXT_STATE].entries++;
+		if(fsm_states[NEXT_STATE].on_entry != NULL){
+			fsm_states[NEXT_STATE].on_entry();
+		}
+	}
+
+	CURRENT_STATE = NEXT_STATE;
+	fsm_last_state = CURRENT_STATE;
+
+	fsm_state_stats *stats = &fsm_stats[CURRENT_STATE];
+	uint32_t start_us = get_tick_us();
+
+	ERROR_CODE = fsm_states[CURRENT_STATE].run();
+
+	uint32_t run_us = get_tick_us() - start_us;
+
+	stats->runs++;
+	stats->run_us += run_us;
+	if(run_us > stats->max_run_us){
+		stats->max_run_us = run_us;
+	}
+
+	NEXT_STATE = fsm_select(CURRENT_STATE, FSM_INITIAL);
 
 	if(ERROR_CODE != NO_ERROR){
 		error_handler(ERROR_CODE);
 	}
 }
 
+fsm_state_stats get_fsm_stats(uint8_t state){
+
+	fsm_state_stats stats = {0};
+
+	if(state < STATE_COUNT){
+		stats = fsm_stats[state];
+	}
+
+	return stats;
+}
+
+channel_stats get_sensor_stats(uint8_t channel){
+
+	channel_stats stats = {0};
+
+	if(channel < SERIES_MAX_CHANNELS){
+		stats = sensor_stats[channel];
+	}
+
+	return stats;
+}
+
 //---------------------------------------- STATE DEFINITION ----------------------------------
 // TODO: START TIME_TRIGGER COUNT
 uint8_t state_idle(){
 
-	ERROR_CODE = log_write(DEBUG_LOG, "Current State -> %d - %s", CURRENT_STATE, "IDLE");
+	ERROR_CODE = LOG_WRITE(DEBUG_LOG, LOG_STATE_IDLE, CURRENT_STATE);
 
 	// Activate HDC2080 + ACCEL INTERRUPTS
 
@@ -144,18 +427,8 @@ uint8_t state_idle(){
 	// Start time trigger -> stop + config - SAMPLE_TIME INT + start counting -> IN INTERRUPT WAKE UP MCU and resume operation
 
 
-	// TODO: STOP MODE WITH RTC -> DEFINE SAMPLE TIME
-
-
-//		HAL_SuspendTick();
-//		HAL_RTCEx_SetWakeUpTimer_IT(&hrtc, 0x500B, RTC_WAKEUPCLOCK_RTCCLK_DIV16);
-//
-//		/* Enter STOP 2 mode */
-//		HAL_PWREx_EnterSTOP2Mode(PWR_STOPENTRY_WFI);
-//		HAL_RTCEx_DeactivateWakeUpTimer(&hrtc);
-//		SystemClock_Config();
-//		HAL_ResumeTick();
-//
+	// STOP MODE WITH RTC -> the main loop idles tickless between states: app_wait() -> idle_delay() -> enter_stop_mode() (mal.c)
+	// wakes on the RTC wake-up timer or on the button / sensor EXTIs
 
 	// --------------------------------------------------------------- EXIT SLEEP MODE ----------------------------------------------------------
 
@@ -174,8 +447,6 @@ uint8_t state_idle(){
 	// ou adicionar mecanismo para perceber se ha flag vinda da INT que indique transição de estado, após filtrar - se sim, dá return nesta função para a FSM
 
 
-	NEXT_STATE = DATA_READ;		//Debug reasons TODO: remove
-
 	return ERROR_CODE;
 }
 
@@ -184,86 +455,164 @@ uint8_t state_idle(){
 // SAMPLE SENSOR DATA -> TEMP + HUM + ACCEL
 uint8_t state_read_sensors(){
 
-	float temp_buff[SAMPLE_SIZE];
-	float hum_buff[SAMPLE_SIZE];
-	float sense_temp;
-	float sense_hum;
+	int16_t sense_temp;		// centi-degC
+	uint16_t sense_hum;		// centi-%RH
 
-	ERROR_CODE = log_write(DEBUG_LOG, "Current State -> %d - %s", CURRENT_STATE, "READ SENSORS");
+	ERROR_CODE = LOG_WRITE(DEBUG_LOG, LOG_STATE_READ, CURRENT_STATE);
 
 	//----------------------------------------------------------- HDC2080 -----------------------------------------------------------------------
 
-	sense_temp = 0;
-	sense_hum  = 0;
+	// AMM: the sensor measures on its own at 1 Hz, average what it collected.
+	// Trigger: SAMPLE_SIZE conversions now
+	ERROR_CODE = average_temp_hum(&sense_temp, &sense_hum);
 
-	for(uint8_t i=0; i < SAMPLE_SIZE; i++){
+	// PRINT IN uint8_t -> FLASH SIZE 32 KB-> compile '-u _printf_float' -> too big for FLASH MEMORY
+	last_temp = sense_temp;
+	last_hum = sense_hum;
 
-		//Sample T+H sensor
-		sample_temp_hum();
+	uint8_t sense_temp_print = (uint8_t) get_temperature_whole();
+	uint8_t sense_hum_print = (uint8_t) get_humidity_whole();
 
-		temp_buff[i] = get_temperature();
-		hum_buff[i] = get_humidity();
+	ERROR_CODE = LOG_WRITE(INFO_LOG, LOG_TEMPERATURE, sense_temp_print);
+	ERROR_CODE = LOG_WRITE(INFO_LOG, LOG_HUMIDITY, sense_hum_print);
 
-		sense_temp += temp_buff[i];
-		sense_hum += hum_buff[i];
+	// Compare threshold values -> send to anomaly after COMMS
+	if(sense_temp >= TEMP_HIGH_ALERT_VAL * CENTI) flag_anomaly_temp = true;
+	if(sense_hum >= HUM_HIGH_ALERT_VAL * CENTI) flag_anomaly_hum = true;
 
-		wait_delay(SENSOR_DELAY_MS);
-	}
 
-	sense_temp = sense_temp / SAMPLE_SIZE;
-	sense_hum = sense_hum / SAMPLE_SIZE;
+	//----------------------------------------------------------- ADXL343 -----------------------------------------------------------------------
 
-	// PRINT IN uint8_t -> FLASH SIZE 32 KB-> compile '-u _printf_float' -> too big for FLASH MEMORY
-	uint8_t sense_temp_print = (uint8_t) roundf(sense_temp);
-	uint8_t sense_hum_print = (uint8_t) roundf(sense_hum);
+	accel_axis current_accel;
 
-	ERROR_CODE = log_write(INFO_LOG, "Current Temperature ----> %u C", sense_temp_print);
-	ERROR_CODE = log_write(INFO_LOG, "Current Humidity -------> %u %%", sense_hum_print);
+	// mg
+	current_accel = get_accel();
+	last_accel = current_accel;
 
-	// Compare threshold values -> send to anomaly after COMMS
-	if(sense_temp >= TEMP_HIGH_ALERT_VAL) flag_anomaly_temp = true;
-	if(sense_hum >= HUM_HIGH_ALERT_VAL) flag_anomaly_hum = true;
+	LOG_WRITE(INFO_LOG, LOG_ACCEL_X, current_accel.x_axis_accel);
+	LOG_WRITE(INFO_LOG, LOG_ACCEL_Y, current_accel.y_axis_accel);
+	LOG_WRITE(INFO_LOG, LOG_ACCEL_Z, current_accel.z_axis_accel);
 
+	// Vibration of the FIFO entries since the last DATA_READ, none in snapshot mode
+	last_vibration = vibration_take();
 
-	//----------------------------------------------------------- ADXL343 -----------------------------------------------------------------------
+	// Event mode: the ADXL343 keeps the watermark off while parked
+	if(accel_in_motion() != last_in_motion){
+		last_in_motion = accel_in_motion();
+		LOG_WRITE(INFO_LOG, last_in_motion ? LOG_ACCEL_MOVING : LOG_ACCEL_PARKED);
+	}
 
-	accel_axis current_accel;
-	int16_t current_x_accel, current_y_accel, current_z_accel;
+	if(last_vibration.samples > 0){
+		uint16_t crest = vibration_max(last_vibration.crest);
 
-	current_accel = get_accel();
+		LOG_WRITE(INFO_LOG, LOG_VIB_RMS, last_vibration.rms[0], last_vibration.rms[1], last_vibration.rms[2]);
+		LOG_WRITE(INFO_LOG, LOG_VIB_PEAK, vibration_max(last_vibration.peak_to_peak), crest / 100, crest % 100);
+		LOG_WRITE(INFO_LOG, LOG_VIB_BANDS, last_vibration.band[VIB_BAND_SWAY], last_vibration.band[VIB_BAND_LOW],
+				last_vibration.band[VIB_BAND_MID], last_vibration.band[VIB_BAND_HIGH]);
 
+		if(vibration_max(last_vibration.rms) >= VIB_HIGH_ALERT_VAL) flag_anomaly_vib = true;
+	}
 
-	current_x_accel = (int16_t) roundf(current_accel.x_axis_accel);
-	current_y_accel = (int16_t) roundf(current_accel.y_axis_accel);
-	current_z_accel = (int16_t) roundf(current_accel.z_axis_accel);
+	// O(1) per reading, LOGS reads the summary without the stored history
+	uint32_t read_time = calendar_to_seconds(get_cached_time(NULL));
+	int16_t reading_values[SERIES_MAX_CHANNELS] = {
+		sense_temp, (int16_t)sense_hum, current_accel.x_axis_accel, current_accel.y_axis_accel, current_accel.z_axis_accel
+	};
 
-	log_write(INFO_LOG, "Current X Acceleration -> %d mg", current_x_accel);
-	log_write(INFO_LOG, "Current Y Acceleration -> %d mg", current_y_accel);
-	log_write(INFO_LOG, "Current Z Acceleration -> %d mg", current_z_accel);
+	for(uint8_t c = 0; c < SERIES_MAX_CHANNELS; c++){
+		stats_add(&sensor_stats[c], reading_values[c], read_time);
+	}
 
-	//TODO ADD ACCEL THRESHOLD
-	//if(sense_accel >= ACCEL_HIGH_ALERT_VAL) flag_anomaly_accel = true;
+#if LOG_TELEMETRY
+	telemetry_record reading = {
+		.temp = sense_temp,
+		.hum = sense_hum,
+		.accel = {current_accel.x_axis_accel, current_accel.y_axis_accel, current_accel.z_axis_accel},
+		.flags = (flag_anomaly_temp ? TELEMETRY_FLAG_TEMP : 0) | (flag_anomaly_hum ? TELEMETRY_FLAG_HUM : 0) |
+				(flag_anomaly_vib ? TELEMETRY_FLAG_VIB : 0) | (flag_anomaly_shock ? TELEMETRY_FLAG_SHOCK : 0)
+	};
 
-	NEXT_STATE = COMMS;
+	log_telemetry(&reading);
+#endif
 
 	return ERROR_CODE;
 }
 
 
+// Capture summary as one MEM_CAPTURE record, stamped back to the trigger
+_Static_assert(CAPTURE_PRE <= INT8_MAX && CAPTURE_POST <= INT8_MAX, "peak_at must fit an int8_t");
+
+static uint8_t store_capture(const capture_window *capture){
+
+	uint16_t ms;
+	uint32_t now_s = calendar_to_seconds(get_cached_time(&ms));
+	uint32_t age_ms = HAL_GetTick() - capture->tick;
+	uint32_t trigger_time = now_s - (age_ms + 999 - ms) / 1000;
+	mem_record record = {.type = MEM_CAPTURE, .timestamp = pack_timestamp(seconds_to_calendar(trigger_time))};
+
+	record.capture.source = capture->source;
+	record.capture.peak = capture->peak;
+	record.capture.peak_at = capture->peak_at;
+	record.capture.disturbed = capture->disturbed;
+
+	return mem_write(&record);
+}
+
+
 // Sends info to BLE Module via COMMS UART + Debug UART info about the current state of operation + write in EEPROM (overwrite older information)
 uint8_t state_comms(){
 
-	ERROR_CODE = log_write(DEBUG_LOG, "Current State -> %d - %s", CURRENT_STATE, "COMMS");
+	ERROR_CODE = LOG_WRITE(DEBUG_LOG, LOG_STATE_COMMS, CURRENT_STATE);
 
-	//TODO ADD ACCEL THRESHOLD
+	// Sensor sample to the EEPROM series every MEM_SENSOR_PERIOD_MS, not every cycle (wear).
+	// Stamped on the nominal schedule, so a regular series costs no time bytes
+	uint32_t now = HAL_GetTick();
+	bool alert = values_out_of_range(0);
 
-	// Filter if values are within normal defined range (TEMP | HUM | ACCEL)
-	if(flag_anomaly_temp || flag_anomaly_hum){
-		NEXT_STATE = ANOMALY;
-	} else {
-		ERROR_CODE = log_write(INFO_LOG, "Sensor Values Inside Defined Margin!");
+	// Every reading to the BLE uplink, batched; out of range ones go out at once
+	series_sample reading = {
+		.time = calendar_to_seconds(get_cached_time(NULL)),
+		.value = {last_temp, last_hum, last_accel.x_axis_accel, last_accel.y_axis_accel, last_accel.z_axis_accel}
+	};
+
+	ERROR_CODE = uplink_add(&reading, &last_vibration, alert ? UPLINK_FLAG_ANOMALY : 0);
+
+	if(!mem_sensor_stored || now - mem_sensor_tick >= MEM_SENSOR_PERIOD_MS){
+		series_sample sample = {0};
+
+		if(!mem_sensor_stored){
+			mem_sensor_tick = now;
+			mem_sensor_time = calendar_to_seconds(get_cached_time(NULL));
+		} else {
+			uint32_t periods = (now - mem_sensor_tick) / MEM_SENSOR_PERIOD_MS;
+
+			mem_sensor_tick += periods * MEM_SENSOR_PERIOD_MS;
+			mem_sensor_time += periods * (MEM_SENSOR_PERIOD_MS / 1000);
+		}
+
+		sample.time = mem_sensor_time;
+		sample.value[SERIES_TEMP] = last_temp;
+		sample.value[SERIES_HUM] = last_hum;
+
+		mem_sensor_stored = true;
+		ERROR_CODE = mem_store_sample(&sample);
+	}
+
+	// Black box: a capture is complete once its post-trigger samples are in
+	capture_window capture;
+	if(capture_take(&capture)){
+		ERROR_CODE = store_capture(&capture);
+	}
+
+	if(!flag_anomaly_temp) alert_temp_stored = false;
+	if(!flag_anomaly_hum) alert_hum_stored = false;
+	if(!flag_anomaly_vib) alert_vib_stored = false;
+
+	// Filter if values are within normal defined range (TEMP | HUM | ACCEL), out of range -> ANOMALY (fsm_transitions)
+	if(!alert){
+		ERROR_CODE = LOG_WRITE(INFO_LOG, LOG_VALUES_OK);
 		HAL_GPIO_WritePin(GPIOA, SYS_LED_PIN, GPIO_PIN_RESET);
-		NEXT_STATE = IDLE;
+		anomaly_latched = false;
 	}
 
 	return ERROR_CODE;
@@ -273,26 +622,52 @@ uint8_t state_comms(){
 // Alert state -> activate interfaces + double check values (NEXT_STATE = DATA_READ)
 uint8_t state_anomaly(){
 
-	ERROR_CODE = log_write(DEBUG_LOG, "Current State -> %d - %s", CURRENT_STATE, "ANOMALY");
+	ERROR_CODE = LOG_WRITE(DEBUG_LOG, LOG_STATE_ANOMALY, CURRENT_STATE);
+
+	mem_record record = {.type = MEM_EVENT, .timestamp = get_timestamp(NULL)};
+
+	if(flag_anomaly_temp && !alert_temp_stored){
+		record.event.code = MEM_EVENT_TEMP_ALERT;
+		record.event.value = last_temp;
+		alert_temp_stored = true;
+		ERROR_CODE = mem_write(&record);
+	}
+
+	if(flag_anomaly_hum && !alert_hum_stored){
+		record.event.code = MEM_EVENT_HUM_ALERT;
+		record.event.value = last_hum;
+		alert_hum_stored = true;
+		ERROR_CODE = mem_write(&record);
+	}
+
+	if(flag_anomaly_vib && !alert_vib_stored){
+		record.event.code = MEM_EVENT_VIB_ALERT;
+		record.event.value = (int16_t)vibration_max(last_vibration.rms);
+		alert_vib_stored = true;
+		ERROR_CODE = mem_write(&record);
+	}
 
 	if(flag_anomaly_temp){
 		flag_anomaly_temp = false;
 		//start_buzzer();
 		//control_led() -> toggle LED 1s intervals
-		HAL_GPIO_WritePin(GPIOA, SYS_LED_PIN, GPIO_PIN_SET);
-		log_write(WARNING_LOG, "Temperature Threshold!");
+		LOG_WRITE(WARNING_LOG, LOG_TEMP_THRESHOLD);
 	}
 
 	if(flag_anomaly_hum){
 		flag_anomaly_hum = false;
 		//start_buzzer();
 		//control_led() -> toggle LED 1s intervals
-		HAL_GPIO_WritePin(GPIOA, SYS_LED_PIN, GPIO_PIN_SET);
-		log_write(WARNING_LOG, "Humidity Threshold!");
+		LOG_WRITE(WARNING_LOG, LOG_HUM_THRESHOLD);
 	}
 
+	if(flag_anomaly_vib){
+		flag_anomaly_vib = false;
+		LOG_WRITE(WARNING_LOG, LOG_VIB_THRESHOLD);
+	}
 
-	NEXT_STATE = DATA_READ;
+	// Stored and reported by SHOCK already
+	flag_anomaly_shock = false;
 
 	return ERROR_CODE;
 }
@@ -303,33 +678,262 @@ uint8_t state_reconnect(){
 
 	//ERROR_CODE = log_write(DEBUG_LOG, "Current State -> %d - %s", CURRENT_STATE, "RECONNECT");
 
-	NEXT_STATE = IDLE;
-
 	return ERROR_CODE;
 }
 
 
-// Read EEPROM contents and send via DEBUG UART -> Extra: Send info to SD Card (Future updated PCB version ?)
+// MIN and MAX values registered while functioning, with mean and spread, from RAM
+static void log_sensor_stats(){
+
+	LOG_WRITE(INFO_LOG, LOG_STATS_COUNT, (unsigned)sensor_stats[SERIES_TEMP].count);
+
+	if(sensor_stats[SERIES_TEMP].count == 0){
+		return;
+	}
+
+	for(uint8_t c = 0; c < SERIES_MAX_CHANNELS; c++){
+		const channel_stats *stats = &sensor_stats[c];
+		rtc_calendar min_at = seconds_to_calendar(stats->min_time);
+		rtc_calendar max_at = seconds_to_calendar(stats->max_time);
+
+		if(c == SERIES_TEMP){
+			LOG_WRITE(INFO_LOG, LOG_STATS_TEMP, stats_mean(stats), stats_stddev(stats));
+		} else if(c == SERIES_HUM){
+			LOG_WRITE(INFO_LOG, LOG_STATS_HUM, stats_mean(stats), stats_stddev(stats));
+		} else {
+			LOG_WRITE(INFO_LOG, LOG_STATS_ACCEL, 'X' + (c - SERIES_ACCEL_X), stats_mean(stats), stats_stddev(stats));
+		}
+		LOG_WRITE(INFO_LOG, LOG_STATS_MIN, stats->min, min_at.day, min_at.month, min_at.hour, min_at.minute);
+		LOG_WRITE(INFO_LOG, LOG_STATS_MAX, stats->max, max_at.day, max_at.month, max_at.hour, max_at.minute);
+
+		flush_UART_tx(UART_TX_FLUSH_MS);
+	}
+}
+
+typedef struct{
+	bool any;
+	int16_t temp_min;
+	int16_t temp_max;
+	int16_t hum_min;
+	int16_t hum_max;
+}logs_range;
+
+// Series records gathered by LOGS as LOG_MEM_SENSOR lines, a LOG_MEM_DATE line whenever
+// the day changes: a block from its anchor, or records whose anchor was overwritten back
+// from next, the anchor of the block after them. linked: the last block printed ends with
+// the sample this one starts with, updated for the next one
+static void log_series_block(const uint8_t *block, uint16_t len, uint16_t seq, bool anchored, const series_sample *next,
+							 bool *linked, logs_range *range){
+
+	series_decoder decoder;
+	series_sample sample;
+	uint8_t day = 0;
+	bool skip = anchored && *linked;
+	bool steps = false;
+
+	if(len == 0){
+		return;
+	}
+
+	if(anchored ? !series_open(&decoder, block, len, MEM_SERIES_CHUNK, MEM_SERIES_CHANNELS, MEM_SERIES_STEP) :
+			(next == NULL || !series_open_orphans(&decoder, block, len, MEM_SERIES_CHUNK, MEM_SERIES_CHANNELS, MEM_SERIES_STEP, next))){
+		LOG_WRITE(ERROR_LOG, LOG_MEM_ERROR, seq);
+		*linked = false;
+		return;
+	}
+
+	while(series_next(&decoder, &sample)){
+		rtc_calendar stamp = seconds_to_calendar(sample.time);
+		int16_t temp = sample.value[SERIES_TEMP];
+		int16_t hum = sample.value[SERIES_HUM];
+
+		if(skip){
+			skip = false;
+			continue;
+		}
+
+		if(stamp.day != day){
+			LOG_WRITE(INFO_LOG, LOG_MEM_DATE, seq, stamp.day, stamp.month, stamp.year + YEAR_COEF);
+			day = stamp.day;
+		}
+
+		// Block of a SERIES_LOSSY build: say how much was rounded away
+		if(!steps && (decoder.value_step[SERIES_TEMP] != 1 || decoder.value_step[SERIES_HUM] != 1)){
+			LOG_WRITE(INFO_LOG, LOG_MEM_STEPS, decoder.value_step[SERIES_TEMP] / CENTI, decoder.value_step[SERIES_TEMP] % CENTI,
+					decoder.value_step[SERIES_HUM] / CENTI, decoder.value_step[SERIES_HUM] % CENTI);
+			steps = true;
+		}
+		LOG_WRITE(INFO_LOG, LOG_MEM_SENSOR, stamp.hour, stamp.minute, (int)div_round(temp, CENTI), (unsigned)div_round(hum, CENTI));
+
+		if(!range->any || temp < range->temp_min) range->temp_min = temp;
+		if(!range->any || temp > range->temp_max) range->temp_max = temp;
+		if(!range->any || hum < range->hum_min) range->hum_min = hum;
+		if(!range->any || hum > range->hum_max) range->hum_max = hum;
+		range->any = true;
+
+		flush_UART_tx(UART_TX_FLUSH_MS);
+	}
+
+	*linked = decoder.linked;
+}
+
+// Anchor of a series block, false when it has none
+static bool series_anchor(const uint8_t *block, uint16_t len, series_sample *anchor){
+
+	series_decoder decoder;
+
+	return series_open(&decoder, block, len, MEM_SERIES_CHUNK, MEM_SERIES_CHANNELS, MEM_SERIES_STEP) &&
+		   series_next(&decoder, anchor);
+}
+
+// Read EEPROM records (oldest first) and send via DEBUG UART -> Extra: Send info to SD Card (Future updated PCB version ?)
 uint8_t state_print_logs(){
 
 	//ERROR_CODE = log_write(DEBUG_LOG, "Current State -> %d - %s", CURRENT_STATE, "LOGS");
 
 
-	// Print MIN and MAX values registered while functioning
+	mem_record record;
+	uint16_t count = mem_count();
+	logs_range range = {0};
+
+	// Series records gathered up to the next anchor: a block, or the rest of one
+	// whose anchor was overwritten
+	uint8_t block[MEM_SERIES_BLOCK];
+	uint16_t block_len = 0, block_seq = 0;
+	bool in_block = false;
+	bool linked = false;
+	series_sample anchor;
+
+	// The open block is read from RAM, its chunks already in EEPROM are skipped
+	uint8_t open_block[MEM_SERIES_BLOCK];
+	uint16_t open_seq = 0;
+	bool open_stored = false;
+	uint16_t open_len = mem_series_pending(open_block, &open_seq, &open_stored);
+
+	// Summary first: answered from RAM while the EEPROM dump follows
+	log_sensor_stats();
+
+	ERROR_CODE = LOG_WRITE(INFO_LOG, LOG_MEM_COUNT, count, MEM_SLOTS);
+
+	// Oldest first, flushed per record so the TX ring never drops lines
+	for(uint16_t i = 0; i < count; i++){
+		if(mem_read(i, &record) != NO_ERROR){
+			LOG_WRITE(ERROR_LOG, LOG_MEM_ERROR, i);
+
+			// What came before the gap still decodes from its anchor, what follows back from the next
+			log_series_block(block, block_len, block_seq, in_block, NULL, &linked, &range);
+			block_len = 0;
+			in_block = false;
+			linked = false;
+			continue;
+		}
+
+		if(record.type == MEM_SERIES_START || record.type == MEM_SERIES){
+			if(open_stored && (int16_t)(record.seq - open_seq) >= 0){
+				continue;
+			}
+
+			if(record.type == MEM_SERIES_START){
+				bool anchored = series_anchor(record.chunk, MEM_SERIES_CHUNK, &anchor);
+
+				log_series_block(block, block_len, block_seq, in_block, anchored ? &anchor : NULL, &linked, &range);
+				in_block = true;
+				block_len = 0;
+			}
+
+			if(block_len == 0){
+				block_seq = record.seq;
+			}
+			if(block_len + MEM_SERIES_CHUNK <= sizeof(block)){
+				memcpy(&block[block_len], record.chunk, MEM_SERIES_CHUNK);
+				block_len += MEM_SERIES_CHUNK;
+			}
+			continue;
+		}
+
+		if(record.type == MEM_EVENT){
+			rtc_calendar stamp = unpack_timestamp(record.timestamp);
+			// Temperature and humidity in centi units, the others raw (mg, INT_SOURCE bits)
+			bool centi = (record.event.code == MEM_EVENT_TEMP_ALERT || record.event.code == MEM_EVENT_HUM_ALERT);
+			int value = centi ? (int)div_round(record.event.value, CENTI) : record.event.value;
+
+			LOG_WRITE(INFO_LOG, LOG_MEM_DATE, record.seq, stamp.day, stamp.month, stamp.year + YEAR_COEF);
+			LOG_WRITE(WARNING_LOG, LOG_MEM_EVENT, stamp.hour, stamp.minute, record.event.code, value);
+			flush_UART_tx(UART_TX_FLUSH_MS);
+		}
+
+		if(record.type == MEM_CAPTURE){
+			rtc_calendar stamp = unpack_timestamp(record.timestamp);
+
+			LOG_WRITE(INFO_LOG, LOG_MEM_DATE, record.seq, stamp.day, stamp.month, stamp.year + YEAR_COEF);
+			LOG_WRITE(WARNING_LOG, LOG_MEM_CAPTURE, stamp.hour, stamp.minute, record.capture.source,
+					record.capture.peak * CAPTURE_MG_STEP);
+			LOG_WRITE(INFO_LOG, LOG_MEM_CAPTURE_AT, record.capture.peak_at * CAPTURE_SAMPLE_MS,
+					record.capture.disturbed * CAPTURE_SAMPLE_MS);
+			flush_UART_tx(UART_TX_FLUSH_MS);
+		}
+	}
 
+	// The open block is anchored after everything in EEPROM
+	bool anchored = open_len > 0 && series_anchor(open_block, open_len, &anchor);
 
-	NEXT_STATE = IDLE;
+	log_series_block(block, block_len, block_seq, in_block, anchored ? &anchor : NULL, &linked, &range);
+	log_series_block(open_block, open_len, open_seq, true, NULL, &linked, &range);
+
+	// Range of what the EEPROM holds, gathered during the dump
+	if(range.any){
+		ERROR_CODE = LOG_WRITE(INFO_LOG, LOG_MEM_RANGE, (int)div_round(range.temp_min, CENTI), (int)div_round(range.temp_max, CENTI),
+				(unsigned)div_round(range.hum_min, CENTI), (unsigned)div_round(range.hum_max, CENTI));
+	}
 
 	return ERROR_CODE;
 }
 
 
-// Clean EEPROM contents and reset pointer to start writing from position 0
+// Clean EEPROM contents, new records keep rotating from the current write position (wear levelling)
 uint8_t state_clean_memory(){
 
 	//ERROR_CODE = log_write(DEBUG_LOG, "Current State -> %d - %s", CURRENT_STATE, "CLEAN MEMORY");
 
-	NEXT_STATE = IDLE;
+	uint16_t count = mem_count();
+
+	ERROR_CODE = wipe_memory();
+	if(ERROR_CODE != NO_ERROR){
+		return ERROR_CODE;
+	}
+
+	ERROR_CODE = LOG_WRITE(INFO_LOG, LOG_MEM_WIPED, count);
+
+	return ERROR_CODE;
+}
+
+
+// ADXL343 shock / free fall, served as soon as it is posted: stored once per
+// event (as its capture, by COMMS), then DATA_READ reads the window around
+// it and COMMS sends it at once
+uint8_t state_shock(){
+
+	ERROR_CODE = LOG_WRITE(DEBUG_LOG, LOG_STATE_SHOCK, CURRENT_STATE);
+
+	// Inside a capture window the capture's record stands for it, see store_capture()
+	if(!capture_collecting()){
+		mem_record record = {.type = MEM_EVENT, .timestamp = get_timestamp(NULL)};
+
+		record.event.code = MEM_EVENT_SHOCK;
+		record.event.arg = shock_source;
+		record.event.value = 0;
+		ERROR_CODE = mem_write(&record);
+	}
+
+	if(shock_source & ADXL343_INT_SINGLE_TAP){
+		LOG_WRITE(WARNING_LOG, LOG_SHOCK);
+	}
+	if(shock_source & ADXL343_INT_FREE_FALL){
+		LOG_WRITE(WARNING_LOG, LOG_FREE_FALL);
+	}
+
+	shock_source = 0;
+	flag_anomaly_shock = true;
 
 	return ERROR_CODE;
 }
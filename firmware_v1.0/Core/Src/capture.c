@@ -0,0 +1,126 @@
+/*
+ * capture.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: dst2001055
+ */
+
+#include <string.h>
+#include "capture.h"
+#include "sensors.h"
+
+enum capture_states{
+	CAPTURE_IDLE,
+	CAPTURE_COLLECTING,		// pre-trigger part frozen, filling the rest
+	CAPTURE_READY			// complete, waiting for capture_take()
+};
+
+// |a|^2 in LSB^2: three squared int16 stay inside 32 bits, the square root is
+// left to capture_take() so serve_sensors() only multiplies per entry
+static uint32_t capture_ring[CAPTURE_PRE];
+static uint8_t capture_ring_pos = 0;
+static uint8_t capture_ring_count = 0;
+
+static uint32_t capture_sq[CAPTURE_SAMPLES];
+static uint8_t capture_len = 0;
+static uint8_t capture_state = CAPTURE_IDLE;
+static uint32_t capture_tick = 0;
+static uint8_t capture_source = 0;
+
+void capture_reset(){
+
+	capture_ring_pos = 0;
+	capture_ring_count = 0;
+	capture_len = 0;
+	capture_state = CAPTURE_IDLE;
+}
+
+// From serve_sensors(), one FIFO entry at a time
+void capture_add(const int16_t raw[3]){
+
+	uint32_t sq = 0;
+
+	for(uint8_t axis = 0; axis < 3; axis++){
+		sq += (uint32_t)(raw[axis] * raw[axis]);
+	}
+
+	capture_ring[capture_ring_pos] = sq;
+	capture_ring_pos = (capture_ring_pos + 1) % CAPTURE_PRE;
+	if(capture_ring_count < CAPTURE_PRE){
+		capture_ring_count++;
+	}
+
+	if(capture_state == CAPTURE_COLLECTING){
+		capture_sq[capture_len++] = sq;
+		if(capture_len == CAPTURE_SAMPLES){
+			capture_state = CAPTURE_READY;
+		}
+	}
+}
+
+// From serve_sensors(), after the drain that ends at the trigger. False if
+// the sources hold no trigger, a window is still open, or the ring is not
+// full yet (the first CAPTURE_PRE samples after config)
+bool capture_trigger(uint8_t source){
+
+	if(!(source & CAPTURE_TRIGGER_INTS) || capture_state != CAPTURE_IDLE || capture_ring_count < CAPTURE_PRE){
+		return false;
+	}
+
+	// Oldest first: the next ring slot is the oldest entry
+	for(uint8_t i = 0; i < CAPTURE_PRE; i++){
+		capture_sq[i] = capture_ring[(capture_ring_pos + i) % CAPTURE_PRE];
+	}
+
+	capture_len = CAPTURE_PRE;
+	capture_tick = HAL_GetTick();
+	capture_source = source & CAPTURE_TRIGGER_INTS;
+	capture_state = CAPTURE_COLLECTING;
+
+	return true;
+}
+
+// The INT1 collector keeps the watermark on while this holds
+bool capture_collecting(){
+
+	return capture_state == CAPTURE_COLLECTING;
+}
+
+// Complete window -> summary in *window, which frees the capture for the
+// next trigger
+bool capture_take(capture_window *window){
+
+	uint32_t sq[CAPTURE_SAMPLES];
+
+	if(capture_state != CAPTURE_READY){
+		return false;
+	}
+
+	memcpy(sq, capture_sq, sizeof(sq));
+	window->tick = capture_tick;
+	window->source = capture_source;
+	capture_state = CAPTURE_IDLE;
+
+	uint32_t peak = 0;
+	uint8_t peak_index = 0;
+
+	window->disturbed = 0;
+
+	for(uint8_t i = 0; i < CAPTURE_SAMPLES; i++){
+		uint32_t mg = isqrt_round(sq[i]) * ACCEL_MG_PER_LSB;
+
+		if(mg > peak){
+			peak = mg;
+			peak_index = i;
+		}
+		if(mg >= CAPTURE_REST_MG + CAPTURE_DISTURBED_MG || mg + CAPTURE_DISTURBED_MG <= CAPTURE_REST_MG){
+			window->disturbed++;
+		}
+	}
+
+	peak = (peak + CAPTURE_MG_STEP / 2) / CAPTURE_MG_STEP;
+	window->peak = (peak > UINT8_MAX) ? UINT8_MAX : (uint8_t)peak;
+	window->peak_at = (int8_t)(peak_index - CAPTURE_PRE);
+
+	return true;
+}
@@ -0,0 +1,119 @@
+/*
+ * frame.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: dst2001055
+ */
+
+#include "frame.h"
+
+#define CRC16_INIT 0xFFFF
+
+// Nibble table: 32 bytes of flash instead of 512 for the byte-wise one
+static const uint16_t crc16_nibble[16] = {
+	0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50A5, 0x60C6, 0x70E7,
+	0x8108, 0x9129, 0xA14A, 0xB16B, 0xC18C, 0xD1AD, 0xE1CE, 0xF1EF
+};
+
+//----------------------------------------- CRC --------------------------------------------------------
+
+// Pass CRC16_INIT-seeded results back in to checksum a message in pieces
+uint16_t crc16_ccitt(const uint8_t *data, uint16_t len, uint16_t crc){
+
+	for(uint16_t i = 0; i < len; i++){
+		crc = (crc << 4) ^ crc16_nibble[(crc >> 12) ^ (data[i] >> 4)];
+		crc = (crc << 4) ^ crc16_nibble[(crc >> 12) ^ (data[i] & 0x0F)];
+	}
+	return crc;
+}
+
+//----------------------------------------- FRAMING ----------------------------------------------------
+
+// payload must have FRAME_CRC_SIZE spare bytes after len: the CRC is
+// appended in place (big endian) before encoding.
+// Returns the encoded size including both delimiters, 0 if out is too small
+uint16_t encode_frame(uint8_t *payload, uint16_t len, uint8_t *out, uint16_t out_size){
+
+	uint16_t crc = crc16_ccitt(payload, len, CRC16_INIT);
+	uint16_t code_pos = 1;
+	uint16_t pos = 2;
+	uint8_t code = 1;
+
+	payload[len++] = (uint8_t)(crc >> 8);
+	payload[len++] = (uint8_t)crc;
+
+	if(out_size < len + len / 254 + 3){
+		return 0;
+	}
+
+	out[0] = FRAME_DELIM;
+
+	for(uint16_t i = 0; i < len; i++){
+		if(payload[i] == FRAME_DELIM){
+			out[code_pos] = code;
+			code_pos = pos++;
+			code = 1;
+			continue;
+		}
+
+		out[pos++] = payload[i];
+
+		if(++code == 0xFF){
+			out[code_pos] = code;
+			code_pos = pos++;
+			code = 1;
+		}
+	}
+
+	out[code_pos] = code;
+	out[pos++] = FRAME_DELIM;
+
+	return pos;
+}
+
+//----------------------------------------- VARINT -----------------------------------------------------
+
+// LEB128: 7 bits per byte, MSB set on all but the last
+uint8_t put_varint(uint8_t *buf, uint32_t value){
+
+	uint8_t n = 0;
+
+	while(value >= 0x80){
+		buf[n++] = (uint8_t)(value | 0x80);
+		value >>= 7;
+	}
+	buf[n++] = (uint8_t)value;
+
+	return n;
+}
+
+// Reads one varint at *pos and advances it. False if truncated or longer than 32 bits
+bool get_varint(const uint8_t *buf, uint16_t len, uint16_t *pos, uint32_t *value){
+
+	uint32_t result = 0;
+
+	for(uint8_t shift = 0; shift < 7 * VARINT_MAX_SIZE; shift += 7){
+		if(*pos >= len){
+			return false;
+		}
+
+		uint8_t byte = buf[(*pos)++];
+
+		result |= (uint32_t)(byte & 0x7F) << shift;
+		if(!(byte & 0x80)){
+			*value = result;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+// Small negative numbers stay short: 0, -1, 1, -2 ... -> 0, 1, 2, 3 ...
+uint32_t zigzag_encode(int32_t value){
+	return ((uint32_t)value << 1) ^ (uint32_t)(value >> 31);
+}
+
+int32_t zigzag_decode(uint32_t value){
+	return (int32_t)(value >> 1) ^ -(int32_t)(value & 1);
+}
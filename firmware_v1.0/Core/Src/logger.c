@@ -27,70 +27,202 @@ log_struct const log_list[8] = {
 	{WARNING_LOG,"WARNING", reg_colors[3]},
 };
 
-uint8_t log_write(uint8_t log_type, const char* log_msg, ...){
+// Deferred builds keep only the IDs, the text stays on the host
+#if !LOG_DEFERRED
+#define LOG_STRING_FMT(id, fmt) fmt,
 
-	char systemTime_Date 	[BUFFER_SIZE1] = {0};
-	char log_msg_buffer  	[BUFFER_SIZE1] = {0};
-	char debug_msg_buffer	[BUFFER_SIZE2] = {0};
-	char formatted_log_msg	[BUFFER_SIZE2] = {0};
+const char* const log_strings[LOG_STRING_COUNT] = {
+	LOG_STRING_TABLE(LOG_STRING_FMT)
+};
+#endif
 
-	//DEBUG TODO: REMOVE
-	//rtc_calendar timestamp;
+// Appends src to the line, cut like snprintf() at size - 1 characters
+static void log_append(char *line, uint16_t *len, uint16_t size, const char *src){
 
-//	TODO: Fix - Add RTC functionality
-	rtc_calendar timestamp = get_sys_time();
-	if(timestamp.day == RTC_RETURN_ERR){
-		return RTC_TIME_ERROR;
+	while(*src != '\0' && *len < size - 1){
+		line[(*len)++] = *src++;
 	}
+	line[*len] = '\0';
+}
 
-	const char* color_code = log_list[log_type].color_info.code;
+// "%0<width>d" for the timestamp fields, without going through printf
+static void log_append_dec(char *line, uint16_t *len, uint16_t size, uint16_t value, uint8_t width){
 
-	va_list args;
-	va_start(args, log_msg);
+	char digits[5];
+	uint8_t n = 0;
 
-	vsnprintf(log_msg_buffer, sizeof(log_msg_buffer), log_msg, args);
+	do{
+		digits[n++] = (char)('0' + value % 10);
+		value /= 10;
+	}while(value > 0);
 
+	while(n < width){
+		digits[n++] = '0';
+	}
 
-	//TODO: if its a log for BLE module -> send info in a specific format
+	while(n > 0 && *len < size - 1){
+		line[(*len)++] = digits[--n];
+	}
+	line[*len] = '\0';
+}
+
+// One line in one buffer: the message keeps its BUFFER_SIZE1 limit and the
+// whole line its BUFFER_SIZE2 one, only vsnprintf() sees the arguments
+uint8_t log_write(uint8_t log_type, const char* log_msg, ...){
+
+	char line[BUFFER_SIZE2];
+	uint16_t len = 0;
+
+	uint16_t timestamp_ms;
+	rtc_calendar timestamp = get_cached_time(&timestamp_ms);
+	if(timestamp.day == RTC_RETURN_ERR){
+		return RTC_TIME_ERROR;
+	}
 
+	//TODO: if its a log for BLE module -> send info in a specific format
 
 //------------------------------------------ Debug UART log print ------------------------------------------
 
 	// Message with colors for PuTTY terminal
 	// Log Type + Log message formated
+	log_append(line, &len, sizeof(line), log_list[log_type].color_info.code);
+	log_append(line, &len, sizeof(line), "[");
+	log_append(line, &len, sizeof(line), log_list[log_type].name_type);
+	log_append(line, &len, sizeof(line), "] ");
+
+	uint16_t room = sizeof(line) - len;
+	if(room > BUFFER_SIZE1){
+		room = BUFFER_SIZE1;
+	}
 
-	snprintf(formatted_log_msg, sizeof(formatted_log_msg), "%s[%s] %s%s", color_code, log_list[log_type].name_type, log_msg_buffer, RESET_COLOR);
-
-	//DEBUG TODO: REMOVE
-//	timestamp.hour = 0;
-//	timestamp.minute = 0;
-//	timestamp.second = 0;
-//	timestamp.day = 19;
-//	timestamp.month = 8;
-//	timestamp.year = 25;
-
-//	// Timestamp formated
-	snprintf(systemTime_Date, sizeof(systemTime_Date), " @ %02d:%02d:%02d - %02d/%02d/%02d\r\n",
-			timestamp.hour, timestamp.minute, timestamp.second,
-			timestamp.day, timestamp.month, timestamp.year + YEAR_COEF);
+	va_list args;
+	va_start(args, log_msg);
+	int written = vsnprintf(&line[len], room, log_msg, args);
+	va_end(args);
 
-	// Debug message concatenated
-	snprintf(debug_msg_buffer, sizeof(debug_msg_buffer), "%s%s", formatted_log_msg, systemTime_Date);
+	if(written > 0){
+		len += (written < room) ? (uint16_t)written : room - 1;
+	}
+	line[len] = '\0';
+
+	log_append(line, &len, sizeof(line), RESET_COLOR);
+
+	// Timestamp formated
+	log_append(line, &len, sizeof(line), " @ ");
+	log_append_dec(line, &len, sizeof(line), timestamp.hour, 2);
+	log_append(line, &len, sizeof(line), ":");
+	log_append_dec(line, &len, sizeof(line), timestamp.minute, 2);
+	log_append(line, &len, sizeof(line), ":");
+	log_append_dec(line, &len, sizeof(line), timestamp.second, 2);
+	log_append(line, &len, sizeof(line), ".");
+	log_append_dec(line, &len, sizeof(line), timestamp_ms, 3);
+	log_append(line, &len, sizeof(line), " - ");
+	log_append_dec(line, &len, sizeof(line), timestamp.day, 2);
+	log_append(line, &len, sizeof(line), "/");
+	log_append_dec(line, &len, sizeof(line), timestamp.month, 2);
+	log_append(line, &len, sizeof(line), "/");
+	log_append_dec(line, &len, sizeof(line), timestamp.year + YEAR_COEF, 2);
+	log_append(line, &len, sizeof(line), "\r\n");
 
 	// Send message to desired UART
-	const char* debug_msg = debug_msg_buffer;
-	ERROR_CODE = send_UART_msg(DEBUG_UART_NUM, debug_msg);
+	ERROR_CODE = send_UART_data(DEBUG_UART_NUM, (const uint8_t *)line, len);
 	if(ERROR_CODE != NO_ERROR){
 		return ERROR_CODE;
 	}
 
-// ------------------------------- Store log in EEPROM -> only if INFO or ERROR log ------------------------------------------
+// ------------------------------- EEPROM ------------------------------------------
+	// No text in EEPROM: the states store packed mem_record entries (mem_write())
+
+	return ERROR_CODE;
+}
+
+// Binary log record, see BAT_Decoder.py:
+//   [FRAME_TYPE_LOG][log_type << 4 | nargs][id varint][timestamp 4B][ms varint][args zigzag varint...]
+uint8_t log_record(uint8_t log_type, uint16_t id, uint8_t nargs, ...){
 
-	if(log_type == ERROR_LOG || log_type == INFO_LOG){
-		//TODO: log_eeprom()
+	uint8_t record[LOG_RECORD_SIZE + FRAME_CRC_SIZE];
+	uint8_t frame[FRAME_MAX_ENCODED];
+	uint8_t len = 0;
+
+	uint16_t timestamp_ms;
+	rtc_calendar timestamp = get_cached_time(&timestamp_ms);
+	if(timestamp.day == RTC_RETURN_ERR){
+		return RTC_TIME_ERROR;
+	}
+
+	if(nargs > LOG_MAX_ARGS){
+		nargs = LOG_MAX_ARGS;
+	}
+
+	uint32_t packed_time = pack_timestamp(timestamp);
+
+	record[len++] = FRAME_TYPE_LOG;
+	record[len++] = (uint8_t)((log_type << 4) | nargs);
+	len += put_varint(&record[len], id);
+	record[len++] = (uint8_t)(packed_time >> 24);
+	record[len++] = (uint8_t)(packed_time >> 16);
+	record[len++] = (uint8_t)(packed_time >> 8);
+	record[len++] = (uint8_t)packed_time;
+	len += put_varint(&record[len], timestamp_ms);
+
+	va_list args;
+	va_start(args, nargs);
+
+	for(uint8_t i = 0; i < nargs; i++){
+		len += put_varint(&record[len], zigzag_encode((int32_t)va_arg(args, int)));
 	}
 
 	va_end(args);
 
+	uint16_t frame_len = encode_frame(record, len, frame, sizeof(frame));
+
+	ERROR_CODE = send_UART_data(DEBUG_UART_NUM, frame, frame_len);
+
+	return ERROR_CODE;
+}
+
+// Telemetry record, see BAT_Signal.py. seq counts readings so the host sees a lost frame:
+//   [FRAME_TYPE_TELEMETRY][seq u16 LE][flags][timestamp 4B][ms varint][temp zz][hum][x zz][y zz][z zz]
+_Static_assert(FRAME_ENCODED_SIZE(TELEMETRY_RECORD_SIZE) <= UART_TX_RESERVE, "telemetry frame larger than UART_TX_RESERVE");
+
+uint8_t log_telemetry(const telemetry_record *reading){
+
+	static uint16_t seq = 0;
+
+	uint8_t record[TELEMETRY_RECORD_SIZE + FRAME_CRC_SIZE];
+	uint8_t frame[FRAME_ENCODED_SIZE(TELEMETRY_RECORD_SIZE)];
+	uint8_t len = 0;
+
+	uint16_t timestamp_ms;
+	rtc_calendar timestamp = get_cached_time(&timestamp_ms);
+	if(timestamp.day == RTC_RETURN_ERR){
+		return RTC_TIME_ERROR;
+	}
+
+	uint32_t packed_time = pack_timestamp(timestamp);
+
+	record[len++] = FRAME_TYPE_TELEMETRY;
+	record[len++] = (uint8_t)seq;
+	record[len++] = (uint8_t)(seq >> 8);
+	record[len++] = reading->flags;
+	record[len++] = (uint8_t)(packed_time >> 24);
+	record[len++] = (uint8_t)(packed_time >> 16);
+	record[len++] = (uint8_t)(packed_time >> 8);
+	record[len++] = (uint8_t)packed_time;
+	len += put_varint(&record[len], timestamp_ms);
+	len += put_varint(&record[len], zigzag_encode(reading->temp));
+	len += put_varint(&record[len], reading->hum);
+	for(uint8_t a = 0; a < 3; a++){
+		len += put_varint(&record[len], zigzag_encode(reading->accel[a]));
+	}
+
+	seq++;
+
+	uint16_t frame_len = encode_frame(record, len, frame, sizeof(frame));
+
+	// Into the space the text lines leave free: queued without waiting, and
+	// never the one dropped when a DATA_READ burst fills the ring
+	ERROR_CODE = send_UART_priority(frame, frame_len);
+
 	return ERROR_CODE;
 }
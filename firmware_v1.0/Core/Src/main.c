@@ -18,6 +18,7 @@
 /* USER CODE END Header */
 /* Includes ------------------------------------------------------------------*/
 #include "main.h"
+#include "dma.h"
 #include "i2c.h"
 #include "usart.h"
 #include "rtc.h"
@@ -51,7 +52,6 @@
 uint8_t volatile button_counter = 0;
 uint32_t current_millisecs = 0, last_debounce_time = 0;
 bool flag_timer_on = false;
-extern enum states NEXT_STATE;
 /* USER CODE END PV */
 
 /* Private function prototypes -----------------------------------------------*/
@@ -103,20 +103,47 @@ void HAL_GPIO_EXTI_Callback(uint16_t GPIO_Pin){
 	// Check T+H Sensor INT source
 	if(GPIO_Pin == INT_HDC2080_PIN){
 
-		//TODO: Testing purpose only
-		//log_write(WARNING_LOG, "INT SENSOR GENERATED");
-
-		// Disable T+H Sensor INT -> Re-Enable in IDLE State -> 5 PULSES GENERATED IN EACH INTERRUPT -> clear flag after first INT
+#if HDC2080_AMM_MODE
+		// DRDY every conversion: read the result in the background, the
+		// collector posts EVENT_TH_THRESHOLD on TH/HH
+		collect_temp_hum();
+#else
+		// Thresholds bits (Temp High || Hum High) are read by the FSM, no I2C here
+		post_event(EVENT_SENSOR_INT, 0);
+#endif
+	}
 
-		// Check Thresholds bits (Temp High || Hum High)
-		if(check_threshold_active()){
-			NEXT_STATE = ANOMALY;
-		} else {
-			NEXT_STATE = IDLE;
-		}
+	// ADXL343 INT1 -> FIFO watermark
+	if(GPIO_Pin == INT_ADXL343_PIN){
+		collect_accel();
 	}
 }
 
+void HAL_UART_TxCpltCallback(UART_HandleTypeDef *huart){
+	UART_tx_complete(huart);
+}
+
+// I2C engine: every transfer ends in one of these
+void HAL_I2C_MasterTxCpltCallback(I2C_HandleTypeDef *hi2c){
+	I2C_xfer_complete(hi2c, NO_ERROR);
+}
+
+void HAL_I2C_MasterRxCpltCallback(I2C_HandleTypeDef *hi2c){
+	I2C_xfer_complete(hi2c, NO_ERROR);
+}
+
+void HAL_I2C_MemTxCpltCallback(I2C_HandleTypeDef *hi2c){
+	I2C_xfer_complete(hi2c, NO_ERROR);
+}
+
+void HAL_I2C_MemRxCpltCallback(I2C_HandleTypeDef *hi2c){
+	I2C_xfer_complete(hi2c, NO_ERROR);
+}
+
+void HAL_I2C_ErrorCallback(I2C_HandleTypeDef *hi2c){
+	I2C_xfer_complete(hi2c, I2C_ERROR);
+}
+
 // TIMER CALLBACK
 // De 1 em 1 segundos checkar o valor do button counter e apos avaliar fazer reset
 void HAL_TIM_PeriodElapsedCallback(TIM_HandleTypeDef *htim){
@@ -130,24 +157,8 @@ void HAL_TIM_PeriodElapsedCallback(TIM_HandleTypeDef *htim){
 
 		//log_write(WARNING_LOG, "INT time - %u", button_counter);
 
-		switch(button_counter){
-			case 1:
-				NEXT_STATE = DATA_READ;
-				break;
-			case 2:
-				NEXT_STATE = LOGS;
-				break;
-			case 3:
-				NEXT_STATE = RECONNECT;
-				break;
-			case 5:
-				NEXT_STATE = CLEAN_MEM;
-				break;
-			default:
-				//log_write(WARNING_LOG, "Redirecting to IDLE...");
-				NEXT_STATE = IDLE;
-				break;
-		}
+		// Gesture -> state mapping lives in the FSM (the on_button rows in app.c)
+		post_event(EVENT_BUTTON, button_counter);
 		button_counter = 0;
 	}
 }
@@ -182,15 +193,17 @@ int main(void)
 
   /* Initialize all configured peripherals */
   MX_GPIO_Init();
+  MX_DMA_Init();
   MX_I2C1_Init();
   MX_LPUART1_UART_Init();
+  MX_USART2_UART_Init();
   MX_RTC_Init();
   MX_TIM21_Init();
   /* USER CODE BEGIN 2 */
 
   init_device();
 
-  log_write(INFO_LOG, "------------ BAT-MON v1 startup ------------");
+  LOG_WRITE(INFO_LOG, LOG_STARTUP);
 
 
   /* USER CODE END 2 */
@@ -203,10 +216,10 @@ int main(void)
 
     /* USER CODE BEGIN 3 */
 	  HAL_GPIO_TogglePin(GPIOA, USER_LED_PIN);	//heartbeat
-	  HAL_Delay(300);
+	  app_wait(300);
 	  HAL_GPIO_TogglePin(GPIOA, USER_LED_PIN);	//heartbeat
 	  app_fsm();
-	  HAL_Delay(APP_DELAY);
+	  app_wait(APP_DELAY);		// STOP between states, see enter_stop_mode()
 
 
   }
@@ -6,6 +6,7 @@
  */
 
 #include "mal.h"
+#include "frame.h"
 
 HAL_StatusTypeDef system_status = HAL_OK;
 
@@ -13,31 +14,364 @@ enum errorTypes ERROR_CODE = NO_ERROR;
 
 extern bool flag_timer_on;
 
+// Debug UART TX ring, drained by DMA. head/tail run free and wrap at 2^16
+static uint8_t uart_tx_buf[UART_TX_BUF_SIZE];
+static volatile uint16_t uart_tx_head = 0;
+static volatile uint16_t uart_tx_tail = 0;
+static volatile uint16_t uart_tx_in_flight = 0;		// 0 -> DMA idle
+
+static uart_tx_stats uart_tx_counters = {0};
+
+// Wall clock cache: the RTC is read once per wake-up and HAL_GetTick()
+// carries it forward. SysTick stops in stop mode, so latch again on every wake
+static rtc_calendar cached_time;
+static uint32_t cached_tick = 0;		// HAL_GetTick() at the start of cached_time's second
+static bool cached_valid = false;
+
+// I2C transaction engine: jobs wait in a ring of pointers and the one at the
+// tail owns the bus, stepping through its transfers from the I2C interrupt
+static i2c_job *i2c_queue[I2C_QUEUE_LEN];
+static volatile uint8_t i2c_queue_head = 0;
+static volatile uint8_t i2c_queue_tail = 0;
+static volatile bool i2c_busy = false;
+static uint8_t i2c_xfer_index = 0;
+static uint8_t i2c_job_error = NO_ERROR;
+static uint32_t i2c_xfer_start_us = 0;
+
+static const uint16_t i2c_dev_addr[I2C_DEV_COUNT] = {HDC2080_ADDR, ADXL343_ADDR};
+
+// ISR -> FSM event queue: interrupts (all at EVENT_IRQ_PRIORITY, so they never
+// preempt each other) are the only producer and write head, app_fsm() is the
+// only consumer and writes tail. head/tail run free and wrap at 2^8
+static app_event event_queue[EVENT_QUEUE_LEN];
+static volatile uint8_t event_head = 0;
+static volatile uint8_t event_tail = 0;
+static volatile uint8_t event_type_posted[EVENT_TYPE_COUNT];	// producer only
+static volatile uint8_t event_type_popped[EVENT_TYPE_COUNT];	// consumer only
+static event_queue_stats event_counters = {0};
+static i2c_dev_stats i2c_counters[I2C_DEV_COUNT] = {0};
+
+// Data EEPROM record store: an append-only ring of MEM_SLOTS records. Writes
+// walk the whole region in turn, so every word wears at the same rate
+static uint16_t mem_head = 0;			// next slot to write
+static uint16_t mem_records = 0;		// valid records behind the head
+static uint16_t mem_next_seq = 0;
+
+_Static_assert(sizeof(mem_record) == MEM_RECORD_SIZE, "mem_record must fill whole EEPROM words");
+
+// Sensor series block being built. Each full MEM_SERIES_CHUNK goes to the
+// EEPROM as soon as it fills, so a reset loses less than one chunk of samples
+static uint8_t mem_series_buf[MEM_SERIES_BLOCK];
+static series_encoder mem_series;
+static bool mem_series_open = false;
+static uint16_t mem_series_stored = 0;		// block bytes already in EEPROM
+static uint16_t mem_series_seq = 0;			// seq of the block's MEM_SERIES_START
+
+typedef struct{
+	volatile bool done;
+	volatile uint8_t error;
+}i2c_wait;
+
 //----------------------------------------- SYSTEM -----------------------------------------------------
 void wait_delay(uint32_t ms){
 	HAL_Delay(ms);
 }
 
+// Tickless wait_delay(): STOP on the RTC wake-up timer until ms have passed.
+// EXTI wake-ups (button, sensor INT) are served and STOP is entered again;
+// while STOP would freeze something (I2C job, UART DMA, button timer) or
+// little time is left, sleep with WFI instead. Returns early once an event is
+// queued, so the FSM serves it within the interrupt latency, not APP_DELAY
+void idle_delay(uint32_t ms){
+
+	uint32_t deadline = HAL_GetTick() + ms;
+	int32_t remaining;
+
+	while((remaining = (int32_t)(deadline - HAL_GetTick())) > 0 && event_head == event_tail){
+		if(enter_stop_mode(remaining) != NO_ERROR){
+			__WFI();
+		}
+	}
+}
+
+// Microseconds from HAL_GetTick() and the SysTick down-counter. Wraps every
+// ~71 min, so only use it for intervals
+uint32_t get_tick_us(){
+
+	uint32_t load = SysTick->LOAD + 1;
+	uint32_t tick, val;
+	bool wrapped;
+
+	// Re-read if the SysTick interrupt hit between the two reads
+	do{
+		tick = HAL_GetTick();
+		val = SysTick->VAL;
+		wrapped = (SCB->ICSR & SCB_ICSR_PENDSTSET_Msk) != 0;
+	}while(tick != HAL_GetTick());
+
+	// With interrupts masked, or from an ISR above TICK_INT_PRIORITY, a wrap
+	// stays pending and uwTick is a tick behind: VAL read after the flag is
+	// past the wrap for sure
+	if(wrapped){
+		val = SysTick->VAL;
+		tick++;
+	}
+
+	return tick * 1000 + ((load - 1 - val) * 1000) / load;
+}
+
+//----------------------------------------- EVENTS -----------------------------------------------------
+
+// Producer side. No locks from an ISR, which is only sound while every
+// caller's IRQ sits at EVENT_IRQ_PRIORITY; from thread context (an I2C job
+// that failed to start calls its done() there) interrupts are masked so the
+// queue keeps a single producer. Returns false if the queue is full or the
+// type unknown
+bool post_event(uint8_t type, uint8_t value){
+
+	uint32_t primask = __get_PRIMASK();
+	bool thread = (__get_IPSR() == 0);
+
+	if(type >= EVENT_TYPE_COUNT){
+		return false;
+	}
+
+	if(thread){
+		__disable_irq();
+	}
+
+	uint8_t head = event_head;
+	uint8_t used = (uint8_t)(head - event_tail);
+	bool posted = (used < EVENT_QUEUE_LEN);
+
+	if(posted){
+		app_event *slot = &event_queue[head & (EVENT_QUEUE_LEN - 1)];
+
+		slot->type = type;
+		slot->value = value;
+		slot->tick = HAL_GetTick();
+
+		// Slot contents before the index that publishes them
+		__DMB();
+		event_head = head + 1;
+
+		event_type_posted[type]++;
+		event_counters.posted++;
+		if(used + 1 > event_counters.high_water){
+			event_counters.high_water = used + 1;
+		}
+	} else {
+		event_counters.dropped++;
+	}
+
+	if(thread){
+		__set_PRIMASK(primask);
+	}
+
+	return posted;
+}
+
+// Consumer side (app_fsm() only). Returns false once the queue is empty
+bool pop_event(app_event *event){
+
+	uint8_t tail = event_tail;
+
+	if(tail == event_head){
+		return false;
+	}
+
+	__DMB();
+	*event = event_queue[tail & (EVENT_QUEUE_LEN - 1)];
+	__DMB();
+	event_tail = tail + 1;
+
+	event_type_popped[event->type]++;
+
+	uint32_t latency = HAL_GetTick() - event->tick;
+	if(latency > event_counters.max_latency_ms){
+		event_counters.max_latency_ms = latency;
+	}
+
+	return true;
+}
+
+// An event of this type is queued and not served yet. Level sources (a
+// threshold that stays crossed) check it so they don't fill the queue
+bool event_pending(uint8_t type){
+	return type < EVENT_TYPE_COUNT && event_type_posted[type] != event_type_popped[type];
+}
+
+event_queue_stats get_event_stats(){
+	return event_counters;
+}
+
 //----------------------------------------- COMMS ------------------------------------------------------
+
+// Start DMA on the oldest contiguous block of the ring. Called with
+// interrupts masked or from the TX complete interrupt
+static HAL_StatusTypeDef uart_tx_kick(){
+
+	uint16_t pending = uart_tx_head - uart_tx_tail;
+	uint16_t start = uart_tx_tail & (UART_TX_BUF_SIZE - 1);
+	uint16_t len = UART_TX_BUF_SIZE - start;
+
+	if(pending == 0){
+		uart_tx_in_flight = 0;
+		return HAL_OK;
+	}
+
+	if(len > pending){
+		len = pending;
+	}
+
+	uart_tx_in_flight = len;
+
+	HAL_StatusTypeDef status = HAL_UART_Transmit_DMA(DEBUG_UART, &uart_tx_buf[start], len);
+	if(status != HAL_OK){
+		uart_tx_in_flight = 0;
+		return status;
+	}
+
+	uart_tx_counters.dma_transfers++;
+	return HAL_OK;
+}
+
+// reserve: bytes that must stay free behind the message, kept for priority frames.
+// A message that does not fit is dropped whole, counted, and DEBUG_UART_ERROR
+// tells the caller
+static uint8_t uart_tx_queue(const uint8_t *data, uint16_t len, uint16_t reserve){
+
+	uint8_t error = NO_ERROR;
+
+	// log_write() also runs from interrupt callbacks
+	uint32_t primask = __get_PRIMASK();
+	__disable_irq();
+
+	uint16_t used = uart_tx_head - uart_tx_tail;
+
+	if(len + reserve > UART_TX_BUF_SIZE - used){
+		uart_tx_counters.bytes_dropped += len;
+		uart_tx_counters.messages_dropped++;
+		__set_PRIMASK(primask);
+		return DEBUG_UART_ERROR;
+	}
+
+	uint16_t start = uart_tx_head & (UART_TX_BUF_SIZE - 1);
+	uint16_t first = UART_TX_BUF_SIZE - start;
+
+	if(first > len){
+		first = len;
+	}
+
+	memcpy(&uart_tx_buf[start], data, first);
+	memcpy(uart_tx_buf, data + first, len - first);
+	uart_tx_head += len;
+
+	uart_tx_counters.bytes_queued += len;
+	if(used + len > uart_tx_counters.high_water){
+		uart_tx_counters.high_water = used + len;
+	}
+
+	if(uart_tx_in_flight == 0 && uart_tx_kick() != HAL_OK){
+		error = DEBUG_UART_ERROR;
+	}
+
+	__set_PRIMASK(primask);
+	return error;
+}
+
+// TX complete interrupt: release the block that was sent and chain the next
+void UART_tx_complete(UART_HandleTypeDef *huart){
+
+	if(huart != DEBUG_UART){
+		return;
+	}
+
+	uart_tx_tail += uart_tx_in_flight;
+	uart_tx_kick();
+}
+
+// Wait for the debug ring to drain, e.g. before stop mode gates the UART clocks
+uint8_t flush_UART_tx(uint32_t timeout_ms){
+
+	uint32_t start = HAL_GetTick();
+
+	while(uart_tx_head != uart_tx_tail){
+		if(HAL_GetTick() - start >= timeout_ms){
+			return DEBUG_UART_ERROR;
+		}
+
+		// Restart a drain that failed to start from uart_tx_queue()
+		if(uart_tx_in_flight == 0){
+			uint32_t primask = __get_PRIMASK();
+			__disable_irq();
+			uart_tx_kick();
+			__set_PRIMASK(primask);
+		}
+		__WFI();
+	}
+
+	return NO_ERROR;
+}
+
+uart_tx_stats get_UART_tx_stats(){
+	return uart_tx_counters;
+}
+
+// A frame handed to send_UART_data(COMMS_UART_NUM) is still on the wire
+bool comms_UART_busy(){
+	return (COMMS_UART)->gState != HAL_UART_STATE_READY;
+}
+
+// Wait for the COMMS frame on the wire, before its buffer is rewritten
+uint8_t wait_comms_UART(uint32_t timeout_ms){
+
+	uint32_t start = HAL_GetTick();
+
+	while(comms_UART_busy()){
+		if(HAL_GetTick() - start >= timeout_ms){
+			return COMMS_ERROR;
+		}
+		__WFI();
+	}
+
+	return NO_ERROR;
+}
+
+// Debug UART frame that may use the UART_TX_RESERVE the other messages leave
+// free, so a burst of text lines never pushes it out. Queued, never waits
+uint8_t send_UART_priority(const uint8_t *data, uint16_t len){
+
+	if(uart_tx_queue(data, len, 0) != NO_ERROR){
+		return DEBUG_UART_ERROR;
+	}
+
+	return NO_ERROR;
+}
+
 uint8_t send_UART_msg(uint8_t uart, const char* msg){
+	return send_UART_data(uart, (const uint8_t *)msg, strlen(msg));
+}
+
+// Raw bytes, e.g. binary frames that contain 0x00. COMMS data goes out by DMA
+// straight from the caller's buffer: keep it untouched until comms_UART_busy() clears
+uint8_t send_UART_data(uint8_t uart, const uint8_t *data, uint16_t len){
 
 	switch(uart){
 		case DEBUG_UART_NUM:
 
-			system_status = HAL_UART_Transmit(DEBUG_UART, (uint8_t *)msg, strlen(msg), HAL_MAX_DELAY);
-
-			if(system_status != HAL_OK){
+			if(uart_tx_queue(data, len, UART_TX_RESERVE) != NO_ERROR){
 				return DEBUG_UART_ERROR;
 			}
 			break;
 
 		case COMMS_UART_NUM:
-//TODO
-//			system_status = HAL_UART_Transmit(COMMS_UART, (uint8_t *)msg, strlen(msg), HAL_MAX_DELAY);
-//
-//			if(system_status != HAL_OK){
-//				return COMMS_ERROR;
-//			}
+
+			system_status = HAL_UART_Transmit_DMA(COMMS_UART, (uint8_t *)data, len);
+
+			if(system_status != HAL_OK){
+				return COMMS_ERROR;
+			}
 			break;
 
 		default:
@@ -147,34 +481,507 @@ rtc_calendar get_sys_time(){
 
 	return current_time;
 }
+uint8_t latch_sys_time(){
+
+	RTC_DateTypeDef sysDate;
+	RTC_TimeTypeDef sysTime;
+
+	// GetTime locks the shadow registers until GetDate is read
+	system_status = HAL_RTC_GetTime(&hrtc, &sysTime, RTC_FORMAT_BIN);
+	uint32_t tick = HAL_GetTick();
+	if(system_status != HAL_OK){
+		cached_valid = false;
+		return RTC_TIME_ERROR;
+	}
+
+	system_status = HAL_RTC_GetDate(&hrtc, &sysDate, RTC_FORMAT_BIN);
+	if(system_status != HAL_OK){
+		cached_valid = false;
+		return RTC_TIME_ERROR;
+	}
+
+	cached_time.hour = sysTime.Hours;
+	cached_time.minute = sysTime.Minutes;
+	cached_time.second = sysTime.Seconds;
+
+	cached_time.day = sysDate.Date;
+	cached_time.month = sysDate.Month;
+	cached_time.year = sysDate.Year;
+
+	// SSR counts down from PREDIV_S (SecondFraction) during the second
+	uint32_t sub_ms = ((sysTime.SecondFraction - sysTime.SubSeconds) * 1000) / (sysTime.SecondFraction + 1);
+	cached_tick = tick - sub_ms;
+	cached_valid = true;
+
+	return NO_ERROR;
+}
+
+// Current time from the cache, ms is optional (NULL) sub-second output
+rtc_calendar get_cached_time(uint16_t *ms){
+
+	rtc_calendar current_time;
+	uint32_t elapsed = HAL_GetTick() - cached_tick;
+	uint32_t day_seconds = cached_time.hour * 3600 + cached_time.minute * 60 + cached_time.second + elapsed / 1000;
+
+	// Stale cache or past midnight: let the RTC do the calendar
+	if(!cached_valid || elapsed >= TIME_CACHE_MAX_AGE_MS || day_seconds >= 86400){
+		if(latch_sys_time() != NO_ERROR){
+			current_time.day = RTC_RETURN_ERR;
+			return current_time;
+		}
+		elapsed = HAL_GetTick() - cached_tick;
+		day_seconds = cached_time.hour * 3600 + cached_time.minute * 60 + cached_time.second + elapsed / 1000;
+	}
+
+	current_time = cached_time;
+	current_time.hour = day_seconds / 3600;
+	current_time.minute = (day_seconds / 60) % 60;
+	current_time.second = day_seconds % 60;
+
+	if(ms != NULL){
+		*ms = elapsed % 1000;
+	}
+
+	return current_time;
+}
+
+uint32_t get_timestamp(uint16_t *ms){
+	return pack_timestamp(get_cached_time(ms));
+}
+
+// 32-bit calendar stamp for binary records:
+// year-2000 [31:26] | month [25:22] | day [21:17] | hour [16:12] | minute [11:6] | second [5:0]
+uint32_t pack_timestamp(rtc_calendar date_time){
+
+	return ((uint32_t)(date_time.year & 0x3F) << 26) |
+		   ((uint32_t)(date_time.month & 0x0F) << 22) |
+		   ((uint32_t)(date_time.day & 0x1F) << 17) |
+		   ((uint32_t)(date_time.hour & 0x1F) << 12) |
+		   ((uint32_t)(date_time.minute & 0x3F) << 6) |
+		   (uint32_t)(date_time.second & 0x3F);
+}
+
+// Seconds since 2000-01-01 00:00:00, valid up to 2099
+uint32_t calendar_to_seconds(rtc_calendar date_time){
+
+	static const uint16_t days_before_month[12] = {0, 31, 59, 90, 120, 151, 181, 212, 243, 273, 304, 334};
+	uint32_t year = date_time.year;
+	uint32_t days = year * 365 + (year + 3) / 4 + days_before_month[(date_time.month + 11) % 12] + date_time.day - 1;
+
+	if(date_time.month > 2 && year % 4 == 0){
+		days++;
+	}
+
+	return ((days * 24 + date_time.hour) * 60 + date_time.minute) * 60 + date_time.second;
+}
+
+rtc_calendar seconds_to_calendar(uint32_t seconds){
+
+	static const uint8_t month_days[12] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+	rtc_calendar date_time;
+	uint32_t days = seconds / 86400;
+	uint32_t rest = seconds % 86400;
+
+	date_time.hour = rest / 3600;
+	date_time.minute = (rest / 60) % 60;
+	date_time.second = rest % 60;
+
+	date_time.year = 0;
+	while(days >= ((date_time.year % 4 == 0) ? 366U : 365U)){
+		days -= (date_time.year % 4 == 0) ? 366U : 365U;
+		date_time.year++;
+	}
+
+	date_time.month = 1;
+	for(uint8_t m = 0; m < 12; m++){
+		uint8_t length = month_days[m] + ((m == 1 && date_time.year % 4 == 0) ? 1 : 0);
+
+		if(days < length){
+			break;
+		}
+		days -= length;
+		date_time.month++;
+	}
+	date_time.day = days + 1;
+
+	return date_time;
+}
+
+rtc_calendar unpack_timestamp(uint32_t packed){
+
+	rtc_calendar date_time = {
+		.hour = (packed >> 12) & 0x1F,
+		.minute = (packed >> 6) & 0x3F,
+		.second = packed & 0x3F,
+		.day = (packed >> 17) & 0x1F,
+		.month = (packed >> 22) & 0x0F,
+		.year = (packed >> 26) & 0x3F
+	};
+
+	return date_time;
+}
+
 //-------------------------------------------------------------- I2C - SENSORS ---------------------------------------------------------
 
 
+static uint8_t i2c_device(uint16_t addr){
+
+	for(uint8_t i = 0; i < I2C_DEV_COUNT; i++){
+		if(i2c_dev_addr[i] == addr){
+			return i;
+		}
+	}
+	return I2C_DEV_COUNT;
+}
+
+static void i2c_record(const i2c_xfer *xfer, uint32_t start_us, uint8_t error){
+
+	i2c_dev_stats *stats = &i2c_counters[xfer->device];
+	uint32_t latency = get_tick_us() - start_us;
+	uint8_t bin = 0;
+
+	while(bin < I2C_LATENCY_BINS - 1 && latency >= ((uint32_t)I2C_LATENCY_BASE_US << bin)){
+		bin++;
+	}
+
+	stats->transactions++;
+	stats->latency[bin]++;
+
+	if(error != NO_ERROR){
+		stats->errors++;
+	} else {
+		stats->bytes += xfer->len;
+	}
+}
+
+static HAL_StatusTypeDef i2c_start_xfer(const i2c_xfer *xfer){
+
+	uint16_t addr = i2c_dev_addr[xfer->device];
+
+	switch(xfer->op){
+		case I2C_OP_WRITE:
+			return HAL_I2C_Master_Transmit_IT(SENSOR_I2C, addr, xfer->data, xfer->len);
+
+		case I2C_OP_READ:
+			return HAL_I2C_Master_Receive_IT(SENSOR_I2C, addr, xfer->data, xfer->len);
+
+		case I2C_OP_REG_WRITE:
+			return HAL_I2C_Mem_Write_IT(SENSOR_I2C, addr, xfer->reg, I2C_MEMADD_SIZE_8BIT, xfer->data, xfer->len);
+
+		case I2C_OP_REG_READ:
+			return HAL_I2C_Mem_Read_IT(SENSOR_I2C, addr, xfer->reg, I2C_MEMADD_SIZE_8BIT, xfer->data, xfer->len);
+
+		default:
+			return HAL_ERROR;
+	}
+}
+
+static HAL_StatusTypeDef i2c_poll_xfer(const i2c_xfer *xfer){
+
+	uint16_t addr = i2c_dev_addr[xfer->device];
+
+	switch(xfer->op){
+		case I2C_OP_WRITE:
+			return HAL_I2C_Master_Transmit(SENSOR_I2C, addr, xfer->data, xfer->len, ERROR_DELAY_MS);
+
+		case I2C_OP_READ:
+			return HAL_I2C_Master_Receive(SENSOR_I2C, addr, xfer->data, xfer->len, ERROR_DELAY_MS);
+
+		case I2C_OP_REG_WRITE:
+			return HAL_I2C_Mem_Write(SENSOR_I2C, addr, xfer->reg, I2C_MEMADD_SIZE_8BIT, xfer->data, xfer->len, ERROR_DELAY_MS);
+
+		case I2C_OP_REG_READ:
+			return HAL_I2C_Mem_Read(SENSOR_I2C, addr, xfer->reg, I2C_MEMADD_SIZE_8BIT, xfer->data, xfer->len, ERROR_DELAY_MS);
+
+		default:
+			return HAL_ERROR;
+	}
+}
+
+// Start the next transfer, retiring finished jobs on the way. Called with
+// interrupts masked or from the I2C interrupt. i2c_busy stays set while it
+// runs, so a done() callback that submits more work only queues it
+static void i2c_run_queue(){
+
+	i2c_busy = true;
+
+	while(i2c_queue_tail != i2c_queue_head){
+
+		i2c_job *job = i2c_queue[i2c_queue_tail & (I2C_QUEUE_LEN - 1)];
+
+		if(i2c_xfer_index < job->count){
+
+			const i2c_xfer *xfer = &job->xfers[i2c_xfer_index];
+
+			i2c_xfer_start_us = get_tick_us();
+			system_status = i2c_start_xfer(xfer);
+
+			if(system_status == HAL_OK){
+				return;
+			}
+
+			i2c_record(xfer, i2c_xfer_start_us, I2C_ERROR);
+			i2c_job_error = I2C_ERROR;
+			i2c_xfer_index = job->count;
+			continue;
+		}
+
+		uint8_t error = i2c_job_error;
+
+		i2c_queue_tail++;
+		i2c_xfer_index = 0;
+		i2c_job_error = NO_ERROR;
+
+		if(job->done != NULL){
+			job->done(error, job->ctx);
+		}
+	}
+
+	i2c_busy = false;
+}
+
+// Bus stuck or a completion lost: reset I2C1 and fail every queued job
+static void i2c_abort(){
+
+	uint32_t primask = __get_PRIMASK();
+	__disable_irq();
+
+	HAL_I2C_DeInit(SENSOR_I2C);
+	HAL_I2C_Init(SENSOR_I2C);
+
+	uint8_t head = i2c_queue_head;
+	i2c_busy = true;
+
+	while(i2c_queue_tail != head){
+
+		i2c_job *job = i2c_queue[i2c_queue_tail & (I2C_QUEUE_LEN - 1)];
+
+		if(i2c_xfer_index < job->count){
+			i2c_record(&job->xfers[i2c_xfer_index], i2c_xfer_start_us, I2C_ERROR);
+		}
+
+		i2c_queue_tail++;
+		i2c_xfer_index = 0;
+		i2c_job_error = NO_ERROR;
+
+		if(job->done != NULL){
+			job->done(I2C_ERROR, job->ctx);
+		}
+	}
+
+	// Anything a done() callback queued starts on the fresh peripheral
+	i2c_run_queue();
+
+	__set_PRIMASK(primask);
+}
+
+// I2C transfer complete / error interrupt: account for it and move on
+void I2C_xfer_complete(I2C_HandleTypeDef *hi2c, uint8_t error){
+
+	if(hi2c != SENSOR_I2C || !i2c_busy || i2c_queue_tail == i2c_queue_head){
+		return;
+	}
+
+	i2c_job *job = i2c_queue[i2c_queue_tail & (I2C_QUEUE_LEN - 1)];
+
+	i2c_record(&job->xfers[i2c_xfer_index], i2c_xfer_start_us, error);
+
+	if(error != NO_ERROR){
+		i2c_job_error = error;
+		i2c_xfer_index = job->count;
+	} else {
+		i2c_xfer_index++;
+	}
+
+	i2c_run_queue();
+}
+
+// Queue a job, it starts straight away if the bus is idle
+uint8_t submit_i2c_job(i2c_job *job){
+
+	for(uint8_t i = 0; i < job->count; i++){
+		if(job->xfers[i].device >= I2C_DEV_COUNT){
+			return I2C_ERROR;
+		}
+	}
+
+	uint32_t primask = __get_PRIMASK();
+	__disable_irq();
+
+	if((uint8_t)(i2c_queue_head - i2c_queue_tail) >= I2C_QUEUE_LEN){
+		__set_PRIMASK(primask);
+		return I2C_ERROR;
+	}
+
+	i2c_queue[i2c_queue_head & (I2C_QUEUE_LEN - 1)] = job;
+	i2c_queue_head++;
+
+	if(!i2c_busy){
+		i2c_run_queue();
+	}
+
+	__set_PRIMASK(primask);
+	return NO_ERROR;
+}
+
+static void i2c_wait_done(uint8_t error, void *ctx){
+
+	i2c_wait *wait = (i2c_wait *)ctx;
+
+	wait->error = error;
+	wait->done = true;
+}
+
+// Interrupt context (EXTI callbacks) can't sleep on the I2C interrupt: run
+// the transfers polled, which only works while the engine is idle
+static uint8_t i2c_run_polled(const i2c_xfer *xfers, uint8_t count){
+
+	for(uint8_t i = 0; i < count; i++){
+
+		uint32_t start_us = get_tick_us();
+
+		if(i2c_busy){
+			return I2C_ERROR;
+		}
+
+		system_status = i2c_poll_xfer(&xfers[i]);
+
+		i2c_record(&xfers[i], start_us, system_status == HAL_OK ? NO_ERROR : I2C_ERROR);
+
+		if(system_status != HAL_OK){
+			return I2C_ERROR;
+		}
+	}
+
+	return NO_ERROR;
+}
+
+// Blocking job for the drivers: sleep until it completes or ERROR_DELAY_MS
+uint8_t run_i2c_xfers(const i2c_xfer *xfers, uint8_t count){
+
+	i2c_wait wait = {false, NO_ERROR};
+	i2c_job job = {xfers, count, i2c_wait_done, &wait};
+
+	if(__get_IPSR() != 0){
+		return i2c_run_polled(xfers, count);
+	}
+
+	if(submit_i2c_job(&job) != NO_ERROR){
+		return I2C_ERROR;
+	}
+
+	uint32_t start = HAL_GetTick();
+
+	while(!wait.done){
+		if(HAL_GetTick() - start >= ERROR_DELAY_MS){
+			i2c_abort();
+			return I2C_ERROR;
+		}
+		__WFI();
+	}
+
+	return wait.error;
+}
+
+i2c_dev_stats get_i2c_stats(uint8_t device){
+
+	i2c_dev_stats stats = {0};
+
+	if(device < I2C_DEV_COUNT){
+		stats = i2c_counters[device];
+	}
+	return stats;
+}
+
 uint8_t read_i2c_sensor(uint16_t addr, uint8_t *pData, uint16_t size){
 
-	system_status = HAL_I2C_Master_Receive(SENSOR_I2C, addr, pData, size, ERROR_DELAY_MS);
+	i2c_xfer xfer = {i2c_device(addr), I2C_OP_READ, 0, pData, size};
 
-	if(system_status != HAL_OK){
+	if(xfer.device >= I2C_DEV_COUNT){
 		return I2C_ERROR;
 	}
 
-	return 0;
+	return run_i2c_xfers(&xfer, 1);
 }
 
 
 uint8_t write_i2c_sensor(uint16_t addr, uint8_t *pData, uint16_t size){
 
-	system_status = HAL_I2C_Master_Transmit(SENSOR_I2C, addr, pData, size, ERROR_DELAY_MS);
+	i2c_xfer xfer = {i2c_device(addr), I2C_OP_WRITE, 0, pData, size};
 
-	if(system_status != HAL_OK){
+	if(xfer.device >= I2C_DEV_COUNT){
 		return I2C_ERROR;
 	}
 
-	return NO_ERROR;
+	return run_i2c_xfers(&xfer, 1);
+}
+
+// Register pointer write, repeated START and read in one transaction: no
+// STOP in between, so nothing else can move the sensor's pointer
+uint8_t read_i2c_register(uint16_t addr, uint8_t reg, uint8_t *pData, uint16_t size){
+
+	i2c_xfer xfer = {i2c_device(addr), I2C_OP_REG_READ, reg, pData, size};
+
+	if(xfer.device >= I2C_DEV_COUNT){
+		return I2C_ERROR;
+	}
+
+	return run_i2c_xfers(&xfer, 1);
+}
+
+// Burst write starting at reg, the sensor auto-increments the pointer
+uint8_t write_i2c_registers(uint16_t addr, uint8_t reg, uint8_t *pData, uint16_t size){
+
+	i2c_xfer xfer = {i2c_device(addr), I2C_OP_REG_WRITE, reg, pData, size};
+
+	if(xfer.device >= I2C_DEV_COUNT){
+		return I2C_ERROR;
+	}
+
+	return run_i2c_xfers(&xfer, 1);
+}
+
+// Scattered register writes chained in one job, in table order
+uint8_t write_i2c_sequence(uint16_t addr, const i2c_reg_write *seq, uint8_t count){
+
+	i2c_xfer xfers[I2C_SEQUENCE_MAX];
+	uint8_t device = i2c_device(addr);
+
+	if(device >= I2C_DEV_COUNT || count > I2C_SEQUENCE_MAX){
+		return I2C_ERROR;
+	}
+
+	for(uint8_t i = 0; i < count; i++){
+		xfers[i].device = device;
+		xfers[i].op = I2C_OP_REG_WRITE;
+		xfers[i].reg = seq[i].reg;
+		xfers[i].data = (uint8_t *)&seq[i].value;
+		xfers[i].len = 1;
+	}
+
+	return run_i2c_xfers(xfers, count);
 }
 
 //----------------------------------------------------------- POWER ------------------------------------------------------
 
+// RTC time of day in ms, 1/(PREDIV_S + 1) s resolution. The shadow registers
+// are stale after STOP until RSF is set again
+static uint32_t rtc_ms_of_day(){
+
+	RTC_TimeTypeDef sysTime;
+	RTC_DateTypeDef sysDate;
+
+	__HAL_RTC_WRITEPROTECTION_DISABLE(&hrtc);
+	HAL_RTC_WaitForSynchro(&hrtc);
+	__HAL_RTC_WRITEPROTECTION_ENABLE(&hrtc);
+
+	HAL_RTC_GetTime(&hrtc, &sysTime, RTC_FORMAT_BIN);
+	HAL_RTC_GetDate(&hrtc, &sysDate, RTC_FORMAT_BIN);
+
+	return (sysTime.Hours * 3600 + sysTime.Minutes * 60 + sysTime.Seconds) * 1000
+			+ ((sysTime.SecondFraction - sysTime.SubSeconds) * 1000) / (sysTime.SecondFraction + 1);
+}
+
 uint8_t power_manage(uint8_t power_mode){
 
 	switch (power_mode) {
@@ -182,8 +989,15 @@ uint8_t power_manage(uint8_t power_mode){
 
 			break;
 
+		// Peripheral clocks stop in STOP: nothing may be in flight. A COMMS
+		// frame on the wire is not waited for, the caller sleeps in WFI instead
 		case stop_mode_RTC:
-
+			if(flush_UART_tx(UART_TX_FLUSH_MS) != NO_ERROR){
+				return PWR_MANAGE_ERROR;
+			}
+			if(i2c_busy || uart_tx_in_flight != 0 || comms_UART_busy() || flag_timer_on){
+				return PWR_MANAGE_ERROR;
+			}
 			break;
 
 		default:
@@ -193,12 +1007,315 @@ uint8_t power_manage(uint8_t power_mode){
 	return NO_ERROR;
 }
 
+// One STOP period of up to sleep_ms, ended by the RTC wake-up timer or any
+// EXTI. SysTick is off meanwhile, so HAL_GetTick() is moved forward by what
+// the RTC measured and the wall clock cache is latched again
+uint8_t enter_stop_mode(uint32_t sleep_ms){
+
+	uint32_t start_ms, slept_ms;
+
+	if(sleep_ms < STOP_MIN_MS){
+		return PWR_MANAGE_ERROR;
+	}
+	if(sleep_ms > STOP_MAX_MS){
+		sleep_ms = STOP_MAX_MS;
+	}
+
+	if(power_manage(stop_mode_RTC) != NO_ERROR){
+		return PWR_MANAGE_ERROR;
+	}
+
+	start_ms = rtc_ms_of_day();
+
+	if(HAL_RTCEx_SetWakeUpTimer_IT(&hrtc, (sleep_ms * RTC_WAKEUP_HZ) / 1000 - 1, RTC_WAKEUPCLOCK_RTCCLK_DIV16) != HAL_OK){
+		return PWR_MANAGE_ERROR;
+	}
+
+	// With PRIMASK set a pending EXTI still ends WFI, but its handler only
+	// runs once the clocks are back
+	uint32_t primask = __get_PRIMASK();
+	__disable_irq();
+
+	// An interrupt since the checks may have queued an I2C job or posted an
+	// event idle_delay() would have returned for
+	if(i2c_busy || uart_tx_in_flight != 0 || comms_UART_busy() || event_head != event_tail){
+		__set_PRIMASK(primask);
+		HAL_RTCEx_DeactivateWakeUpTimer(&hrtc);
+		return PWR_MANAGE_ERROR;
+	}
+
+	HAL_SuspendTick();
+	HAL_PWR_EnterSTOPMode(PWR_LOWPOWERREGULATOR_ON, PWR_STOPENTRY_WFI);
+
+	SystemClock_Config();
+
+	slept_ms = rtc_ms_of_day() - start_ms;
+	if((int32_t)slept_ms < 0){
+		slept_ms += 86400000;		// midnight
+	}
+	uwTick += slept_ms;
+	HAL_ResumeTick();
+
+	__set_PRIMASK(primask);
+
+	HAL_RTCEx_DeactivateWakeUpTimer(&hrtc);
+	latch_sys_time();
+
+	return NO_ERROR;
+}
+
 
 //----------------------------------------- EEPROM ----------------------------------
 
-// uint8_t mem_read(addr, data, size);
-// uint8_t mem_write(addr, data, size);
-// wipe_memory
+#define MEM_WORDS (MEM_RECORD_SIZE / 4)
+
+static uint32_t mem_slot_addr(uint16_t slot){
+	return DATA_EEPROM_BASE + (uint32_t)slot * MEM_RECORD_SIZE;
+}
+
+// Data EEPROM is memory mapped, reads need no unlock
+static void mem_load(uint16_t slot, mem_record *record){
+
+	const __IO uint32_t *src = (const __IO uint32_t *)(uintptr_t)mem_slot_addr(slot);
+	uint32_t words[MEM_WORDS];
+
+	for(uint8_t i = 0; i < MEM_WORDS; i++){
+		words[i] = src[i];
+	}
+	memcpy(record, words, sizeof(*record));
+}
+
+static uint8_t mem_check(const mem_record *record){
+
+	const uint8_t *bytes = (const uint8_t *)record;
+	uint16_t crc = crc16_ccitt(bytes, offsetof(mem_record, check), 0xFFFF);
+
+	crc = crc16_ccitt(&bytes[offsetof(mem_record, timestamp)], MEM_RECORD_SIZE - offsetof(mem_record, timestamp), crc);
+	return (uint8_t)crc;
+}
+
+static bool mem_valid(const mem_record *record){
+	return record->type != MEM_EMPTY && record->check == mem_check(record);
+}
+
+// Boot scan: the newest valid record is the head, the tail is as far back as
+// the sequence numbers stay consecutive and no MEM_WIPED marker is crossed.
+// A write torn by a reset fails the check and ends the run there
+uint8_t config_mem(){
+
+	mem_record record;
+	int16_t newest = -1;
+	uint16_t newest_seq = 0;
+
+	for(uint16_t slot = 0; slot < MEM_SLOTS; slot++){
+		mem_load(slot, &record);
+		if(mem_valid(&record) && (newest < 0 || (int16_t)(record.seq - newest_seq) > 0)){
+			newest = slot;
+			newest_seq = record.seq;
+		}
+	}
+
+	if(newest < 0){
+		mem_head = 0;
+		mem_records = 0;
+		return NO_ERROR;
+	}
+
+	mem_head = (newest + 1) % MEM_SLOTS;
+	mem_next_seq = newest_seq + 1;
+	mem_records = 0;
+
+	while(mem_records < MEM_SLOTS){
+		uint16_t slot = (newest + MEM_SLOTS - mem_records) % MEM_SLOTS;
+
+		mem_load(slot, &record);
+		if(!mem_valid(&record) || record.seq != (uint16_t)(newest_seq - mem_records) || record.type == MEM_WIPED){
+			break;
+		}
+		mem_records++;
+	}
+
+	return NO_ERROR;
+}
+
+// Append at the head, overwriting the oldest record once the ring is full.
+// Fills in seq and check. The header word goes last so a reset mid-write
+// leaves a slot that fails the check instead of a bad record
+uint8_t mem_write(mem_record *record){
+
+	uint32_t addr = mem_slot_addr(mem_head);
+	const __IO uint32_t *dst = (const __IO uint32_t *)(uintptr_t)addr;
+	uint32_t words[MEM_WORDS];
+
+	record->seq = mem_next_seq;
+	record->check = mem_check(record);
+	memcpy(words, record, sizeof(words));
+
+	if(HAL_FLASHEx_DATAEEPROM_Unlock() != HAL_OK){
+		return EEPROM_ERROR;
+	}
+
+	for(int8_t i = MEM_WORDS - 1; i >= 0; i--){
+		// Unchanged words cost no erase/program cycle
+		if(dst[i] == words[i]){
+			continue;
+		}
+		if(HAL_FLASHEx_DATAEEPROM_Program(FLASH_TYPEPROGRAMDATA_WORD, addr + 4 * i, words[i]) != HAL_OK){
+			HAL_FLASHEx_DATAEEPROM_Lock();
+			return EEPROM_ERROR;
+		}
+	}
+
+	HAL_FLASHEx_DATAEEPROM_Lock();
+
+	mem_head = (mem_head + 1) % MEM_SLOTS;
+	mem_next_seq++;
+	if(mem_records < MEM_SLOTS){
+		mem_records++;
+	}
+
+	return NO_ERROR;
+}
+
+// index 0 is the oldest record
+uint8_t mem_read(uint16_t index, mem_record *record){
+
+	if(index >= mem_records){
+		return EEPROM_ERROR;
+	}
+
+	mem_load((mem_head + MEM_SLOTS - mem_records + index) % MEM_SLOTS, record);
+
+	return mem_valid(record) ? NO_ERROR : EEPROM_ERROR;
+}
+
+uint16_t mem_count(){
+	return mem_records;
+}
+
+// Erase every written word but a MEM_WIPED marker at the head. The marker
+// keeps head and seq across a reset, so the next records go on rotating
+// through the region instead of restarting at slot 0. It is written first:
+// a reset mid-erase still boots to an empty store
+uint8_t wipe_memory(){
+
+	const __IO uint32_t *word = (const __IO uint32_t *)(uintptr_t)DATA_EEPROM_BASE;
+	uint16_t marker_word = mem_head * MEM_WORDS;
+	mem_record marker;
+
+	memset(&marker, 0, sizeof(marker));
+	marker.type = MEM_WIPED;
+	if(mem_write(&marker) != NO_ERROR){
+		return EEPROM_ERROR;
+	}
+
+	if(HAL_FLASHEx_DATAEEPROM_Unlock() != HAL_OK){
+		return EEPROM_ERROR;
+	}
+
+	for(uint16_t i = 0; i < MEM_SLOTS * MEM_WORDS; i++){
+		if((uint16_t)(i - marker_word) < MEM_WORDS){
+			continue;
+		}
+		if(word[i] != 0 && HAL_FLASHEx_DATAEEPROM_Erase(DATA_EEPROM_BASE + 4 * i) != HAL_OK){
+			HAL_FLASHEx_DATAEEPROM_Lock();
+			return EEPROM_ERROR;
+		}
+	}
+
+	HAL_FLASHEx_DATAEEPROM_Lock();
+
+	mem_records = 0;
+	mem_series_open = false;
+
+	return NO_ERROR;
+}
+
+// Write the block's closed chunks, or everything with all set (the last
+// chunk zero padded)
+static uint8_t mem_series_store(bool all){
+
+	mem_record record;
+
+	while(mem_series.len - mem_series_stored >= MEM_SERIES_CHUNK || (all && mem_series_stored < mem_series.len)){
+		uint16_t n = mem_series.len - mem_series_stored;
+
+		if(n > MEM_SERIES_CHUNK){
+			n = MEM_SERIES_CHUNK;
+		}
+
+		memset(record.chunk, 0, MEM_SERIES_CHUNK);
+		memcpy(record.chunk, &mem_series_buf[mem_series_stored], n);
+		record.type = (mem_series_stored == 0) ? MEM_SERIES_START : MEM_SERIES;
+
+		if(mem_write(&record) != NO_ERROR){
+			return EEPROM_ERROR;
+		}
+		if(mem_series_stored == 0){
+			mem_series_seq = record.seq;
+		}
+		mem_series_stored += MEM_SERIES_CHUNK;
+	}
+
+	return NO_ERROR;
+}
+
+// Append a sample to the EEPROM series (MEM_SERIES_CHANNELS of it). A full
+// block is closed and the next one is anchored on its last sample, so its
+// records still decode once its anchor is overwritten
+uint8_t mem_store_sample(const series_sample *sample){
+
+	uint8_t error = NO_ERROR;
+
+	if(mem_series_open && !series_add(&mem_series, sample)){
+		bool linked = series_linkable(&mem_series, sample);
+
+		series_finish(&mem_series, linked);
+		error = mem_series_store(true);
+		mem_series_open = false;
+
+		if(linked){
+			series_continue(&mem_series);
+			series_add(&mem_series, sample);
+			mem_series_stored = 0;
+			mem_series_open = true;
+		}
+	}
+
+	if(!mem_series_open){
+		series_begin(&mem_series, mem_series_buf, sizeof(mem_series_buf), MEM_SERIES_CHUNK, MEM_SERIES_CHANNELS, MEM_SERIES_STEP);
+		mem_series_stored = 0;
+		mem_series_open = true;
+		series_add(&mem_series, sample);
+	}
+
+	if(error != NO_ERROR){
+		return error;
+	}
+
+	return mem_series_store(false);
+}
+
+// Copy of the open block, open section included, for reading it back before
+// it is complete. start_stored: its MEM_SERIES_START is already in EEPROM as
+// record start_seq, the series records from there on are this block
+uint16_t mem_series_pending(uint8_t *block, uint16_t *start_seq, bool *start_stored){
+
+	if(!mem_series_open){
+		*start_stored = false;
+		return 0;
+	}
+
+	series_encoder copy = mem_series;
+
+	copy.buf = block;
+	memcpy(block, mem_series_buf, sizeof(mem_series_buf));
+
+	*start_seq = mem_series_seq;
+	*start_stored = (mem_series_stored > 0);
+
+	return series_finish(&copy, false);
+}
 
 //----------------------------------------- INTERFACES ------------------------------
 
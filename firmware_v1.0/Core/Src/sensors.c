@@ -6,6 +6,8 @@
  */
 
 #include "sensors.h"
+#include "vibration.h"
+#include "capture.h"
 
 // HDC2080
 uint8_t  sensor_data[4];
@@ -15,16 +17,100 @@ uint16_t hum_value;
 // ADXL343
 int16_t raw_acceleration[3];
 
+#if HDC2080_AMM_MODE || ADXL343_FIFO_MODE
+// Background jobs: the I2C interrupt only flags the job as done, serve_sensors()
+// does the rest in thread context (sums, bands, capture, the next job)
+#define SENSOR_JOB_HDC_DRDY		0x01
+#define SENSOR_JOB_ACCEL_STATUS	0x02
+#define SENSOR_JOB_ACCEL_FIFO	0x04
+#define SENSOR_JOB_ACCEL_SOURCE	0x08
+
+static void sensor_job_done(uint8_t error, void *ctx);
+
+static volatile uint8_t sensor_jobs_done = 0;
+static volatile uint8_t sensor_jobs_failed = 0;
+#endif
+
+#if HDC2080_AMM_MODE
+// DRDY collector: read in the background, summed by serve_sensors(), drained by average_temp_hum()
+static void hdc_drdy_done(uint8_t error);
+
+static uint8_t hdc_drdy_data[HDC2080_DRDY_READ_SIZE];
+static i2c_xfer hdc_drdy_xfer = {HDC2080, I2C_OP_REG_READ, HDC2080_REG_TEMP_LOW, hdc_drdy_data, sizeof(hdc_drdy_data)};
+static i2c_job hdc_drdy_job = {&hdc_drdy_xfer, 1, sensor_job_done, (void *)(uintptr_t)SENSOR_JOB_HDC_DRDY};
+
+static volatile bool hdc_drdy_busy = false;		// until serve_sensors() took the result
+static uint32_t hdc_temp_sum = 0;
+static uint32_t hdc_hum_sum = 0;
+static uint16_t hdc_samples = 0;
+static uint8_t hdc_limits = 0;		// TH/HH of the last sample
+#endif
+
+#if ADXL343_FIFO_MODE
+// FIFO collector: on the watermark read FIFO_STATUS, then one DATAX0 read per
+// queued entry chained in a single job. Drained by get_accel()
+static void accel_status_done(uint8_t error);
+static void accel_fifo_done(uint8_t error);
+
+static uint8_t accel_fifo_status[1];
+static i2c_xfer accel_status_xfer = {ADXL343, I2C_OP_REG_READ, ADXL343_REG_FIFO_STATUS, accel_fifo_status, sizeof(accel_fifo_status)};
+static i2c_job accel_status_job = {&accel_status_xfer, 1, sensor_job_done, (void *)(uintptr_t)SENSOR_JOB_ACCEL_STATUS};
+
+static uint8_t accel_fifo_data[ACCEL_FIFO_DEPTH][ACCEL_SAMPLE_BYTES];
+static i2c_xfer accel_fifo_xfers[ACCEL_FIFO_DEPTH];
+static i2c_job accel_fifo_job = {accel_fifo_xfers, 0, sensor_job_done, (void *)(uintptr_t)SENSOR_JOB_ACCEL_FIFO};
+
+static volatile bool accel_fifo_busy = false;	// INT1 chain running, serve_sensors() ends it
+static int32_t accel_sum[3];
+static uint16_t accel_samples = 0;
+#endif
+
+#if ADXL343_EVENT_MODE
+// Event sources, read after the drain: an event latched meanwhile still finds
+// INT1 low afterwards and gives a fresh edge
+static void accel_source_done(uint8_t error);
+
+static uint8_t accel_source[1];		// the read clears the latched events
+static i2c_xfer accel_source_xfer = {ADXL343, I2C_OP_REG_READ, ADXL343_REG_INT_SOURCE, accel_source, sizeof(accel_source)};
+static i2c_job accel_source_job = {&accel_source_xfer, 1, sensor_job_done, (void *)(uintptr_t)SENSOR_JOB_ACCEL_SOURCE};
+
+// Watermark on while in motion or filling a capture. Queued behind the source
+// read, so it is done before the next INT1 can be served
+static uint8_t accel_int_enable[1];
+static i2c_xfer accel_enable_xfer = {ADXL343, I2C_OP_REG_WRITE, ADXL343_REG_INT_ENABLE, accel_int_enable, sizeof(accel_int_enable)};
+static i2c_job accel_enable_job = {&accel_enable_xfer, 1, NULL, NULL};
+
+#define ACCEL_EVENT_INTS (ADXL343_INT_SINGLE_TAP | ADXL343_INT_ACTIVITY | ADXL343_INT_INACTIVITY | ADXL343_INT_FREE_FALL)
+#define ACCEL_SHOCK_INTS (ADXL343_INT_SINGLE_TAP | ADXL343_INT_FREE_FALL)
+#endif
+
+// LINK delays activity detection until inactivity is seen: event mode starts
+// moving, watermark on, until the chip reports the unit still
+static volatile bool accel_moving = true;
+
+// wait_delay() that keeps serving the background jobs: an INT1 chain left
+// waiting through a trigger-mode sample loop would overflow the FIFO
+static void sensor_delay(uint32_t ms){
+
+	uint32_t start = HAL_GetTick();
+
+	serve_sensors();
+	while(HAL_GetTick() - start < ms){
+		__WFI();
+		serve_sensors();
+	}
+}
+
 // -----------------------------------------------------------------	HDC2080 - T/H Sensor	----------------------------------------------------------------------
 
 uint8_t config_T_H_sensor(uint8_t temp_max, uint8_t hum_max){
 
 	uint8_t config_command[2];
 
-	config_command[0] = 0x0E;
-	config_command[1] = 0x80;
+	// Soft reset
+	config_command[0] = 0x80;
 
-	write_i2c_sensor(HDC2080_ADDR, config_command, sizeof(config_command));
+	write_i2c_registers(HDC2080_ADDR, HDC2080_REG_RESET_DRDY, config_command, 1);
 
 
 	// Set thresholds of TEMP & HUM for INTERRUPT
@@ -34,35 +120,43 @@ uint8_t config_T_H_sensor(uint8_t temp_max, uint8_t hum_max){
 	// INT Config (0x07):  7	   6      5      4	    3		2 1 0
 	// 				     DRY_EN  TH_EN  TL_EN  HH_EN  HL_EN 	 RES
 	// TRIGG		       0       1      0      1      0       0 0 0 -> 0x50
+	// AMM			       1       1      0      1      0       0 0 0 -> 0xD0
 
-	config_command[0] = 0x07;
-	config_command[1] = 0x50;
+#if HDC2080_AMM_MODE
+	config_command[0] = 0xD0;
+#else
+	config_command[0] = 0x50;
+#endif
 
-	//config_command[1] = 0x80;
+	//config_command[0] = 0x80;
 
-	write_i2c_sensor(HDC2080_ADDR, config_command, sizeof(config_command));
+	write_i2c_registers(HDC2080_ADDR, HDC2080_REG_INT_CONFIG, config_command, 1);
 
 	// RESET + DRDY Config (0x0E):  7	6  5  4	     3		  2		     1		 0
 	// 				 			  S_RST AMM[6:4]  HEAT_EN DDRY/INT_EN INT_POL INT_MODE
 	// TRIGG		   				0   0  1  1      0        1          1       0 -> 0x36
-
-	config_command[0] = 0x0E;
-	config_command[1] = 0x36;
-
-	write_i2c_sensor(HDC2080_ADDR, config_command, sizeof(config_command));
-
+	// AMM 1 Hz		   				0   1  0  1      0        1          1       0 -> 0x56
 
 	// Measure (0x0F): 7	 6	  5	    4	3	2	         1	     0
 	// 				  TRES[7:6]  HRES[5:4]  x  MEAS_CONFIG[2:1]  MEAS_TRIG
 	// TRIGG		   0     0	  0     0   0   0            0      0/1  -> 0x00/0x01
-
-	config_command[0] = 0x0F;
+	// AMM			   0     0	  0     0   0   0            0       1   -> 0x01
+
+	// 0x0E and 0x0F in one burst: in AMM mode MEAS_TRIG starts the auto measurement
+#if HDC2080_AMM_MODE
+	config_command[0] = 0x56;
+	config_command[1] = 0x01;
+#else
+	config_command[0] = 0x36;
 	config_command[1] = 0X00;
+#endif
 
-	write_i2c_sensor(HDC2080_ADDR, config_command, sizeof(config_command));
+	write_i2c_registers(HDC2080_ADDR, HDC2080_REG_RESET_DRDY, config_command, sizeof(config_command));
 
+#if !HDC2080_AMM_MODE
 	// 1st HDC2080 measure
 	sample_temp_hum();
+#endif
 
 	return NO_ERROR;
 }
@@ -70,56 +164,57 @@ uint8_t config_T_H_sensor(uint8_t temp_max, uint8_t hum_max){
 
 uint8_t sample_temp_hum(){
 
-	uint8_t  measure_command[2];
-	uint8_t  reading_command[1];
+	uint8_t  measure_command[1];
 
 	// Send measure command
-	measure_command[0] = 0x0F;
-	measure_command[1] = 0X01;
+	measure_command[0] = 0X01;
 
-	write_i2c_sensor(HDC2080_ADDR, measure_command, sizeof(measure_command));
+	write_i2c_registers(HDC2080_ADDR, HDC2080_REG_MEASURE, measure_command, sizeof(measure_command));
 
-	wait_delay(SENSOR_DELAY_MS);
+	sensor_delay(SENSOR_DELAY_MS);
 
 	// Read data registers
-	reading_command[0] = 0x00;
-	write_i2c_sensor(HDC2080_ADDR, reading_command, sizeof(reading_command));
-	read_i2c_sensor(HDC2080_ADDR, sensor_data, sizeof(sensor_data));
+	read_i2c_register(HDC2080_ADDR, HDC2080_REG_TEMP_LOW, sensor_data, sizeof(sensor_data));
 
 	return NO_ERROR;
 }
 
 
-float get_temperature(){
-
-	float temp_value_float;
+// centi-degC
+int16_t get_temperature(){
 
 	temp_value = (sensor_data[TEMP_HIGH] << 8 | sensor_data[TEMP_LOW]);
-	temp_value_float = temp_value;
 
-	temp_value_float = ((temp_value_float * 165.0f) / 65536.0f) - (40.5f + 0.08f * (3.3f - 1.8f));
+	return convert_temperature(temp_value);
+}
+
+
+// centi-%RH
+uint16_t get_humidity(){
+
+	hum_value = (sensor_data[HUM_HIGH] << 8 | sensor_data[HUM_LOW]);
 
-	return temp_value_float;
+	return convert_humidity(hum_value);
 }
 
 
-float get_humidity(){
+// degC for display, rounded once from the code instead of again from centi
+int16_t get_temperature_whole(){
 
-	float hum_value_float;
+	return convert_temperature_whole(sensor_data[TEMP_HIGH] << 8 | sensor_data[TEMP_LOW]);
+}
 
-	hum_value = (sensor_data[HUM_HIGH] << 8 | sensor_data[HUM_LOW]);
 
-	hum_value_float = hum_value;
-	hum_value_float = (hum_value_float / 65536.0f) * 100.0f;
+// %RH for display, see get_temperature_whole()
+uint16_t get_humidity_whole(){
 
-	return hum_value_float;
+	return convert_humidity_whole(sensor_data[HUM_HIGH] << 8 | sensor_data[HUM_LOW]);
 }
 
 
 uint8_t set_thresholds_T_H(uint8_t temp_max, uint8_t hum_max){
 
 	uint8_t temp_high, hum_high;
-	uint8_t configh_TRSHLD_command[2];
 
 //----------------------------------- TEMPERATURE ------------------------------------------
 
@@ -130,12 +225,7 @@ uint8_t set_thresholds_T_H(uint8_t temp_max, uint8_t hum_max){
 		temp_max = TEMP_MIN_LIMIT;
 	}
 
-	temp_high = (uint8_t)(256.0f * (temp_max + 40.0f) / 165.0f);
-
-	configh_TRSHLD_command[0] = 0x0B;
-	configh_TRSHLD_command[1] = temp_high;
-
-	write_i2c_sensor(HDC2080_ADDR, configh_TRSHLD_command, sizeof(configh_TRSHLD_command));
+	temp_high = temp_threshold_code(temp_max);
 
 //----------------------------------- HUMIDITY ------------------------------------------
 
@@ -146,46 +236,193 @@ uint8_t set_thresholds_T_H(uint8_t temp_max, uint8_t hum_max){
 		hum_max = HUM_MIN_LIMIT;
 	}
 
-	hum_high = (uint8_t)(256.0f * hum_max / 100.0f);
+	hum_high = hum_threshold_code(hum_max);
+
+//----------------------------------- WRITE ------------------------------------------
 
-	configh_TRSHLD_command[0] = 0x0D;
-	configh_TRSHLD_command[1] = hum_high;
+	i2c_reg_write thresholds[] = {
+		{HDC2080_REG_TEMP_MAX, temp_high},
+		{HDC2080_REG_HUM_MAX, hum_high}
+	};
 
-	write_i2c_sensor(HDC2080_ADDR, configh_TRSHLD_command, sizeof(configh_TRSHLD_command));
+	write_i2c_sequence(HDC2080_ADDR, thresholds, sizeof(thresholds) / sizeof(thresholds[0]));
 
 	return NO_ERROR;
 }
 
-// -----------------------------------------------------------------	ADXL343 - ACCELEROMETER		----------------------------------------------------------------------
+#if HDC2080_AMM_MODE
+static void hdc_drdy_done(uint8_t error){
 
-uint8_t config_ACCEL_sensor(){
+	if(error == NO_ERROR){
+		hdc_temp_sum += hdc_drdy_data[TEMP_HIGH] << 8 | hdc_drdy_data[TEMP_LOW];
+		hdc_hum_sum += hdc_drdy_data[HUM_HIGH] << 8 | hdc_drdy_data[HUM_LOW];
+		hdc_samples++;
 
-	uint8_t reading_command[1];
-	uint8_t config_command[2];
+		// TH/HH -> FSM on the rising edge only: every 1 Hz sample repeats a
+		// held limit, and the ANOMALY -> DATA_READ -> COMMS loop already
+		// follows it from the readings
+		uint8_t limits = hdc_drdy_data[4] & ((1 << TEMP_INT_BIT) | (1 << HUM_INT_BIT));
 
-	// Reading device ID
-	reading_command[0] = 0x00;
+		if((limits & ~hdc_limits) && !event_pending(EVENT_TH_THRESHOLD)){
+			post_event(EVENT_TH_THRESHOLD, hdc_drdy_data[4]);
+		}
+		hdc_limits = limits;
+	}
+
+	hdc_drdy_busy = false;
+}
+#endif
 
-	write_i2c_sensor(ADXL343_ADDR, reading_command, sizeof(reading_command));
-	read_i2c_sensor(ADXL343_ADDR, sensor_data, sizeof(sensor_data));
+// DRDY (EXTI): queue the result read and return, serve_sensors() finishes it
+uint8_t collect_temp_hum(){
 
-	if(sensor_data[0] != 0xE5){
-		return CONFIG_SENSOR_ERROR;
+#if HDC2080_AMM_MODE
+	if(hdc_drdy_busy){
+		return NO_ERROR;
 	}
 
-	// CONFIG DATA FORMAT
-	config_command[0] = 0x31;
-	config_command[1] = 0x09;
+	hdc_drdy_busy = true;
 
-	write_i2c_sensor(ADXL343_ADDR, config_command, sizeof(config_command));
+	if(submit_i2c_job(&hdc_drdy_job) != NO_ERROR){
+		hdc_drdy_busy = false;
+		return I2C_ERROR;
+	}
+#endif
 
+	return NO_ERROR;
+}
 
-	// MEASURE MODE
-	config_command[0] = 0x2D;
-	//config_command[1] = 0x08; //0x38 -> LINK + AUTO_SLEEP + MEASURE
-	config_command[1] = 0x18;
+// Mean code of every result collected since the last call, left in
+// sensor_data for get_temperature() and friends. If none arrived (first
+// cycle, or a DRDY edge was missed and INT is stuck high) read the registers
+// directly, which also clears INT_DRDY and re-arms the pin. Trigger mode
+// takes SAMPLE_SIZE conversions here instead
+uint8_t average_temp_hum(int16_t *temp, uint16_t *hum){
+
+	uint32_t temp_sum, hum_sum;
+	uint16_t samples;
+
+#if HDC2080_AMM_MODE
+	uint8_t error = NO_ERROR;
+
+	temp_sum = hdc_temp_sum;
+	hum_sum = hdc_hum_sum;
+	samples = hdc_samples;
+
+	hdc_temp_sum = 0;
+	hdc_hum_sum = 0;
+	hdc_samples = 0;
+
+	if(samples == 0){
+		uint8_t drdy_data[HDC2080_DRDY_READ_SIZE];
+
+		error = read_i2c_register(HDC2080_ADDR, HDC2080_REG_TEMP_LOW, drdy_data, sizeof(drdy_data));
+		if(error != NO_ERROR){
+			return error;
+		}
+
+		temp_sum = drdy_data[TEMP_HIGH] << 8 | drdy_data[TEMP_LOW];
+		hum_sum = drdy_data[HUM_HIGH] << 8 | drdy_data[HUM_LOW];
+		samples = 1;
+	}
+#else
+	temp_sum = 0;
+	hum_sum = 0;
+	samples = SAMPLE_SIZE;
+
+	for(uint8_t i = 0; i < SAMPLE_SIZE; i++){
+		sample_temp_hum();
+
+		temp_sum += sensor_data[TEMP_HIGH] << 8 | sensor_data[TEMP_LOW];
+		hum_sum += sensor_data[HUM_HIGH] << 8 | sensor_data[HUM_LOW];
+
+		sensor_delay(SENSOR_DELAY_MS);
+	}
+#endif
+
+	// Rounded, the codes are averaged before any conversion
+	temp_sum = (temp_sum + samples / 2) / samples;
+	hum_sum = (hum_sum + samples / 2) / samples;
+
+	sensor_data[TEMP_LOW] = temp_sum & 0xFF;
+	sensor_data[TEMP_HIGH] = temp_sum >> 8;
+	sensor_data[HUM_LOW] = hum_sum & 0xFF;
+	sensor_data[HUM_HIGH] = hum_sum >> 8;
+
+	*temp = get_temperature();
+	*hum = get_humidity();
+
+	return NO_ERROR;
+}
 
-	write_i2c_sensor(ADXL343_ADDR, config_command, sizeof(config_command));
+// -----------------------------------------------------------------	ADXL343 - ACCELEROMETER		----------------------------------------------------------------------
+
+uint8_t config_ACCEL_sensor(){
+
+	uint8_t device_id[1];
+
+	// Reading device ID
+	read_i2c_register(ADXL343_ADDR, ADXL343_REG_DEVID, device_id, sizeof(device_id));
+
+	if(device_id[0] != 0xE5){
+		return CONFIG_SENSOR_ERROR;
+	}
+
+#if ADXL343_FIFO_MODE
+	for(uint8_t i = 0; i < ACCEL_FIFO_DEPTH; i++){
+		accel_fifo_xfers[i] = (i2c_xfer){ADXL343, I2C_OP_REG_READ, ADXL343_REG_DATAX0, accel_fifo_data[i], ACCEL_SAMPLE_BYTES};
+	}
+	vibration_reset();
+	capture_reset();
+
+	accel_moving = true;
+#if ADXL343_EVENT_MODE
+	accel_int_enable[0] = ACCEL_EVENT_INTS | ADXL343_INT_WATERMARK;
+#endif
+
+#if ADXL343_EVENT_MODE
+	// CONFIG THRESHOLDS + DATA FORMAT + ODR + FIFO STREAM + events and watermark on INT1 + LINK + MEASURE MODE.
+	// No AUTO_SLEEP: the 8 Hz sleep rate would miss shocks and free falls of a parked unit
+	const i2c_reg_write accel_config[] = {
+		{ADXL343_REG_THRESH_TAP, ACCEL_THRESH_CODE(ACCEL_SHOCK_MG)},
+		{ADXL343_REG_DUR, ACCEL_DUR_CODE(ACCEL_SHOCK_MS)},
+		{ADXL343_REG_THRESH_ACT, ACCEL_THRESH_CODE(ACCEL_ACT_MG)},
+		{ADXL343_REG_THRESH_INACT, ACCEL_THRESH_CODE(ACCEL_INACT_MG)},
+		{ADXL343_REG_TIME_INACT, ACCEL_INACT_S},
+		{ADXL343_REG_ACT_INACT_CTL, 0xFF},						// ac-coupled, X Y Z for both
+		{ADXL343_REG_THRESH_FF, ACCEL_THRESH_CODE(ACCEL_FF_MG)},
+		{ADXL343_REG_TIME_FF, ACCEL_FF_TIME_CODE(ACCEL_FF_MS)},
+		{ADXL343_REG_TAP_AXES, 0x07},							// X Y Z
+		{ADXL343_REG_DATA_FORMAT, 0x09},
+		{ADXL343_REG_BW_RATE, ACCEL_BW_RATE},
+		{ADXL343_REG_FIFO_CTL, 0x80 | ACCEL_FIFO_WATERMARK},	// 0x80 -> STREAM
+		{ADXL343_REG_INT_MAP, 0x00},							// all sources -> INT1
+		{ADXL343_REG_INT_ENABLE, ACCEL_EVENT_INTS | ADXL343_INT_WATERMARK},
+		{ADXL343_REG_POWER_CTL, ADXL343_POWER_LINK | ADXL343_POWER_MEASURE}
+	};
+#else
+	// CONFIG DATA FORMAT + ODR + FIFO STREAM (watermark on INT1) + MEASURE MODE
+	const i2c_reg_write accel_config[] = {
+		{ADXL343_REG_DATA_FORMAT, 0x09},
+		{ADXL343_REG_BW_RATE, ACCEL_BW_RATE},
+		{ADXL343_REG_FIFO_CTL, 0x80 | ACCEL_FIFO_WATERMARK},	// 0x80 -> STREAM
+		{ADXL343_REG_INT_MAP, 0x00},							// all sources -> INT1
+		{ADXL343_REG_INT_ENABLE, ADXL343_INT_WATERMARK},
+		{ADXL343_REG_POWER_CTL, ADXL343_POWER_MEASURE}
+	};
+#endif
+#else
+	// CONFIG DATA FORMAT + MEASURE MODE
+	const i2c_reg_write accel_config[] = {
+		{ADXL343_REG_DATA_FORMAT, 0x09},
+		//{ADXL343_REG_POWER_CTL, 0x08}, //0x38 -> LINK + AUTO_SLEEP + MEASURE
+		{ADXL343_REG_POWER_CTL, 0x18}
+	};
+#endif
+
+	_Static_assert(sizeof(accel_config) / sizeof(accel_config[0]) <= I2C_SEQUENCE_MAX, "ADXL343 config longer than I2C_SEQUENCE_MAX");
+
+	write_i2c_sequence(ADXL343_ADDR, accel_config, sizeof(accel_config) / sizeof(accel_config[0]));
 
 
 	return NO_ERROR;
@@ -193,23 +430,18 @@ uint8_t config_ACCEL_sensor(){
 
 uint8_t sample_accel(){
 
-	uint8_t reading_command[2];
-	uint8_t config_command[2];
+	uint8_t config_command[1];
 	uint8_t accel_data[6];
 
 
 	// MEASURE MODE
-	config_command[0] = 0x2D;
-	config_command[1] = 0x08;
+	config_command[0] = 0x08;
 
-	write_i2c_sensor(ADXL343_ADDR, config_command, sizeof(config_command));
+	write_i2c_registers(ADXL343_ADDR, ADXL343_REG_POWER_CTL, config_command, sizeof(config_command));
 
 
 	// Get X, Y, Z
-	reading_command[0] = 0x32;
-
-	write_i2c_sensor(ADXL343_ADDR, reading_command, sizeof(reading_command));
-	read_i2c_sensor(ADXL343_ADDR, accel_data, sizeof(accel_data));
+	read_i2c_register(ADXL343_ADDR, ADXL343_REG_DATAX0, accel_data, sizeof(accel_data));
 
 	raw_acceleration[0] = (accel_data[1] << 8 | accel_data[0]);
 	raw_acceleration[1] = (accel_data[3] << 8 | accel_data[2]);
@@ -219,31 +451,208 @@ uint8_t sample_accel(){
 }
 
 
+#if ADXL343_FIFO_MODE
+// Last step of an INT1: the event sources in event mode, else done
+static void accel_read_sources(){
+
+#if ADXL343_EVENT_MODE
+	if(submit_i2c_job(&accel_source_job) == NO_ERROR){
+		return;
+	}
+#endif
+	accel_fifo_busy = false;
+}
+
+static void accel_status_done(uint8_t error){
+
+	// Entries in bits 5:0, the read below pops them one per xfer
+	uint8_t entries = accel_fifo_status[0] & 0x3F;
+
+	if(entries > ACCEL_FIFO_DEPTH){
+		entries = ACCEL_FIFO_DEPTH;
+	}
+
+	if(error != NO_ERROR){
+		accel_fifo_busy = false;
+		return;
+	}
+
+	if(entries == 0){
+		accel_read_sources();
+		return;
+	}
+
+	accel_fifo_job.count = entries;
+
+	if(submit_i2c_job(&accel_fifo_job) != NO_ERROR){
+		accel_fifo_busy = false;
+	}
+}
+
+static void accel_fifo_done(uint8_t error){
+
+	if(error == NO_ERROR){
+		// Stop adding once the window is full, the mean stays valid
+		bool room = (accel_samples <= ACCEL_MAX_SAMPLES);
+
+		for(uint8_t i = 0; i < accel_fifo_job.count; i++){
+			int16_t raw[3] = {
+				(int16_t)(accel_fifo_data[i][1] << 8 | accel_fifo_data[i][0]),
+				(int16_t)(accel_fifo_data[i][3] << 8 | accel_fifo_data[i][2]),
+				(int16_t)(accel_fifo_data[i][5] << 8 | accel_fifo_data[i][4])
+			};
+
+#if ADXL343_EVENT_MODE
+			capture_add(raw);
+#endif
+			if(room){
+				accel_sum[0] += raw[0];
+				accel_sum[1] += raw[1];
+				accel_sum[2] += raw[2];
+				vibration_add(raw);
+			}
+		}
+		if(room){
+			accel_samples += accel_fifo_job.count;
+		}
+	}
+
+	accel_read_sources();
+}
+
+#if ADXL343_EVENT_MODE
+static void accel_source_done(uint8_t error){
+
+	uint8_t source = accel_source[0];
+	uint8_t enable = accel_int_enable[0];
+
+	if(error == NO_ERROR){
+		// LINK reports one of the two at a time
+		if(source & (ADXL343_INT_ACTIVITY | ADXL343_INT_INACTIVITY)){
+			accel_moving = (source & ADXL343_INT_ACTIVITY) != 0;
+		}
+
+		// The drain just before ends at the trigger: the pre-trigger part is in the ring
+		capture_trigger(source);
+
+		// Shock / free fall -> FSM, once until it has been served
+		if((source & ACCEL_SHOCK_INTS) && !event_pending(EVENT_ACCEL_SHOCK)){
+			post_event(EVENT_ACCEL_SHOCK, source & ACCEL_SHOCK_INTS);
+		}
+
+		enable = ACCEL_EVENT_INTS | ((accel_moving || capture_collecting()) ? ADXL343_INT_WATERMARK : 0);
+	}
+
+	if(enable != accel_int_enable[0]){
+		uint8_t previous = accel_int_enable[0];
+
+		accel_int_enable[0] = enable;
+		if(submit_i2c_job(&accel_enable_job) != NO_ERROR){
+			accel_int_enable[0] = previous;
+		}
+	}
+
+	accel_fifo_busy = false;
+}
+#endif
+
+// Take the collector sums and restart them
+static uint16_t take_accel_sums(int32_t sum[3]){
+
+	uint16_t samples = accel_samples;
+
+	for(uint8_t i = 0; i < 3; i++){
+		sum[i] = accel_sum[i];
+		accel_sum[i] = 0;
+	}
+	accel_samples = 0;
+
+	return samples;
+}
+#endif
+
+// INT1 (EXTI): queue the FIFO drain and return, serve_sensors() chains the
+// rest of it
+uint8_t collect_accel(){
+
+#if ADXL343_FIFO_MODE
+	if(accel_fifo_busy){
+		return NO_ERROR;
+	}
+
+	accel_fifo_busy = true;
+
+	if(submit_i2c_job(&accel_status_job) != NO_ERROR){
+		accel_fifo_busy = false;
+		return I2C_ERROR;
+	}
+#endif
+
+	return NO_ERROR;
+}
+
+#if ADXL343_FIFO_MODE
+// Mean of every FIFO entry collected since the last call. If none arrived
+// (first cycle, or a watermark edge was missed and INT1 is stuck high) drain
+// the FIFO now, which also drops it below the watermark and re-arms the pin
+accel_axis get_accel(){
+
+	accel_axis accel_average = {0};
+	int32_t sum[3];
+	uint16_t samples = take_accel_sums(sum);
+
+	if(samples == 0){
+		uint32_t start = HAL_GetTick();
+
+		collect_accel();
+		while(accel_fifo_busy && (HAL_GetTick() - start) < ERROR_DELAY_MS){
+			serve_sensors();
+			if(accel_fifo_busy){
+				__WFI();
+			}
+		}
+
+		samples = take_accel_sums(sum);
+		if(samples == 0){
+			return accel_average;
+		}
+	}
+
+	accel_average.x_axis_accel = convert_accel(sum[0], samples);
+	accel_average.y_axis_accel = convert_accel(sum[1], samples);
+	accel_average.z_axis_accel = convert_accel(sum[2], samples);
+
+#if ADXL343_EVENT_MODE
+	// Parked, no watermark drains the FIFO: queue the drain for the next call
+	// now, so that one does not wait for it (the unit is still anyway)
+	if(!accel_moving){
+		collect_accel();
+	}
+#endif
+
+	return accel_average;
+}
+#else
 accel_axis get_accel(){
 
-	accel_axis acceleration[SAMPLE_SIZE];
 	accel_axis accel_average;
+	int32_t sum[3] = {0};
 
 	for(uint8_t i=0; i < SAMPLE_SIZE; i++){
 
 		sample_accel();
 
-		acceleration[i].x_axis_accel = (raw_acceleration[0] * ACCEL_SENSE);
-		accel_average.x_axis_accel += acceleration[i].x_axis_accel;
+		sum[0] += raw_acceleration[0];
+		sum[1] += raw_acceleration[1];
+		sum[2] += raw_acceleration[2];
 
-		acceleration[i].y_axis_accel = (raw_acceleration[1] * ACCEL_SENSE);
-		accel_average.y_axis_accel += acceleration[i].y_axis_accel;
-
-		acceleration[i].z_axis_accel = (raw_acceleration[2] * ACCEL_SENSE);
-		accel_average.z_axis_accel += acceleration[i].z_axis_accel;
-
-		wait_delay(ACCEL_DELAY_MS);
+		sensor_delay(ACCEL_DELAY_MS);
 	}
 
 
-	accel_average.x_axis_accel = (accel_average.x_axis_accel / SAMPLE_SIZE) * ACCEL_MG_FACTOR;
-	accel_average.y_axis_accel = (accel_average.y_axis_accel / SAMPLE_SIZE) * ACCEL_MG_FACTOR;
-	accel_average.z_axis_accel = (accel_average.z_axis_accel / SAMPLE_SIZE) * ACCEL_MG_FACTOR;
+	accel_average.x_axis_accel = convert_accel(sum[0], SAMPLE_SIZE);
+	accel_average.y_axis_accel = convert_accel(sum[1], SAMPLE_SIZE);
+	accel_average.z_axis_accel = convert_accel(sum[2], SAMPLE_SIZE);
 
 
 	//PUT ACCEL in sleep mode
@@ -251,7 +660,171 @@ accel_axis get_accel(){
 
 	return accel_average;
 }
+#endif
+
+// False once the ADXL343 reported inactivity (event mode), true otherwise
+bool accel_in_motion(){
+
+	return accel_moving;
+}
+
+
+// -----------------------------------------------------------------	BACKGROUND JOBS		----------------------------------------------------------------------
+
+#if HDC2080_AMM_MODE || ADXL343_FIFO_MODE
+// I2C interrupt (or thread, for a job that failed to start): note the result
+// and wake the main loop, nothing else
+static void sensor_job_done(uint8_t error, void *ctx){
+
+	uint8_t job = (uint8_t)(uintptr_t)ctx;
+
+	uint32_t primask = __get_PRIMASK();
+	__disable_irq();
+
+	if(error != NO_ERROR){
+		sensor_jobs_failed |= job;
+	}
+	sensor_jobs_done |= job;
+
+	__set_PRIMASK(primask);
+
+	if(!event_pending(EVENT_SENSOR_DATA)){
+		post_event(EVENT_SENSOR_DATA, job);
+	}
+}
+#endif
+
+// Finish every job flagged since the last call: DRDY sums and TH/HH, FIFO
+// sums, vibration bands and capture ring, INT1 sources and the next job of
+// the chain. Thread context only, from serve_events() on every main loop wake
+void serve_sensors(){
+
+#if HDC2080_AMM_MODE || ADXL343_FIFO_MODE
+	uint32_t primask = __get_PRIMASK();
+	__disable_irq();
+
+	uint8_t done = sensor_jobs_done;
+	uint8_t failed = sensor_jobs_failed;
+
+	sensor_jobs_done = 0;
+	sensor_jobs_failed = 0;
+
+	__set_PRIMASK(primask);
+#endif
+
+#if HDC2080_AMM_MODE
+	if(done & SENSOR_JOB_HDC_DRDY){
+		hdc_drdy_done((failed & SENSOR_JOB_HDC_DRDY) ? I2C_ERROR : NO_ERROR);
+	}
+#endif
+
+#if ADXL343_FIFO_MODE
+	if(done & SENSOR_JOB_ACCEL_STATUS){
+		accel_status_done((failed & SENSOR_JOB_ACCEL_STATUS) ? I2C_ERROR : NO_ERROR);
+	}
+	if(done & SENSOR_JOB_ACCEL_FIFO){
+		accel_fifo_done((failed & SENSOR_JOB_ACCEL_FIFO) ? I2C_ERROR : NO_ERROR);
+	}
+#endif
+
+#if ADXL343_EVENT_MODE
+	if(done & SENSOR_JOB_ACCEL_SOURCE){
+		accel_source_done((failed & SENSOR_JOB_ACCEL_SOURCE) ? I2C_ERROR : NO_ERROR);
+	}
+#endif
+}
+
+
+// -----------------------------------------------------------------	CONVERSIONS		----------------------------------------------------------------------
+// Integer only: the M0+ has no FPU. Products stay inside 32 bits for the
+// full 16-bit input range and every result is rounded to nearest
+
+// T = raw * 165 / 2^16 - 40.62 -> centi-degC
+int16_t convert_temperature(uint16_t raw){
+
+	return (int16_t)((raw * 16500UL + 0x8000) >> 16) - TEMP_OFFSET_CENTI;
+}
+
+// RH = raw * 100 / 2^16 -> centi-%RH
+uint16_t convert_humidity(uint16_t raw){
+
+	return (uint16_t)((raw * 10000UL + 0x8000) >> 16);
+}
+
+// Whole units straight from the code for what gets printed: rounding the
+// centi result again would move the x.495..x.505 band to the wrong integer
+int16_t convert_temperature_whole(uint16_t raw){
+
+	return (int16_t)div_round((int32_t)(raw * 16500UL) - TEMP_OFFSET_CENTI * 65536L, CENTI * 65536L);
+}
+
+uint16_t convert_humidity_whole(uint16_t raw){
+
+	return (uint16_t)((raw * 100UL + 0x8000) >> 16);
+}
+
+// Mean of samples raw readings -> mg
+int16_t convert_accel(int32_t raw_sum, uint16_t samples){
+
+	if(samples == 0){
+		return 0;
+	}
+
+	return (int16_t)div_round(raw_sum * ACCEL_MG_PER_LSB, samples);
+}
+
+// TEMP_MAX register: 256 * (T + 40) / 165, truncated
+uint8_t temp_threshold_code(uint8_t temp_max){
+
+	uint16_t code = (256 * (temp_max + 40)) / 165;
+
+	return code > 0xFF ? 0xFF : code;
+}
+
+// HUM_MAX register: 256 * RH / 100, truncated (100 %RH saturates at 0xFF)
+uint8_t hum_threshold_code(uint8_t hum_max){
 
+	uint16_t code = (256 * hum_max) / 100;
+
+	return code > 0xFF ? 0xFF : code;
+}
+
+// num / den rounded half away from zero, as roundf() does
+int32_t div_round(int32_t num, int32_t den){
+
+	if((num < 0) != (den < 0)){
+		return (num - den / 2) / den;
+	}
+	return (num + den / 2) / den;
+}
+
+// Square root rounded to nearest, bit by bit (no divider on the M0+)
+uint32_t isqrt_round(uint32_t value){
+
+	uint32_t root = 0;
+	uint32_t bit = 1UL << 30;
+
+	while(bit > value){
+		bit >>= 2;
+	}
+
+	while(bit != 0){
+		if(value >= root + bit){
+			value -= root + bit;
+			root = (root >> 1) + bit;
+		} else {
+			root >>= 1;
+		}
+		bit >>= 2;
+	}
+
+	// What is left is over root^2
+	if(value > root){
+		root++;
+	}
+
+	return root;
+}
 
 // -------------------------------------------------------------------------------------------------------------------------------------------------------------------
 
@@ -259,13 +832,9 @@ accel_axis get_accel(){
 bool check_threshold_active(){
 
 	uint8_t threshold_reg_data[1];
-	uint8_t reading_command[1];
 
 	// ADDR 0X04 -> Interrupt DRDY -> Read interrupt source
-	reading_command[0] = 0x04;
-
-	write_i2c_sensor(HDC2080_ADDR, reading_command, sizeof(reading_command));
-	read_i2c_sensor(HDC2080_ADDR, threshold_reg_data, sizeof(threshold_reg_data));
+	read_i2c_register(HDC2080_ADDR, HDC2080_REG_INT_DRDY, threshold_reg_data, sizeof(threshold_reg_data));
 
 	// Check bit 6 -> TEMP | bit 4 -> HUM
 	if(threshold_reg_data[0] & (1 << TEMP_INT_BIT) || threshold_reg_data[0] & (1 << HUM_INT_BIT)){
@@ -280,7 +849,7 @@ bool check_threshold_active(){
 		return true;
 	}
 
-	// Check ADXL343 INT thresholds
+	// ADXL343 events (shock, free fall, motion) arrive through the INT1 collector
 
 	return false;
 }
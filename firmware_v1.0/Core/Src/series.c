@@ -0,0 +1,640 @@
+/*
+ * series.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: dst2001055
+ */
+
+#include "series.h"
+#include "frame.h"
+#include <string.h>
+
+#define SERIES_WIDTH_MAX 14			// widest delta stored at its own width
+#define SERIES_WIDE 17				// zig-zag of any int16 difference
+
+#define SERIES_VALID_STEP(step) ((step) == 1 || (step) == 2 || (step) == 4 || (step) == 5 || \
+								 (step) == 10 || (step) == 20 || (step) == 50 || (step) == 100)
+
+_Static_assert(SERIES_VALID_STEP(SERIES_TEMP_STEP) && SERIES_VALID_STEP(SERIES_HUM_STEP) && SERIES_VALID_STEP(SERIES_ACCEL_STEP),
+			   "series steps are 1, 2, 4, 5, 10, 20, 50 or 100, 1 = lossless");
+
+static const uint8_t series_step_codes[1 << SERIES_STEP_BITS] = {1, 2, 4, 5, 10, 20, 50, 100};
+
+static const uint8_t series_steps[SERIES_MAX_CHANNELS] = {
+	SERIES_TEMP_STEP, SERIES_HUM_STEP, SERIES_ACCEL_STEP, SERIES_ACCEL_STEP, SERIES_ACCEL_STEP
+};
+
+// Nearest step, halves away from zero
+static int16_t quantise(int32_t value, uint8_t step){
+	return (int16_t)((value >= 0 ? value + step / 2 : value - step / 2) / step);
+}
+
+//----------------------------------------- BITS -------------------------------------------------------
+
+static void put_bits(uint8_t *buf, uint16_t pos, uint32_t value, uint8_t bits){
+
+	for(uint8_t i = 0; i < bits; i++, pos++){
+		uint8_t mask = 1U << (pos & 7);
+
+		if(value & (1UL << i)){
+			buf[pos >> 3] |= mask;
+		} else {
+			buf[pos >> 3] &= ~mask;
+		}
+	}
+}
+
+static uint32_t get_bits(const uint8_t *buf, uint16_t pos, uint8_t bits){
+
+	uint32_t value = 0;
+
+	for(uint8_t i = 0; i < bits; i++, pos++){
+		if(buf[pos >> 3] & (1U << (pos & 7))){
+			value |= 1UL << i;
+		}
+	}
+
+	return value;
+}
+
+static uint8_t bit_width(uint32_t value){
+
+	uint8_t width = 0;
+
+	while(value != 0){
+		width++;
+		value >>= 1;
+	}
+
+	return width;
+}
+
+static uint8_t width_code(uint8_t width){
+	return (width > SERIES_WIDTH_MAX) ? SERIES_WIDTH_WIDE : width;
+}
+
+static uint8_t code_width(uint8_t code){
+	return (code == SERIES_WIDTH_WIDE) ? SERIES_WIDE : code;
+}
+
+// Samples a section can count: its count field, no more than the chunk has bits
+static uint8_t count_bits(uint16_t chunk){
+	return bit_width((uint32_t)chunk * 8);
+}
+
+//----------------------------------------- ENCODER ----------------------------------------------------
+
+static bool series_regular(const series_encoder *enc){
+	return enc->base == enc->step && enc->time_width == 0;
+}
+
+static uint16_t series_header_bits(const series_encoder *enc){
+
+	uint16_t bits = (enc->full ? 0 : enc->count_bits) + 4 + SERIES_WIDTH_BITS * enc->channels;
+
+	if(SERIES_LOSSY){
+		bits += SERIES_STEP_BITS * enc->channels;
+	}
+	if(!series_regular(enc)){
+		bits += 2 * SERIES_TIME_WIDTH_BITS + bit_width(zigzag_encode(enc->base));
+	}
+
+	return bits;
+}
+
+static uint16_t series_sample_bits(const series_encoder *enc){
+
+	uint16_t bits = enc->time_width;
+
+	for(uint8_t c = 0; c < enc->channels; c++){
+		bits += enc->width[c];
+	}
+
+	return bits;
+}
+
+// count samples in this layout: with their count, or with F when they are
+// exactly as many as the chunk holds
+static bool series_fits(const series_encoder *enc, uint16_t count){
+
+	uint32_t data = (uint32_t)enc->start + series_header_bits(enc);
+	uint16_t bits = series_sample_bits(enc);
+
+	if(data + (uint32_t)count * bits > enc->end){
+		return false;
+	}
+	if(enc->full){
+		return bits > 0 && (enc->end - data) / bits == count;
+	}
+	return count < (1U << enc->count_bits);
+}
+
+static uint32_t series_residual(const series_encoder *enc, int32_t step){
+	return zigzag_encode((int32_t)((uint32_t)step - (uint32_t)enc->base));
+}
+
+// Widths that take this sample too
+static void series_widen(series_encoder *enc, int32_t step, const uint32_t *delta){
+
+	uint8_t width = bit_width(series_residual(enc, step));
+
+	if(width > enc->time_width){
+		enc->time_width = width;
+	}
+	for(uint8_t c = 0; c < enc->channels; c++){
+		width = code_width(width_code(bit_width(delta[c])));
+		if(width > enc->width[c]){
+			enc->width[c] = width;
+		}
+	}
+}
+
+static void series_put_sample(series_encoder *enc, uint16_t index, uint32_t residual, const uint32_t *delta){
+
+	uint16_t pos = enc->start + series_header_bits(enc) + index * series_sample_bits(enc);
+
+	put_bits(enc->buf, pos, residual, enc->time_width);
+	pos += enc->time_width;
+	for(uint8_t c = 0; c < enc->channels; c++){
+		put_bits(enc->buf, pos, delta[c], enc->width[c]);
+		pos += enc->width[c];
+	}
+}
+
+static void series_move(const series_encoder *from, series_encoder *to, uint16_t index){
+
+	uint16_t pos = from->start + series_header_bits(from) + index * series_sample_bits(from);
+	uint32_t residual = get_bits(from->buf, pos, from->time_width);
+	uint32_t delta[SERIES_MAX_CHANNELS];
+
+	pos += from->time_width;
+	for(uint8_t c = 0; c < from->channels; c++){
+		delta[c] = get_bits(from->buf, pos, from->width[c]);
+		pos += from->width[c];
+	}
+	series_put_sample(to, index, residual, delta);
+}
+
+// Move the section's samples to the layout of next: down over the dropped count
+// first one first, then out to the wider widths last one first, so none is
+// overwritten before it is read
+static void series_repack(const series_encoder *enc, series_encoder *next){
+
+	series_encoder shifted = *enc;
+
+	if(next->full && !enc->full){
+		shifted.full = true;
+		for(uint16_t i = 0; i < enc->count; i++){
+			series_move(enc, &shifted, i);
+		}
+	}
+	for(uint16_t i = shifted.count; i-- > 0;){
+		series_move(&shifted, next, i);
+	}
+}
+
+// Same widths without the count when the samples fill the chunk
+static void series_fill(series_encoder *enc){
+
+	series_encoder full = *enc;
+
+	full.full = true;
+	if(!enc->full && series_fits(&full, enc->count)){
+		series_repack(enc, &full);
+		*enc = full;
+	}
+}
+
+static void series_write_header(series_encoder *enc, bool linked){
+
+	uint16_t pos = enc->start;
+	bool regular = series_regular(enc);
+
+	put_bits(enc->buf, pos++, enc->full, 1);
+	if(!enc->full){
+		put_bits(enc->buf, pos, enc->count, enc->count_bits);
+		pos += enc->count_bits;
+	}
+	put_bits(enc->buf, pos++, linked, 1);
+	put_bits(enc->buf, pos++, SERIES_LOSSY, 1);
+
+	for(uint8_t c = 0; SERIES_LOSSY && c < enc->channels; c++){
+		uint8_t code = 0;
+
+		while(series_step_codes[code] != series_steps[c]){
+			code++;
+		}
+		put_bits(enc->buf, pos, code, SERIES_STEP_BITS);
+		pos += SERIES_STEP_BITS;
+	}
+
+	put_bits(enc->buf, pos++, regular, 1);
+	if(!regular){
+		uint32_t base = zigzag_encode(enc->base);
+		uint8_t width = bit_width(base);
+
+		put_bits(enc->buf, pos, width, SERIES_TIME_WIDTH_BITS);
+		pos += SERIES_TIME_WIDTH_BITS;
+		put_bits(enc->buf, pos, base, width);
+		pos += width;
+		put_bits(enc->buf, pos, enc->time_width, SERIES_TIME_WIDTH_BITS);
+		pos += SERIES_TIME_WIDTH_BITS;
+	}
+
+	for(uint8_t c = 0; c < enc->channels; c++){
+		put_bits(enc->buf, pos, width_code(enc->width[c]), SERIES_WIDTH_BITS);
+		pos += SERIES_WIDTH_BITS;
+	}
+}
+
+// Open a section for this sample in the first chunk from len with room for
+// it, writes nothing. False when the block has none left
+static bool series_place(series_encoder *enc, int32_t step, const uint32_t *delta){
+
+	while(enc->len < enc->size){
+		uint16_t end = (enc->len / enc->chunk + 1) * enc->chunk;
+
+		if(end > enc->size){
+			end = enc->size;
+		}
+
+		enc->start = enc->len * 8;
+		enc->end = end * 8;
+		enc->count = 0;
+		enc->full = false;
+		enc->base = step;
+		enc->time_width = 0;
+		memset(enc->width, 0, sizeof(enc->width));
+		series_widen(enc, step, delta);
+
+		if(series_fits(enc, 1)){
+			return true;
+		}
+		enc->len = end;		// left as padding, only the rest of the anchor chunk can be too short
+	}
+
+	return false;
+}
+
+static void series_deltas(const series_encoder *enc, const series_sample *sample, int16_t *q, int32_t *step, uint32_t *delta){
+
+	for(uint8_t c = 0; c < enc->channels; c++){
+		q[c] = quantise(sample->value[c], series_steps[c]);
+		delta[c] = zigzag_encode(q[c] - enc->last[c]);
+	}
+	*step = (int32_t)(sample->time - enc->time);
+}
+
+void series_begin(series_encoder *enc, uint8_t *buf, uint16_t size, uint16_t chunk, uint8_t channels, int32_t step){
+
+	memset(buf, 0, size);
+
+	enc->buf = buf;
+	enc->size = size;
+	enc->chunk = chunk;
+	enc->channels = (channels > SERIES_MAX_CHANNELS) ? SERIES_MAX_CHANNELS : channels;
+	enc->count_bits = count_bits(enc->chunk);
+	enc->step = step;
+	enc->len = 0;
+	enc->samples = 0;
+	enc->time = 0;
+	enc->count = 0;
+}
+
+// Next block into the same buffer, anchored on the last sample of this one.
+// Finish this one with series_finish(enc, true) first
+void series_continue(series_encoder *enc){
+
+	series_sample anchor = {.time = enc->time};
+
+	for(uint8_t c = 0; c < enc->channels; c++){
+		anchor.value[c] = (int16_t)(enc->last[c] * series_steps[c]);
+	}
+
+	series_begin(enc, enc->buf, enc->size, enc->chunk, enc->channels, enc->step);
+	series_add(enc, &anchor);
+}
+
+// Whether a block continued from this one takes sample right after its anchor,
+// it does not when the time jump needs a wider section than a chunk holds
+bool series_linkable(const series_encoder *enc, const series_sample *sample){
+
+	series_encoder next = *enc;
+	int16_t q[SERIES_MAX_CHANNELS];
+	int32_t step;
+	uint32_t delta[SERIES_MAX_CHANNELS];
+
+	if(enc->samples == 0){
+		return false;
+	}
+
+	series_deltas(enc, sample, q, &step, delta);
+	next.len = SERIES_ANCHOR_BITS(enc->channels) / 8;
+
+	return series_place(&next, step, delta);
+}
+
+// Returns false, leaving the block untouched, when the sample does not fit:
+// finish the block and start a new one with it
+bool series_add(series_encoder *enc, const series_sample *sample){
+
+	int16_t q[SERIES_MAX_CHANNELS];
+	int32_t step;
+	uint32_t delta[SERIES_MAX_CHANNELS];
+
+	// First sample: the anchor, exact in its quantised units
+	if(enc->samples == 0){
+		uint16_t bits = SERIES_ANCHOR_BITS(enc->channels);
+
+		if(enc->chunk * 8 < bits || enc->size * 8 < bits){
+			return false;
+		}
+
+		put_bits(enc->buf, 0, sample->time, 32);
+		for(uint8_t c = 0; c < enc->channels; c++){
+			enc->last[c] = quantise(sample->value[c], series_steps[c]);
+			put_bits(enc->buf, 32 + 16 * c, (uint16_t)(enc->last[c] * series_steps[c]), 16);
+		}
+
+		enc->len = bits / 8;
+		enc->time = sample->time;
+		enc->samples = 1;
+		return true;
+	}
+
+	series_deltas(enc, sample, q, &step, delta);
+
+	if(enc->count > 0){
+		series_encoder next = *enc;
+
+		series_widen(&next, step, delta);
+		if(!series_fits(&next, enc->count + 1)){
+			next.full = true;
+		}
+		if(series_fits(&next, enc->count + 1)){
+			if(series_sample_bits(&next) != series_sample_bits(enc) || series_header_bits(&next) != series_header_bits(enc)){
+				series_repack(enc, &next);
+			}
+			*enc = next;
+		} else {
+			// Section full: it keeps its chunk, the sample opens one in the next
+			next = *enc;
+			next.len = enc->end / 8;
+			if(!series_place(&next, step, delta)){
+				return false;
+			}
+			series_fill(enc);
+			series_write_header(enc, false);
+			*enc = next;
+		}
+	} else {
+		series_encoder next = *enc;
+
+		if(!series_place(&next, step, delta)){
+			return false;
+		}
+		*enc = next;
+	}
+
+	series_put_sample(enc, enc->count++, series_residual(enc, step), delta);
+
+	for(uint8_t c = 0; c < enc->channels; c++){
+		enc->last[c] = q[c];
+	}
+	enc->time = sample->time;
+	enc->samples++;
+
+	return true;
+}
+
+// Writes the open section's header, returns the block length. linked: the
+// next block continues from the last sample (series_continue())
+uint16_t series_finish(series_encoder *enc, bool linked){
+
+	if(enc->count > 0){
+		series_fill(enc);
+		series_write_header(enc, linked);
+		enc->len = (uint16_t)((enc->start + series_header_bits(enc) + (uint32_t)enc->count * series_sample_bits(enc) + 7) / 8);
+	}
+
+	return enc->len;
+}
+
+//----------------------------------------- DECODER ----------------------------------------------------
+
+static void series_decoder_init(series_decoder *dec, const uint8_t *buf, uint16_t len, uint16_t chunk, uint8_t channels, int32_t step){
+
+	dec->buf = buf;
+	dec->len = len;
+	dec->chunk = chunk;
+	dec->channels = channels;
+	dec->count_bits = count_bits(dec->chunk);
+	dec->step = step;
+	dec->pos = 0;
+	dec->end = 0;
+	dec->count = 0;
+	dec->anchor = false;
+	dec->linked = false;
+	dec->time = 0;
+
+	for(uint8_t c = 0; c < SERIES_MAX_CHANNELS; c++){
+		dec->last[c] = 0;
+		dec->value_step[c] = 1;
+	}
+}
+
+static bool series_read(series_decoder *dec, uint8_t bits, uint32_t *value){
+
+	if(dec->pos + bits > dec->end){
+		return false;
+	}
+	*value = get_bits(dec->buf, dec->pos, bits);
+	dec->pos += bits;
+	return true;
+}
+
+// Header of the next section with samples, false at the end of the block or on bad data
+static bool series_read_section(series_decoder *dec){
+
+	uint32_t value;
+
+	while(dec->pos < (uint32_t)dec->len * 8){
+		uint32_t end = ((uint32_t)dec->pos / 8 / dec->chunk + 1) * dec->chunk;
+
+		dec->end = (uint16_t)((end < dec->len ? end : dec->len) * 8);
+
+		uint32_t full, count = 0;
+
+		// Padding: the rest of the anchor chunk, a short last chunk or erased EEPROM
+		if(!series_read(dec, 1, &full) || (!full && (!series_read(dec, dec->count_bits, &count) || count == 0))){
+			dec->pos = dec->end;
+			continue;
+		}
+
+		if(!series_read(dec, 1, &value)){
+			return false;
+		}
+		dec->linked = value;
+
+		if(!series_read(dec, 1, &value)){
+			return false;
+		}
+		for(uint8_t c = 0; c < dec->channels; c++){
+			uint32_t code = 0;
+
+			if(value && !series_read(dec, SERIES_STEP_BITS, &code)){
+				return false;
+			}
+			dec->value_step[c] = series_step_codes[code];
+		}
+
+		if(!series_read(dec, 1, &value)){
+			return false;
+		}
+		dec->base = dec->step;
+		dec->time_width = 0;
+		if(!value){
+			uint32_t width, base, time_width;
+
+			if(!series_read(dec, SERIES_TIME_WIDTH_BITS, &width) || width > 32 || !series_read(dec, (uint8_t)width, &base) ||
+			   !series_read(dec, SERIES_TIME_WIDTH_BITS, &time_width) || time_width > 32){
+				return false;
+			}
+			dec->base = zigzag_decode(base);
+			dec->time_width = (uint8_t)time_width;
+		}
+
+		uint32_t bits = dec->time_width;
+
+		for(uint8_t c = 0; c < dec->channels; c++){
+			if(!series_read(dec, SERIES_WIDTH_BITS, &value)){
+				return false;
+			}
+			dec->width[c] = code_width((uint8_t)value);
+			bits += dec->width[c];
+		}
+
+		// With F: as many as the rest of the chunk holds
+		if(full){
+			if(bits == 0){
+				return false;
+			}
+			count = (dec->end - dec->pos) / bits;
+		}
+		dec->count = (uint16_t)count;
+
+		return count > 0 && dec->pos + bits * count <= dec->end;
+	}
+
+	return false;
+}
+
+// Next time step and value deltas, in the section's quantised units
+static bool series_read_sample(series_decoder *dec, int32_t *step, int32_t *delta){
+
+	uint32_t value = 0;
+
+	while(dec->count == 0){
+		if(!series_read_section(dec)){
+			return false;
+		}
+	}
+
+	series_read(dec, dec->time_width, &value);
+	*step = (int32_t)((uint32_t)dec->base + (uint32_t)zigzag_decode(value));
+
+	for(uint8_t c = 0; c < dec->channels; c++){
+		series_read(dec, dec->width[c], &value);
+		delta[c] = zigzag_decode(value);
+	}
+
+	// Sections never share a chunk
+	if(--dec->count == 0){
+		dec->pos = dec->end;
+	}
+
+	return true;
+}
+
+bool series_open(series_decoder *dec, const uint8_t *buf, uint16_t len, uint16_t chunk, uint8_t channels, int32_t step){
+
+	uint16_t bits = SERIES_ANCHOR_BITS(channels);
+
+	if(channels == 0 || channels > SERIES_MAX_CHANNELS || (uint32_t)len * 8 < bits || chunk * 8 < bits){
+		return false;
+	}
+
+	series_decoder_init(dec, buf, len, chunk, channels, step);
+
+	dec->time = get_bits(buf, 0, 32);
+	for(uint8_t c = 0; c < channels; c++){
+		dec->last[c] = (int16_t)get_bits(buf, 32 + 16 * c, 16);
+	}
+	dec->pos = bits;
+	dec->anchor = true;
+
+	return true;
+}
+
+// Chunks of a block whose anchor is gone. The last one must be linked: next
+// (the anchor of the following block) is their last sample, the samples
+// before it are its values less the deltas that lead up to it
+bool series_open_orphans(series_decoder *dec, const uint8_t *buf, uint16_t len, uint16_t chunk, uint8_t channels,
+						 int32_t step, const series_sample *next){
+
+	series_decoder scan;
+	int32_t sample_step;
+	int32_t delta[SERIES_MAX_CHANNELS];
+	int32_t sum[SERIES_MAX_CHANNELS] = {0};
+	uint32_t span = 0;
+
+	if(channels == 0 || channels > SERIES_MAX_CHANNELS || len == 0 || chunk == 0){
+		return false;
+	}
+
+	series_decoder_init(&scan, buf, len, chunk, channels, step);
+	while(series_read_sample(&scan, &sample_step, delta)){
+		span += (uint32_t)sample_step;
+		for(uint8_t c = 0; c < channels; c++){
+			sum[c] += delta[c];
+		}
+	}
+	if(!scan.linked){
+		return false;
+	}
+
+	series_decoder_init(dec, buf, len, chunk, channels, step);
+	dec->time = next->time - span;
+	for(uint8_t c = 0; c < channels; c++){
+		dec->value_step[c] = scan.value_step[c];
+		dec->last[c] = (int16_t)((quantise(next->value[c], scan.value_step[c]) - sum[c]) * scan.value_step[c]);
+	}
+
+	return true;
+}
+
+// Next sample in native units, false at the end of the block or on bad data
+bool series_next(series_decoder *dec, series_sample *sample){
+
+	int32_t step;
+	int32_t delta[SERIES_MAX_CHANNELS];
+
+	if(dec->anchor){
+		dec->anchor = false;
+	} else {
+		if(!series_read_sample(dec, &step, delta)){
+			return false;
+		}
+		dec->time += (uint32_t)step;
+		for(uint8_t c = 0; c < dec->channels; c++){
+			dec->last[c] = (int16_t)((quantise(dec->last[c], dec->value_step[c]) + delta[c]) * dec->value_step[c]);
+		}
+	}
+
+	sample->time = dec->time;
+	for(uint8_t c = 0; c < SERIES_MAX_CHANNELS; c++){
+		sample->value[c] = (c < dec->channels) ? dec->last[c] : 0;
+	}
+
+	return true;
+}
@@ -0,0 +1,85 @@
+/*
+ * stats.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: dst2001055
+ */
+
+#include "stats.h"
+#include "sensors.h"
+
+// Rounded to nearest, halves away from zero, den > 0
+static int32_t div_round64(int64_t num, uint32_t den){
+
+	return (int32_t)((num >= 0 ? num + den / 2 : num - (int64_t)(den / 2)) / (int64_t)den);
+}
+
+void stats_reset(channel_stats *stats){
+
+	stats->count = 0;
+	stats->min = 0;
+	stats->max = 0;
+	stats->min_time = 0;
+	stats->max_time = 0;
+	stats->sum = 0;
+	stats->mean = 0;
+	stats->m2 = 0;
+}
+
+void stats_add(channel_stats *stats, int16_t value, uint32_t time){
+
+	int32_t x = (int32_t)value * (1 << STATS_FRAC_BITS);
+
+	if(stats->count == UINT32_MAX){
+		return;
+	}
+
+	if(stats->count == 0 || value < stats->min){
+		stats->min = value;
+		stats->min_time = time;
+	}
+	if(stats->count == 0 || value > stats->max){
+		stats->max = value;
+		stats->max_time = time;
+	}
+
+	// Welford's M2 step: (x - old mean) * (x - new mean). Both means are
+	// rounded, so a reading right on the mean can give a tiny negative term
+	stats->count++;
+	stats->sum += value;
+	int32_t delta = x - stats->mean;
+	stats->mean = div_round64(stats->sum * (1 << STATS_FRAC_BITS), stats->count);
+	int32_t delta2 = x - stats->mean;
+
+	int64_t product = (int64_t)delta * delta2;
+	uint64_t term = (product > 0) ? (uint64_t)product : 0;
+
+	stats->m2 = (UINT64_MAX - stats->m2 < term) ? UINT64_MAX : stats->m2 + term;
+}
+
+// Rounded to the channel unit
+int16_t stats_mean(const channel_stats *stats){
+
+	return (int16_t)div_round(stats->mean, 1 << STATS_FRAC_BITS);
+}
+
+// Sample variance in channel units squared, 0 below two readings
+uint32_t stats_variance(const channel_stats *stats){
+
+	if(stats->count < 2){
+		return 0;
+	}
+
+	uint64_t den = (uint64_t)(stats->count - 1) << (2 * STATS_FRAC_BITS);
+	uint64_t variance = (stats->m2 / den) + ((stats->m2 % den) >= den / 2 ? 1 : 0);
+
+	return (variance > UINT32_MAX) ? UINT32_MAX : (uint32_t)variance;
+}
+
+// Standard deviation in channel units, integer square root of the variance
+uint16_t stats_stddev(const channel_stats *stats){
+
+	uint32_t root = isqrt_round(stats_variance(stats));
+
+	return (root > UINT16_MAX) ? UINT16_MAX : (uint16_t)root;
+}
@@ -0,0 +1,170 @@
+/*
+ * uplink.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: dst2001055
+ */
+
+#include <string.h>
+#include "uplink.h"
+#include "mal.h"
+#include "frame.h"
+
+// Header + vibration summary + series block, encode_frame() appends the CRC in place.
+// The block is encoded right after the header and moved up if a summary goes in
+static uint8_t uplink_payload[UPLINK_HEADER_SIZE + UPLINK_VIB_SIZE + UPLINK_BLOCK_SIZE + FRAME_CRC_SIZE];
+// Sent by DMA, rewritten only once comms_UART_busy() clears
+static uint8_t uplink_frame[FRAME_ENCODED_SIZE(UPLINK_HEADER_SIZE + UPLINK_VIB_SIZE + UPLINK_BLOCK_SIZE)];
+
+static series_encoder uplink_series;
+static uint8_t uplink_batch = UPLINK_BATCH;
+static uint8_t uplink_pending = 0;		// readings in the open block
+static uint16_t uplink_seq = 0;
+
+// Field by field maximum of the batch's vibration features
+static vibration_features uplink_vibration;
+static bool uplink_has_vibration = false;
+
+static uplink_stats uplink_counters = {0};
+
+void uplink_config(uint8_t batch){
+
+	if(batch == 0){
+		batch = 1;
+	}
+	if(batch > UPLINK_BATCH_MAX){
+		batch = UPLINK_BATCH_MAX;
+	}
+
+	uplink_batch = batch;
+}
+
+static void uplink_begin(){
+	series_begin(&uplink_series, &uplink_payload[UPLINK_HEADER_SIZE], UPLINK_BLOCK_SIZE, UPLINK_BLOCK_SIZE, SERIES_MAX_CHANNELS, 0);
+	memset(&uplink_vibration, 0, sizeof(uplink_vibration));
+	uplink_has_vibration = false;
+}
+
+static void merge_max(uint16_t *max, const uint16_t *value, uint8_t count){
+
+	for(uint8_t i = 0; i < count; i++){
+		if(value[i] > max[i]){
+			max[i] = value[i];
+		}
+	}
+}
+
+static void uplink_merge_vibration(const vibration_features *vibration){
+
+	if(vibration->samples == 0){
+		return;
+	}
+
+	merge_max(uplink_vibration.rms, vibration->rms, 3);
+	merge_max(uplink_vibration.peak_to_peak, vibration->peak_to_peak, 3);
+	merge_max(uplink_vibration.crest, vibration->crest, 3);
+	merge_max(uplink_vibration.band, vibration->band, VIB_BANDS);
+	uplink_has_vibration = true;
+}
+
+// Summary in front of the series block, returns its size
+static uint16_t uplink_put_vibration(uint16_t block_len){
+
+	const uint16_t *fields[] = {uplink_vibration.rms, uplink_vibration.peak_to_peak, uplink_vibration.crest, uplink_vibration.band};
+	const uint8_t counts[] = {3, 3, 3, VIB_BANDS};
+	uint8_t summary[UPLINK_VIB_SIZE];
+	uint16_t size = 0;
+
+	for(uint8_t f = 0; f < 4; f++){
+		for(uint8_t i = 0; i < counts[f]; i++){
+			size += put_varint(&summary[size], fields[f][i]);
+		}
+	}
+
+	memmove(&uplink_payload[UPLINK_HEADER_SIZE + size], &uplink_payload[UPLINK_HEADER_SIZE], block_len);
+	memcpy(&uplink_payload[UPLINK_HEADER_SIZE], summary, size);
+
+	return size;
+}
+
+// Sends the open block, if any. seq advances on dropped frames too, so the
+// receiver sees the gap
+uint8_t uplink_flush(uint8_t flags){
+
+	if(uplink_pending == 0){
+		return NO_ERROR;
+	}
+
+	uint16_t len = series_finish(&uplink_series, false);
+
+	if(uplink_has_vibration){
+		len += uplink_put_vibration(len);
+		flags |= UPLINK_FLAG_VIBRATION;
+	}
+
+	uplink_pending = 0;
+
+	uplink_payload[0] = FRAME_TYPE_UPLINK;
+	uplink_payload[1] = flags;
+	uplink_payload[2] = (uint8_t)uplink_seq;
+	uplink_payload[3] = (uint8_t)(uplink_seq >> 8);
+	uplink_seq++;
+
+	if(wait_comms_UART(UPLINK_TX_WAIT_MS) != NO_ERROR){
+		uplink_counters.dropped++;
+		return COMMS_ERROR;
+	}
+
+	uint16_t size = encode_frame(uplink_payload, UPLINK_HEADER_SIZE + len, uplink_frame, sizeof(uplink_frame));
+
+	if(size == 0 || send_UART_data(COMMS_UART_NUM, uplink_frame, size) != NO_ERROR){
+		uplink_counters.dropped++;
+		return COMMS_ERROR;
+	}
+
+	uplink_counters.frames++;
+	uplink_counters.bytes += size;
+	if(flags & UPLINK_FLAG_ANOMALY){
+		uplink_counters.anomaly_frames++;
+	}
+
+	return NO_ERROR;
+}
+
+// vibration may be NULL: no features for this reading
+uint8_t uplink_add(const series_sample *sample, const vibration_features *vibration, uint8_t flags){
+
+	uint8_t error = NO_ERROR;
+
+	if(uplink_pending == 0){
+		uplink_begin();
+	}
+
+	// Block full before the batch: send what is in, the reading opens the next one
+	if(!series_add(&uplink_series, sample)){
+		error = uplink_flush(0);
+		uplink_begin();
+		series_add(&uplink_series, sample);
+	}
+
+	if(vibration != NULL){
+		uplink_merge_vibration(vibration);
+	}
+
+	uplink_pending++;
+	uplink_counters.readings++;
+
+	if(flags != 0 || uplink_pending >= uplink_batch){
+		uint8_t flush_error = uplink_flush(flags);
+
+		if(flush_error != NO_ERROR){
+			error = flush_error;
+		}
+	}
+
+	return error;
+}
+
+uplink_stats get_uplink_stats(){
+	return uplink_counters;
+}
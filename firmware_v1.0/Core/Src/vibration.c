@@ -0,0 +1,172 @@
+/*
+ * vibration.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: dst2001055
+ */
+
+#include <string.h>
+#include "vibration.h"
+#include "sensors.h"
+
+// round(2cos(2 pi k / VIB_BLOCK) * 2^VIB_COEF_BITS), k = 1..VIB_BINS
+static const int16_t vib_coef[VIB_BINS] = {7568, 5793, 3135, 0, -3135, -5793, -7568};
+static const uint8_t vib_band_of_bin[VIB_BINS] = {
+	VIB_BAND_SWAY, VIB_BAND_LOW, VIB_BAND_MID, VIB_BAND_MID, VIB_BAND_HIGH, VIB_BAND_HIGH, VIB_BAND_HIGH
+};
+
+// What a window hands over, raw LSB
+typedef struct{
+	uint16_t samples;
+	uint16_t blocks;
+	int32_t sum[3];
+	uint64_t sum_sq[3];
+	int16_t min[3];
+	int16_t max[3];
+	uint64_t power[VIB_BANDS];		// Goertzel |X|^2, summed over blocks and axes
+}vibration_window;
+
+static vibration_window vib_window;
+
+// Goertzel states of the open block. Fed the samples minus the previous block
+// mean: the bins ignore DC anyway, this keeps gravity out of the states
+static int32_t vib_s1[3][VIB_BINS];
+static int32_t vib_s2[3][VIB_BINS];
+static int32_t vib_block_sum[3];
+static int16_t vib_dc[3];
+static uint8_t vib_block_pos = 0;
+
+void vibration_reset(){
+
+	memset(&vib_window, 0, sizeof(vib_window));
+	memset(vib_s1, 0, sizeof(vib_s1));
+	memset(vib_s2, 0, sizeof(vib_s2));
+	memset(vib_block_sum, 0, sizeof(vib_block_sum));
+	memset(vib_dc, 0, sizeof(vib_dc));
+	vib_block_pos = 0;
+}
+
+// Block done: |X_k|^2 = s1^2 + s2^2 - coef * s1 * s2 into the bands, restart
+static void vibration_end_block(){
+
+	for(uint8_t axis = 0; axis < 3; axis++){
+		for(uint8_t k = 0; k < VIB_BINS; k++){
+			int64_t s1 = vib_s1[axis][k];
+			int64_t s2 = vib_s2[axis][k];
+			int64_t power = s1 * s1 + s2 * s2 - ((vib_coef[k] * s1 * s2) >> VIB_COEF_BITS);
+
+			// Coefficient rounding can take a silent bin just below zero
+			if(power > 0){
+				vib_window.power[vib_band_of_bin[k]] += (uint64_t)power;
+			}
+			vib_s1[axis][k] = 0;
+			vib_s2[axis][k] = 0;
+		}
+
+		vib_dc[axis] = (int16_t)(vib_block_sum[axis] / VIB_BLOCK);
+		vib_block_sum[axis] = 0;
+	}
+
+	vib_block_pos = 0;
+	vib_window.blocks++;
+}
+
+// One FIFO entry, from serve_sensors(): 21 multiply-adds, the block end 21 more.
+// A full window stops taking samples until vibration_take()
+void vibration_add(const int16_t raw[3]){
+
+	if(vib_window.samples == UINT16_MAX || vib_window.blocks == UINT16_MAX){
+		return;
+	}
+
+	for(uint8_t axis = 0; axis < 3; axis++){
+		int16_t value = raw[axis];
+		int32_t x = value - vib_dc[axis];
+
+		if(vib_window.samples == 0 || value < vib_window.min[axis]) vib_window.min[axis] = value;
+		if(vib_window.samples == 0 || value > vib_window.max[axis]) vib_window.max[axis] = value;
+		vib_window.sum[axis] += value;
+		vib_window.sum_sq[axis] += (uint32_t)(value * value);
+		vib_block_sum[axis] += value;
+
+		// s0 = x + coef * s1 - s2, rounded Q12 product (arithmetic shift)
+		for(uint8_t k = 0; k < VIB_BINS; k++){
+			int32_t s0 = x + ((vib_coef[k] * vib_s1[axis][k] + (1 << (VIB_COEF_BITS - 1))) >> VIB_COEF_BITS) - vib_s2[axis][k];
+
+			vib_s2[axis][k] = vib_s1[axis][k];
+			vib_s1[axis][k] = s0;
+		}
+	}
+
+	vib_window.samples++;
+
+	if(++vib_block_pos == VIB_BLOCK){
+		vibration_end_block();
+	}
+}
+
+static uint16_t clamp_u16(uint64_t value){
+	return (value > UINT16_MAX) ? UINT16_MAX : (uint16_t)value;
+}
+
+// Features of everything added since the last call, which starts the next window
+vibration_features vibration_take(){
+
+	vibration_features features = {0};
+	vibration_window window;
+
+	window = vib_window;
+	memset(&vib_window, 0, sizeof(vib_window));
+
+	if(window.samples == 0){
+		return features;
+	}
+
+	uint32_t n = window.samples;
+	features.samples = window.samples;
+
+	for(uint8_t axis = 0; axis < 3; axis++){
+		// n^2 variance = n * sum(x^2) - sum(x)^2, exact in 64 bits for a full window
+		int64_t sum = window.sum[axis];
+		uint64_t spread = n * window.sum_sq[axis] - (uint64_t)(sum * sum);
+		uint64_t variance = (spread * ACCEL_MG_PER_LSB * ACCEL_MG_PER_LSB + (uint64_t)n * n / 2) / ((uint64_t)n * n);
+		uint16_t rms = (uint16_t)isqrt_round(variance > UINT32_MAX ? UINT32_MAX : (uint32_t)variance);
+
+		int32_t mean = div_round(window.sum[axis], (int32_t)n);
+		int32_t above = window.max[axis] - mean;
+		int32_t below = mean - window.min[axis];
+		uint32_t peak = (uint32_t)((above > below) ? above : below) * ACCEL_MG_PER_LSB;
+
+		features.rms[axis] = rms;
+		features.peak_to_peak[axis] = clamp_u16((uint32_t)(window.max[axis] - window.min[axis]) * ACCEL_MG_PER_LSB);
+		features.crest[axis] = (rms == 0) ? 0 : clamp_u16((peak * 100UL + rms / 2) / rms);
+	}
+
+	// A tone of amplitude A on bin k gives |X|^2 = (A N / 2)^2 per block: mean square
+	// A^2 / 2 = 2 |X|^2 / N^2
+	if(window.blocks > 0){
+		uint64_t den = (uint64_t)VIB_BLOCK * VIB_BLOCK * window.blocks;
+
+		for(uint8_t b = 0; b < VIB_BANDS; b++){
+			uint64_t mean_square = (window.power[b] * 2 * ACCEL_MG_PER_LSB * ACCEL_MG_PER_LSB + den / 2) / den;
+
+			features.band[b] = (uint16_t)isqrt_round(mean_square > UINT32_MAX ? UINT32_MAX : (uint32_t)mean_square);
+		}
+	}
+
+	return features;
+}
+
+// Largest of a per-axis feature: vibration_max(features.rms) is what the alert compares
+uint16_t vibration_max(const uint16_t axis[3]){
+
+	uint16_t max = axis[0];
+
+	for(uint8_t i = 1; i < 3; i++){
+		if(axis[i] > max){
+			max = axis[i];
+		}
+	}
+
+	return max;
+}
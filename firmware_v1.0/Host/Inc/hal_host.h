@@ -0,0 +1,125 @@
+/*
+ * hal_host.h
+ *
+ *  Control side of the host HAL shim: virtual clock, event scheduling,
+ *  I2C device attachment, UART sinks and bus/time counters.
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: dst2001055
+ */
+
+#ifndef HOST_HAL_HOST_H_
+#define HOST_HAL_HOST_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "stm32l0xx_hal.h"
+
+//------------------------------- HOST DEFINE -------------------------------
+
+#define HOST_SYSCLK_HZ		1048576U	// MSI range 4 (SystemClock_Config)
+#define HOST_I2C_BIT_NS		10000U		// hi2c1 Timing 0x00000202 @ MSI range 4 -> ~100 kHz
+#define HOST_UART_FRAME_BITS 10U		// 8N1
+
+#define HOST_MAX_EVENTS		32
+#define HOST_NVIC_IRQS		32
+#define HOST_MAX_I2C_DEVS	4
+#define HOST_MAX_TIMERS		4
+#define HOST_MAX_UARTS		2
+
+#define HOST_REGFILE_SIZE	0x40
+#define HOST_I2C_MAX_BURST	32		// data bytes per HAL_I2C_Mem_Write
+#define HOST_RTC_WUT_HZ		2048U	// LSE / 16 (RTC_WAKEUPCLOCK_RTCCLK_DIV16)
+#define HOST_EEPROM_PROG_US	3200U	// data EEPROM word erase or program (tprog)
+#define HOST_EEPROM_WORDS	((DATA_EEPROM_END - DATA_EEPROM_BASE + 1) / 4)
+
+#define HOST_NO_EVENT		UINT64_MAX
+
+//---------------------------------------------------------
+
+// What the virtual clock was advanced for
+enum host_time_kind{
+	HOST_TIME_OTHER,
+	HOST_TIME_DELAY,
+	HOST_TIME_SLEEP,
+	HOST_TIME_STOP,
+	HOST_TIME_I2C,
+	HOST_TIME_UART
+};
+
+typedef void (*host_event_fn)(void *ctx);
+
+typedef void (*host_advance_hook)(uint64_t us, uint8_t kind);
+
+// An interrupt or DMA transfer put on the bus (kind HOST_TIME_I2C or
+// HOST_TIME_UART) for us, while the clock stays where it is
+typedef void (*host_bus_hook)(uint64_t us, uint8_t kind);
+
+typedef void (*host_uart_sink)(void *ctx, const uint8_t *pData, uint16_t size);
+
+typedef struct{
+	uint16_t addr;
+	HAL_StatusTypeDef (*write)(void *ctx, const uint8_t *pData, uint16_t size);
+	HAL_StatusTypeDef (*read)(void *ctx, uint8_t *pData, uint16_t size);
+	void *ctx;
+}host_i2c_device;
+
+// Plain register file with an auto-incrementing register pointer
+typedef struct{
+	uint8_t regs[HOST_REGFILE_SIZE];
+	uint8_t pointer;
+}host_regfile;
+
+typedef struct{
+	uint32_t i2c_transactions;
+	uint32_t i2c_bytes;
+	uint32_t i2c_nacks;
+	uint32_t i2c_repeated_starts;
+	uint64_t i2c_busy_us;
+
+	uint32_t uart_writes;
+	uint32_t uart_dma_transfers;
+	uint64_t uart_bytes;
+	uint64_t uart_busy_us;
+
+	uint32_t rtc_reads;
+	uint64_t delay_us;
+	uint64_t sleep_us;
+	uint64_t stop_us;
+	uint32_t stop_entries;
+	uint32_t rtc_wakeups;
+	uint32_t events_fired;
+
+	uint32_t eeprom_programs;
+	uint32_t eeprom_erases;
+}host_stats;
+
+extern host_stats host_counters;
+
+//---------------------- CLOCK -------------------------------
+void host_reset(void);
+uint64_t host_now_us(void);
+void host_advance_us(uint64_t us);
+void host_set_advance_hook(host_advance_hook hook);
+void host_set_bus_hook(host_bus_hook hook);
+bool host_run_until(int (*entry)(void), uint64_t until_us);
+
+//---------------------- EVENTS ------------------------------
+uint8_t host_schedule(uint64_t at_us, host_event_fn fn, void *ctx);
+void host_cancel(host_event_fn fn, void *ctx);
+uint64_t host_next_event_us(void);
+
+//---------------------- PERIPHERALS -------------------------
+uint8_t host_i2c_attach(const host_i2c_device *dev);
+void host_uart_set_sink(UART_HandleTypeDef *huart, host_uart_sink sink, void *ctx);
+void host_gpio_exti(uint16_t pin);
+int16_t host_nvic_priority(IRQn_Type IRQn);
+uint32_t host_eeprom_cycles(uint16_t word);
+
+HAL_StatusTypeDef host_regfile_write(void *ctx, const uint8_t *pData, uint16_t size);
+HAL_StatusTypeDef host_regfile_read(void *ctx, uint8_t *pData, uint16_t size);
+
+//---------------------- STATS -------------------------------
+void host_clear_stats(void);
+
+#endif /* HOST_HAL_HOST_H_ */
@@ -0,0 +1,155 @@
+/*
+ * sensor_models.h
+ *
+ *  Behavioural I2C models of the HDC2080 (T/H) and ADXL343 (accel) for the
+ *  host HAL shim, driven by scriptable waveforms of the physical quantities.
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: dst2001055
+ */
+
+#ifndef HOST_SENSOR_MODELS_H_
+#define HOST_SENSOR_MODELS_H_
+
+#include "hal_host.h"
+
+//------------------------------- HDC2080 DEFINE ----------------------------
+
+#define HDC2080_REG_TEMP_L		0x00
+#define HDC2080_REG_HUM_L		0x02
+#define HDC2080_REG_STATUS		0x04
+#define HDC2080_REG_INT_EN		0x07
+#define HDC2080_REG_TEMP_THR_L	0x0A
+#define HDC2080_REG_TEMP_THR_H	0x0B
+#define HDC2080_REG_RH_THR_L	0x0C
+#define HDC2080_REG_RH_THR_H	0x0D
+#define HDC2080_REG_CONFIG		0x0E
+#define HDC2080_REG_MEAS_CONFIG	0x0F
+#define HDC2080_REG_MANUF_ID	0xFC
+#define HDC2080_REG_DEVICE_ID	0xFE
+
+#define HDC2080_DRDY_BIT		7
+#define HDC2080_TH_BIT			6
+#define HDC2080_TL_BIT			5
+#define HDC2080_HH_BIT			4
+#define HDC2080_HL_BIT			3
+
+//------------------------------- ADXL343 DEFINE ----------------------------
+
+#define ADXL343_MODEL_REGS		0x40
+#define ADXL343_FIFO_DEPTH		32
+
+#define ADXL343_REG_THRESH_TAP	0x1D
+#define ADXL343_REG_DUR			0x21
+#define ADXL343_REG_THRESH_ACT	0x24
+#define ADXL343_REG_THRESH_INACT 0x25
+#define ADXL343_REG_TIME_INACT	0x26
+#define ADXL343_REG_ACT_INACT_CTL 0x27
+#define ADXL343_REG_THRESH_FF	0x28
+#define ADXL343_REG_TIME_FF		0x29
+#define ADXL343_REG_TAP_AXES	0x2A
+#define ADXL343_REG_ACT_TAP_STATUS 0x2B
+#define ADXL343_REG_BW_RATE		0x2C
+#define ADXL343_REG_PWR_CTL		0x2D
+#define ADXL343_REG_INT_ENABLE	0x2E
+#define ADXL343_REG_INT_MAP		0x2F
+#define ADXL343_REG_INT_SOURCE	0x30
+#define ADXL343_REG_DATA_FMT	0x31
+#define ADXL343_REG_DATA_X0		0x32
+#define ADXL343_REG_DATA_Z1		0x37
+#define ADXL343_REG_FIFO_CTL	0x38
+#define ADXL343_REG_FIFO_STATUS	0x39
+
+#define ADXL343_INT_DATA_READY	0x80
+#define ADXL343_INT_SINGLE_TAP	0x40
+#define ADXL343_INT_ACTIVITY	0x10
+#define ADXL343_INT_INACTIVITY	0x08
+#define ADXL343_INT_FREE_FALL	0x04
+#define ADXL343_INT_WATERMARK	0x02
+#define ADXL343_INT_OVERRUN		0x01
+
+//---------------------------------------------------------
+
+// value(t) = offset + ramp + sine + noise + pulses, t in seconds
+typedef struct{
+	double offset;
+
+	double ramp_start_s;
+	double ramp_per_s;
+	double ramp_per_s2;			// accelerating runaway
+
+	double sine_amp;
+	double sine_hz;
+
+	double noise_amp;			// deterministic, uniform +-noise_amp
+
+	double pulse_at_s;			// half-sine shocks
+	double pulse_every_s;		// 0 -> single pulse
+	double pulse_ms;
+	double pulse_amp;
+}host_waveform;
+
+typedef struct{
+	uint8_t  regs[0x100];
+	uint8_t  pointer;
+	uint16_t int_pin;
+	bool     int_level;
+	bool     converting;
+	bool     amm_running;	// MEAS_TRIG written with AMM set
+
+	host_waveform temperature;	// C
+	host_waveform humidity;		// %RH
+
+	uint32_t conversions;
+	uint32_t interrupts;
+}hdc2080_model;
+
+typedef struct{
+	uint8_t  regs[ADXL343_MODEL_REGS];
+	uint8_t  pointer;
+	uint16_t int1_pin;
+	uint16_t int2_pin;
+	bool     int1_level;
+	bool     int2_level;
+
+	int16_t  fifo[ADXL343_FIFO_DEPTH][3];
+	uint8_t  fifo_head;
+	uint8_t  fifo_count;
+
+	uint64_t next_sample_us;
+	uint64_t quiet_until_us;		// samples before it cannot trip a detector
+	uint64_t quiet_retry_us;		// no new proof before this sample after a failed one
+	int16_t  last_mg[3];
+	int16_t  ac_reference[3];		// activity, ac coupled
+	int16_t  inact_reference[3];	// inactivity, ac coupled
+	bool     link_active;			// LINK: looking for inactivity (power-up, after activity)
+	uint32_t inactive_samples;
+	uint32_t free_fall_samples;
+	uint32_t tap_samples;
+
+	host_waveform axis[3];		// mg
+
+	uint32_t samples;
+	uint32_t overruns;
+	uint32_t discarded;			// stream FIFO full with the watermark masked
+	uint32_t interrupts;
+}adxl343_model;
+
+//---------------------- WAVEFORMS ---------------------------
+double host_waveform_eval(const host_waveform *wf, uint64_t t_us);
+void host_waveform_bounds(const host_waveform *wf, uint64_t from_us, uint64_t to_us, double *lo, double *hi);
+
+void host_profile_storage_room(hdc2080_model *hdc, adxl343_model *adxl);
+void host_profile_thermal_runaway(hdc2080_model *hdc, adxl343_model *adxl, double start_s);
+void host_profile_truck(hdc2080_model *hdc, adxl343_model *adxl);
+
+//---------------------- HDC2080 -----------------------------
+void hdc2080_model_init(hdc2080_model *m, uint16_t int_pin);
+uint8_t hdc2080_model_attach(hdc2080_model *m, uint16_t addr);
+
+//---------------------- ADXL343 -----------------------------
+void adxl343_model_init(adxl343_model *m, uint16_t int1_pin, uint16_t int2_pin);
+uint8_t adxl343_model_attach(adxl343_model *m, uint16_t addr);
+void adxl343_model_sync(adxl343_model *m);
+
+#endif /* HOST_SENSOR_MODELS_H_ */
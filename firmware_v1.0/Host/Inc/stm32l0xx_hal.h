@@ -0,0 +1,562 @@
+/*
+ * stm32l0xx_hal.h
+ *
+ *  Host build stand-in for the STM32L0 HAL. Only the types, constants and
+ *  calls used by Core/Src are declared here; the behaviour lives in
+ *  hal_host.c and runs on a virtual clock.
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: dst2001055
+ */
+
+#ifndef HOST_STM32L0XX_HAL_H_
+#define HOST_STM32L0XX_HAL_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//------------------------------- COMMON -----------------------------------
+
+#define __IO volatile
+
+typedef enum{
+	HAL_OK       = 0x00U,
+	HAL_ERROR    = 0x01U,
+	HAL_BUSY     = 0x02U,
+	HAL_TIMEOUT  = 0x03U
+}HAL_StatusTypeDef;
+
+typedef enum{
+	RESET = 0U,
+	SET = !RESET
+}FlagStatus, ITStatus;
+
+#define HAL_MAX_DELAY 0xFFFFFFFFU
+
+#define UNUSED(X) (void)X
+
+// Peripheral instances only need an identity on the host
+typedef struct{
+	const char *name;
+}HOST_Periph_TypeDef;
+
+typedef HOST_Periph_TypeDef I2C_TypeDef;
+typedef HOST_Periph_TypeDef USART_TypeDef;
+typedef HOST_Periph_TypeDef RTC_TypeDef;
+typedef HOST_Periph_TypeDef TIM_TypeDef;
+
+extern I2C_TypeDef   host_I2C1;
+extern USART_TypeDef host_LPUART1;
+extern USART_TypeDef host_USART2;
+extern RTC_TypeDef   host_RTC;
+extern TIM_TypeDef   host_TIM21;
+
+#define I2C1    (&host_I2C1)
+#define LPUART1 (&host_LPUART1)
+#define USART2  (&host_USART2)
+#define RTC     (&host_RTC)
+#define TIM21   (&host_TIM21)
+
+//------------------------------- CORTEX -----------------------------------
+
+typedef enum{
+	RTC_IRQn            = 2,
+	EXTI0_1_IRQn        = 5,
+	EXTI2_3_IRQn        = 6,
+	EXTI4_15_IRQn       = 7,
+	DMA1_Channel1_IRQn  = 9,
+	DMA1_Channel2_3_IRQn = 10,
+	DMA1_Channel4_5_6_7_IRQn = 11,
+	TIM21_IRQn          = 20,
+	I2C1_IRQn           = 23,
+	USART2_IRQn         = 28,
+	LPUART1_IRQn        = 29
+}IRQn_Type;
+
+void HAL_NVIC_SetPriority(IRQn_Type IRQn, uint32_t PreemptPriority, uint32_t SubPriority);
+void HAL_NVIC_EnableIRQ(IRQn_Type IRQn);
+void HAL_NVIC_DisableIRQ(IRQn_Type IRQn);
+
+void __disable_irq(void);
+void __enable_irq(void);
+uint32_t __get_PRIMASK(void);
+void __set_PRIMASK(uint32_t priMask);
+void __WFI(void);
+uint32_t __get_IPSR(void);
+
+// Single core, in order: a compiler barrier is all DMB has to be here
+#define __DMB() __asm__ volatile ("" ::: "memory")
+
+// SysTick down-counter, derived from the virtual clock on every access
+typedef struct{
+	uint32_t CTRL;
+	uint32_t LOAD;
+	uint32_t VAL;
+	uint32_t CALIB;
+}SysTick_Type;
+
+SysTick_Type *host_systick(void);
+#define SysTick (host_systick())
+
+// HAL_GetTick() follows the virtual clock, so a SysTick is never left pending
+typedef struct{
+	uint32_t CPUID;
+	uint32_t ICSR;
+}SCB_Type;
+
+#define SCB_ICSR_PENDSTSET_Msk (1UL << 26)
+
+SCB_Type *host_scb(void);
+#define SCB (host_scb())
+
+//------------------------------- SYSTEM -----------------------------------
+
+// HAL tick counter. Firmware adds the time spent in STOP after SysTick resumes
+extern __IO uint32_t uwTick;
+
+HAL_StatusTypeDef HAL_Init(void);
+void HAL_IncTick(void);
+void HAL_Delay(uint32_t Delay);
+uint32_t HAL_GetTick(void);
+void HAL_SuspendTick(void);
+void HAL_ResumeTick(void);
+
+//------------------------------- RCC / PWR --------------------------------
+
+typedef struct{
+	uint32_t PLLState;
+	uint32_t PLLSource;
+	uint32_t PLLMUL;
+	uint32_t PLLDIV;
+}RCC_PLLInitTypeDef;
+
+typedef struct{
+	uint32_t OscillatorType;
+	uint32_t HSEState;
+	uint32_t LSEState;
+	uint32_t HSIState;
+	uint32_t HSICalibrationValue;
+	uint32_t LSIState;
+	uint32_t MSIState;
+	uint32_t MSICalibrationValue;
+	uint32_t MSIClockRange;
+	RCC_PLLInitTypeDef PLL;
+}RCC_OscInitTypeDef;
+
+typedef struct{
+	uint32_t ClockType;
+	uint32_t SYSCLKSource;
+	uint32_t AHBCLKDivider;
+	uint32_t APB1CLKDivider;
+	uint32_t APB2CLKDivider;
+}RCC_ClkInitTypeDef;
+
+typedef struct{
+	uint32_t PeriphClockSelection;
+	uint32_t Usart2ClockSelection;
+	uint32_t Lpuart1ClockSelection;
+	uint32_t I2c1ClockSelection;
+	uint32_t RTCClockSelection;
+	uint32_t LptimClockSelection;
+}RCC_PeriphCLKInitTypeDef;
+
+#define RCC_OSCILLATORTYPE_LSE     0x00000004U
+#define RCC_OSCILLATORTYPE_MSI     0x00000010U
+#define RCC_LSE_ON                 0x00000001U
+#define RCC_MSI_ON                 0x00000001U
+#define RCC_MSIRANGE_4             0x00008000U
+#define RCC_PLL_NONE               0x00000000U
+#define RCC_CLOCKTYPE_SYSCLK       0x00000001U
+#define RCC_CLOCKTYPE_HCLK         0x00000002U
+#define RCC_CLOCKTYPE_PCLK1        0x00000004U
+#define RCC_CLOCKTYPE_PCLK2        0x00000008U
+#define RCC_SYSCLKSOURCE_MSI       0x00000000U
+#define RCC_SYSCLK_DIV1            0x00000000U
+#define RCC_HCLK_DIV1              0x00000000U
+#define RCC_PERIPHCLK_LPUART1      0x00000004U
+#define RCC_PERIPHCLK_I2C1         0x00000008U
+#define RCC_PERIPHCLK_RTC          0x00000020U
+#define RCC_LPUART1CLKSOURCE_PCLK1 0x00000000U
+#define RCC_I2C1CLKSOURCE_PCLK1    0x00000000U
+#define RCC_RTCCLKSOURCE_LSE       0x00010000U
+#define RCC_LSEDRIVE_LOW           0x00000000U
+#define FLASH_LATENCY_0            0x00000000U
+#define PWR_REGULATOR_VOLTAGE_SCALE1 0x00000800U
+#define PWR_LOWPOWERREGULATOR_ON   0x00000001U
+#define PWR_STOPENTRY_WFI          ((uint8_t)0x01)
+
+HAL_StatusTypeDef HAL_RCC_OscConfig(RCC_OscInitTypeDef *RCC_OscInitStruct);
+HAL_StatusTypeDef HAL_RCC_ClockConfig(RCC_ClkInitTypeDef *RCC_ClkInitStruct, uint32_t FLatency);
+HAL_StatusTypeDef HAL_RCCEx_PeriphCLKConfig(RCC_PeriphCLKInitTypeDef *PeriphClkInit);
+void HAL_PWR_EnableBkUpAccess(void);
+void HAL_PWR_EnterSTOPMode(uint32_t Regulator, uint8_t STOPEntry);
+
+#define __HAL_PWR_VOLTAGESCALING_CONFIG(__REGULATOR__) ((void)(__REGULATOR__))
+#define __HAL_RCC_LSEDRIVE_CONFIG(__DRIVE__)           ((void)(__DRIVE__))
+
+#define __HAL_RCC_GPIOA_CLK_ENABLE()    ((void)0)
+#define __HAL_RCC_GPIOB_CLK_ENABLE()    ((void)0)
+#define __HAL_RCC_GPIOC_CLK_ENABLE()    ((void)0)
+#define __HAL_RCC_I2C1_CLK_ENABLE()     ((void)0)
+#define __HAL_RCC_I2C1_CLK_DISABLE()    ((void)0)
+#define __HAL_RCC_LPUART1_CLK_ENABLE()  ((void)0)
+#define __HAL_RCC_LPUART1_CLK_DISABLE() ((void)0)
+#define __HAL_RCC_USART2_CLK_ENABLE()   ((void)0)
+#define __HAL_RCC_USART2_CLK_DISABLE()  ((void)0)
+#define __HAL_RCC_TIM21_CLK_ENABLE()    ((void)0)
+#define __HAL_RCC_TIM21_CLK_DISABLE()   ((void)0)
+#define __HAL_RCC_RTC_ENABLE()          ((void)0)
+#define __HAL_RCC_RTC_DISABLE()         ((void)0)
+#define __HAL_RCC_DMA1_CLK_ENABLE()     ((void)0)
+
+//------------------------------- FLASH / DATA EEPROM ----------------------
+
+// STM32L010C6: 128 bytes of data EEPROM. The host maps memory at the same
+// address so the firmware reads it directly, as on the target
+#define DATA_EEPROM_BASE           0x08080000UL
+#define DATA_EEPROM_END            0x0808007FUL
+
+#define FLASH_TYPEPROGRAMDATA_BYTE     0x00U
+#define FLASH_TYPEPROGRAMDATA_HALFWORD 0x01U
+#define FLASH_TYPEPROGRAMDATA_WORD     0x02U
+
+HAL_StatusTypeDef HAL_FLASHEx_DATAEEPROM_Unlock(void);
+HAL_StatusTypeDef HAL_FLASHEx_DATAEEPROM_Lock(void);
+HAL_StatusTypeDef HAL_FLASHEx_DATAEEPROM_Erase(uint32_t Address);
+HAL_StatusTypeDef HAL_FLASHEx_DATAEEPROM_Program(uint32_t TypeProgram, uint32_t Address, uint32_t Data);
+
+//------------------------------- GPIO -------------------------------------
+
+typedef struct{
+	uint32_t ODR;
+	uint32_t IDR;
+}GPIO_TypeDef;
+
+extern GPIO_TypeDef host_GPIO[3];
+
+#define GPIOA (&host_GPIO[0])
+#define GPIOB (&host_GPIO[1])
+#define GPIOC (&host_GPIO[2])
+
+typedef enum{
+	GPIO_PIN_RESET = 0U,
+	GPIO_PIN_SET
+}GPIO_PinState;
+
+typedef struct{
+	uint32_t Pin;
+	uint32_t Mode;
+	uint32_t Pull;
+	uint32_t Speed;
+	uint32_t Alternate;
+}GPIO_InitTypeDef;
+
+#define GPIO_PIN_0  ((uint16_t)0x0001U)
+#define GPIO_PIN_1  ((uint16_t)0x0002U)
+#define GPIO_PIN_2  ((uint16_t)0x0004U)
+#define GPIO_PIN_3  ((uint16_t)0x0008U)
+#define GPIO_PIN_4  ((uint16_t)0x0010U)
+#define GPIO_PIN_5  ((uint16_t)0x0020U)
+#define GPIO_PIN_6  ((uint16_t)0x0040U)
+#define GPIO_PIN_7  ((uint16_t)0x0080U)
+#define GPIO_PIN_8  ((uint16_t)0x0100U)
+#define GPIO_PIN_9  ((uint16_t)0x0200U)
+#define GPIO_PIN_10 ((uint16_t)0x0400U)
+#define GPIO_PIN_11 ((uint16_t)0x0800U)
+#define GPIO_PIN_12 ((uint16_t)0x1000U)
+#define GPIO_PIN_13 ((uint16_t)0x2000U)
+#define GPIO_PIN_14 ((uint16_t)0x4000U)
+#define GPIO_PIN_15 ((uint16_t)0x8000U)
+
+#define GPIO_MODE_INPUT           0x00000000U
+#define GPIO_MODE_OUTPUT_PP       0x00000001U
+#define GPIO_MODE_AF_PP           0x00000002U
+#define GPIO_MODE_AF_OD           0x00000012U
+#define GPIO_MODE_IT_RISING       0x10110000U
+#define GPIO_NOPULL               0x00000000U
+#define GPIO_SPEED_FREQ_LOW       0x00000000U
+#define GPIO_SPEED_FREQ_VERY_HIGH 0x00000003U
+#define GPIO_AF4_I2C1             0x04U
+#define GPIO_AF4_USART2           0x04U
+#define GPIO_AF6_LPUART1          0x06U
+
+void HAL_GPIO_Init(GPIO_TypeDef *GPIOx, GPIO_InitTypeDef *GPIO_Init);
+void HAL_GPIO_DeInit(GPIO_TypeDef *GPIOx, uint32_t GPIO_Pin);
+GPIO_PinState HAL_GPIO_ReadPin(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin);
+void HAL_GPIO_WritePin(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin, GPIO_PinState PinState);
+void HAL_GPIO_TogglePin(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin);
+void HAL_GPIO_EXTI_IRQHandler(uint16_t GPIO_Pin);
+void HAL_GPIO_EXTI_Callback(uint16_t GPIO_Pin);
+
+//------------------------------- I2C --------------------------------------
+
+typedef struct{
+	uint32_t Timing;
+	uint32_t OwnAddress1;
+	uint32_t AddressingMode;
+	uint32_t DualAddressMode;
+	uint32_t OwnAddress2;
+	uint32_t OwnAddress2Masks;
+	uint32_t GeneralCallMode;
+	uint32_t NoStretchMode;
+}I2C_InitTypeDef;
+
+typedef enum{
+	HAL_I2C_STATE_RESET   = 0x00U,
+	HAL_I2C_STATE_READY   = 0x20U,
+	HAL_I2C_STATE_BUSY_TX = 0x21U,
+	HAL_I2C_STATE_BUSY_RX = 0x22U
+}HAL_I2C_StateTypeDef;
+
+typedef struct{
+	I2C_TypeDef *Instance;
+	I2C_InitTypeDef Init;
+	__IO HAL_I2C_StateTypeDef State;
+}I2C_HandleTypeDef;
+
+#define I2C_ADDRESSINGMODE_7BIT  0x00000001U
+#define I2C_DUALADDRESS_DISABLE  0x00000000U
+#define I2C_OA2_NOMASK           0x00U
+#define I2C_GENERALCALL_DISABLE  0x00000000U
+#define I2C_NOSTRETCH_DISABLE    0x00000000U
+#define I2C_ANALOGFILTER_ENABLE  0x00000000U
+#define I2C_MEMADD_SIZE_8BIT     0x00000001U
+
+HAL_StatusTypeDef HAL_I2C_Init(I2C_HandleTypeDef *hi2c);
+HAL_StatusTypeDef HAL_I2C_DeInit(I2C_HandleTypeDef *hi2c);
+HAL_StatusTypeDef HAL_I2CEx_ConfigAnalogFilter(I2C_HandleTypeDef *hi2c, uint32_t AnalogFilter);
+HAL_StatusTypeDef HAL_I2CEx_ConfigDigitalFilter(I2C_HandleTypeDef *hi2c, uint32_t DigitalFilter);
+HAL_StatusTypeDef HAL_I2C_Master_Transmit(I2C_HandleTypeDef *hi2c, uint16_t DevAddress, uint8_t *pData, uint16_t Size, uint32_t Timeout);
+HAL_StatusTypeDef HAL_I2C_Master_Receive(I2C_HandleTypeDef *hi2c, uint16_t DevAddress, uint8_t *pData, uint16_t Size, uint32_t Timeout);
+HAL_StatusTypeDef HAL_I2C_Master_Transmit_IT(I2C_HandleTypeDef *hi2c, uint16_t DevAddress, uint8_t *pData, uint16_t Size);
+HAL_StatusTypeDef HAL_I2C_Master_Receive_IT(I2C_HandleTypeDef *hi2c, uint16_t DevAddress, uint8_t *pData, uint16_t Size);
+HAL_StatusTypeDef HAL_I2C_Mem_Write(I2C_HandleTypeDef *hi2c, uint16_t DevAddress, uint16_t MemAddress, uint16_t MemAddSize, uint8_t *pData, uint16_t Size, uint32_t Timeout);
+HAL_StatusTypeDef HAL_I2C_Mem_Read(I2C_HandleTypeDef *hi2c, uint16_t DevAddress, uint16_t MemAddress, uint16_t MemAddSize, uint8_t *pData, uint16_t Size, uint32_t Timeout);
+HAL_StatusTypeDef HAL_I2C_Mem_Write_IT(I2C_HandleTypeDef *hi2c, uint16_t DevAddress, uint16_t MemAddress, uint16_t MemAddSize, uint8_t *pData, uint16_t Size);
+HAL_StatusTypeDef HAL_I2C_Mem_Read_IT(I2C_HandleTypeDef *hi2c, uint16_t DevAddress, uint16_t MemAddress, uint16_t MemAddSize, uint8_t *pData, uint16_t Size);
+void HAL_I2C_EV_IRQHandler(I2C_HandleTypeDef *hi2c);
+void HAL_I2C_ER_IRQHandler(I2C_HandleTypeDef *hi2c);
+void HAL_I2C_MasterTxCpltCallback(I2C_HandleTypeDef *hi2c);
+void HAL_I2C_MasterRxCpltCallback(I2C_HandleTypeDef *hi2c);
+void HAL_I2C_MemTxCpltCallback(I2C_HandleTypeDef *hi2c);
+void HAL_I2C_MemRxCpltCallback(I2C_HandleTypeDef *hi2c);
+void HAL_I2C_ErrorCallback(I2C_HandleTypeDef *hi2c);
+void HAL_I2C_MspInit(I2C_HandleTypeDef *hi2c);
+void HAL_I2C_MspDeInit(I2C_HandleTypeDef *hi2c);
+
+//------------------------------- DMA --------------------------------------
+
+typedef HOST_Periph_TypeDef DMA_Channel_TypeDef;
+
+extern DMA_Channel_TypeDef host_DMA1_Channel2;
+extern DMA_Channel_TypeDef host_DMA1_Channel4;
+
+#define DMA1_Channel2 (&host_DMA1_Channel2)
+#define DMA1_Channel4 (&host_DMA1_Channel4)
+
+typedef struct{
+	uint32_t Request;
+	uint32_t Direction;
+	uint32_t PeriphInc;
+	uint32_t MemInc;
+	uint32_t PeriphDataAlignment;
+	uint32_t MemDataAlignment;
+	uint32_t Mode;
+	uint32_t Priority;
+}DMA_InitTypeDef;
+
+typedef struct{
+	DMA_Channel_TypeDef *Instance;
+	DMA_InitTypeDef Init;
+	void *Parent;
+}DMA_HandleTypeDef;
+
+#define DMA_REQUEST_4         0x00000004U
+#define DMA_REQUEST_5         0x00000005U
+#define DMA_MEMORY_TO_PERIPH  0x00000010U
+#define DMA_PINC_DISABLE      0x00000000U
+#define DMA_MINC_ENABLE       0x00000080U
+#define DMA_PDATAALIGN_BYTE   0x00000000U
+#define DMA_MDATAALIGN_BYTE   0x00000000U
+#define DMA_NORMAL            0x00000000U
+#define DMA_PRIORITY_LOW      0x00000000U
+
+#define __HAL_LINKDMA(__HANDLE__, __PPP_DMA_FIELD__, __DMA_HANDLE__) \
+	do{ \
+		(__HANDLE__)->__PPP_DMA_FIELD__ = &(__DMA_HANDLE__); \
+		(__DMA_HANDLE__).Parent = (__HANDLE__); \
+	}while(0)
+
+HAL_StatusTypeDef HAL_DMA_Init(DMA_HandleTypeDef *hdma);
+HAL_StatusTypeDef HAL_DMA_DeInit(DMA_HandleTypeDef *hdma);
+void HAL_DMA_IRQHandler(DMA_HandleTypeDef *hdma);
+
+//------------------------------- UART -------------------------------------
+
+typedef struct{
+	uint32_t BaudRate;
+	uint32_t WordLength;
+	uint32_t StopBits;
+	uint32_t Parity;
+	uint32_t Mode;
+	uint32_t HwFlowCtl;
+	uint32_t OverSampling;
+	uint32_t OneBitSampling;
+}UART_InitTypeDef;
+
+typedef struct{
+	uint32_t AdvFeatureInit;
+}UART_AdvFeatureInitTypeDef;
+
+typedef enum{
+	HAL_UART_STATE_RESET   = 0x00U,
+	HAL_UART_STATE_READY   = 0x20U,
+	HAL_UART_STATE_BUSY_TX = 0x21U
+}HAL_UART_StateTypeDef;
+
+typedef struct{
+	USART_TypeDef *Instance;
+	UART_InitTypeDef Init;
+	UART_AdvFeatureInitTypeDef AdvancedInit;
+	DMA_HandleTypeDef *hdmatx;
+	DMA_HandleTypeDef *hdmarx;
+	__IO HAL_UART_StateTypeDef gState;
+}UART_HandleTypeDef;
+
+#define UART_WORDLENGTH_8B          0x00000000U
+#define UART_STOPBITS_1             0x00000000U
+#define UART_PARITY_NONE            0x00000000U
+#define UART_MODE_TX_RX             0x0000000CU
+#define UART_HWCONTROL_NONE         0x00000000U
+#define UART_OVERSAMPLING_16        0x00000000U
+#define UART_ONE_BIT_SAMPLE_DISABLE 0x00000000U
+#define UART_ADVFEATURE_NO_INIT     0x00000000U
+
+HAL_StatusTypeDef HAL_UART_Init(UART_HandleTypeDef *huart);
+HAL_StatusTypeDef HAL_UART_Transmit(UART_HandleTypeDef *huart, uint8_t *pData, uint16_t Size, uint32_t Timeout);
+HAL_StatusTypeDef HAL_UART_Transmit_DMA(UART_HandleTypeDef *huart, uint8_t *pData, uint16_t Size);
+void HAL_UART_IRQHandler(UART_HandleTypeDef *huart);
+void HAL_UART_TxCpltCallback(UART_HandleTypeDef *huart);
+void HAL_UART_MspInit(UART_HandleTypeDef *huart);
+void HAL_UART_MspDeInit(UART_HandleTypeDef *huart);
+
+//------------------------------- RTC --------------------------------------
+
+typedef struct{
+	uint32_t HourFormat;
+	uint32_t AsynchPrediv;
+	uint32_t SynchPrediv;
+	uint32_t OutPut;
+	uint32_t OutPutRemap;
+	uint32_t OutPutPolarity;
+	uint32_t OutPutType;
+}RTC_InitTypeDef;
+
+typedef struct{
+	RTC_TypeDef *Instance;
+	RTC_InitTypeDef Init;
+}RTC_HandleTypeDef;
+
+typedef struct{
+	uint8_t  Hours;
+	uint8_t  Minutes;
+	uint8_t  Seconds;
+	uint8_t  TimeFormat;
+	uint32_t SubSeconds;
+	uint32_t SecondFraction;
+	uint32_t DayLightSaving;
+	uint32_t StoreOperation;
+}RTC_TimeTypeDef;
+
+typedef struct{
+	uint8_t WeekDay;
+	uint8_t Month;
+	uint8_t Date;
+	uint8_t Year;
+}RTC_DateTypeDef;
+
+#define RTC_FORMAT_BIN              0x00000000U
+#define RTC_FORMAT_BCD              0x00000001U
+#define RTC_HOURFORMAT_24           0x00000000U
+#define RTC_OUTPUT_DISABLE          0x00000000U
+#define RTC_OUTPUT_REMAP_NONE       0x00000000U
+#define RTC_OUTPUT_POLARITY_HIGH    0x00000000U
+#define RTC_OUTPUT_TYPE_OPENDRAIN   0x00000000U
+#define RTC_DAYLIGHTSAVING_NONE     0x00000000U
+#define RTC_STOREOPERATION_RESET    0x00000000U
+#define RTC_WEEKDAY_MONDAY          ((uint8_t)0x01)
+#define RTC_MONTH_JANUARY           ((uint8_t)0x01)
+#define RTC_WAKEUPCLOCK_RTCCLK_DIV16 0x00000000U
+
+#define __HAL_RTC_WRITEPROTECTION_DISABLE(__HANDLE__) ((void)(__HANDLE__))
+#define __HAL_RTC_WRITEPROTECTION_ENABLE(__HANDLE__)  ((void)(__HANDLE__))
+
+HAL_StatusTypeDef HAL_RTC_Init(RTC_HandleTypeDef *hrtc);
+HAL_StatusTypeDef HAL_RTC_SetTime(RTC_HandleTypeDef *hrtc, RTC_TimeTypeDef *sTime, uint32_t Format);
+HAL_StatusTypeDef HAL_RTC_GetTime(RTC_HandleTypeDef *hrtc, RTC_TimeTypeDef *sTime, uint32_t Format);
+HAL_StatusTypeDef HAL_RTC_SetDate(RTC_HandleTypeDef *hrtc, RTC_DateTypeDef *sDate, uint32_t Format);
+HAL_StatusTypeDef HAL_RTC_GetDate(RTC_HandleTypeDef *hrtc, RTC_DateTypeDef *sDate, uint32_t Format);
+HAL_StatusTypeDef HAL_RTC_WaitForSynchro(RTC_HandleTypeDef *hrtc);
+HAL_StatusTypeDef HAL_RTCEx_SetWakeUpTimer_IT(RTC_HandleTypeDef *hrtc, uint32_t WakeUpCounter, uint32_t WakeUpClock);
+HAL_StatusTypeDef HAL_RTCEx_DeactivateWakeUpTimer(RTC_HandleTypeDef *hrtc);
+void HAL_RTCEx_WakeUpTimerIRQHandler(RTC_HandleTypeDef *hrtc);
+void HAL_RTC_MspInit(RTC_HandleTypeDef *hrtc);
+void HAL_RTC_MspDeInit(RTC_HandleTypeDef *hrtc);
+
+//------------------------------- TIM --------------------------------------
+
+typedef struct{
+	uint32_t Prescaler;
+	uint32_t CounterMode;
+	uint32_t Period;
+	uint32_t ClockDivision;
+	uint32_t AutoReloadPreload;
+}TIM_Base_InitTypeDef;
+
+typedef struct{
+	TIM_TypeDef *Instance;
+	TIM_Base_InitTypeDef Init;
+}TIM_HandleTypeDef;
+
+typedef struct{
+	uint32_t ClockSource;
+	uint32_t ClockPolarity;
+	uint32_t ClockPrescaler;
+	uint32_t ClockFilter;
+}TIM_ClockConfigTypeDef;
+
+typedef struct{
+	uint32_t MasterOutputTrigger;
+	uint32_t MasterSlaveMode;
+}TIM_MasterConfigTypeDef;
+
+#define TIM_COUNTERMODE_UP             0x00000000U
+#define TIM_CLOCKDIVISION_DIV1         0x00000000U
+#define TIM_AUTORELOAD_PRELOAD_DISABLE 0x00000000U
+#define TIM_CLOCKSOURCE_INTERNAL       0x00001000U
+#define TIM_TRGO_RESET                 0x00000000U
+#define TIM_MASTERSLAVEMODE_DISABLE    0x00000000U
+#define TIM_SR_UIF                     0x00000001U
+
+#define __HAL_TIM_SET_AUTORELOAD(__HANDLE__, __AUTORELOAD__) ((__HANDLE__)->Init.Period = (__AUTORELOAD__))
+#define __HAL_TIM_SET_PRESCALER(__HANDLE__, __PRESC__)       ((__HANDLE__)->Init.Prescaler = (__PRESC__))
+#define __HAL_TIM_CLEAR_FLAG(__HANDLE__, __FLAG__)           ((void)(__HANDLE__), (void)(__FLAG__))
+
+HAL_StatusTypeDef HAL_TIM_Base_Init(TIM_HandleTypeDef *htim);
+HAL_StatusTypeDef HAL_TIM_ConfigClockSource(TIM_HandleTypeDef *htim, TIM_ClockConfigTypeDef *sClockSourceConfig);
+HAL_StatusTypeDef HAL_TIMEx_MasterConfigSynchronization(TIM_HandleTypeDef *htim, TIM_MasterConfigTypeDef *sMasterConfig);
+HAL_StatusTypeDef HAL_TIM_Base_Start_IT(TIM_HandleTypeDef *htim);
+HAL_StatusTypeDef HAL_TIM_Base_Stop(TIM_HandleTypeDef *htim);
+void HAL_TIM_Base_MspInit(TIM_HandleTypeDef *htim);
+void HAL_TIM_Base_MspDeInit(TIM_HandleTypeDef *htim);
+void HAL_TIM_PeriodElapsedCallback(TIM_HandleTypeDef *htim);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* HOST_STM32L0XX_HAL_H_ */
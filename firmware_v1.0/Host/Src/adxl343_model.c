@@ -0,0 +1,688 @@
+/*
+ * adxl343_model.c
+ *
+ *  ADXL343 register model: output data rate from BW_RATE, data format and
+ *  range, bypass/FIFO/stream FIFO modes with watermark and overrun,
+ *  activity/inactivity (dc/ac coupled, optionally linked), single-tap and
+ *  free-fall detection, and INT1/INT2 mapped onto EXTI lines.
+ *
+ *  Samples are produced lazily: the model only schedules a clock event when
+ *  an enabled interrupt needs one, otherwise it catches up on the next bus
+ *  access. This keeps long simulations cheap while the part is polled.
+ *  With the detectors on, the waveform bounds tell how far ahead no sample
+ *  can trip one; that run is skipped in one step and only its last
+ *  FIFO-depth samples, the ones still readable, are computed.
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: dst2001055
+ */
+
+#include <math.h>
+#include <string.h>
+#include "sensor_models.h"
+
+#define ADXL343_DEVID		0xE5
+#define ADXL343_LINK		0x20
+#define ADXL343_MEASURE		0x08
+#define ADXL343_FULL_RES	0x08
+#define ADXL343_MG_PER_THR	62.5	// THRESH_* scale
+#define ADXL343_US_PER_DUR	625U	// DUR scale
+#define ADXL343_MS_PER_FF	5U		// TIME_FF scale
+
+#define ADXL343_LATCHED_INT	(ADXL343_INT_SINGLE_TAP | 0x20 | ADXL343_INT_ACTIVITY | ADXL343_INT_INACTIVITY | ADXL343_INT_FREE_FALL)
+
+#define FIFO_BYPASS			0
+#define FIFO_STREAM			2
+
+#define ADXL343_QUIET_MAX_US	60000000ULL	// longest run proven quiet at once
+
+static void adxl_tick(void *ctx);
+
+static uint64_t adxl_period_us(const adxl343_model *m){
+
+	uint8_t code = m->regs[ADXL343_REG_BW_RATE] & 0x0F;
+
+	// ODR = 3200 Hz / 2^(15 - rate code)
+	return (1000000ULL << (15 - code)) / 3200U;
+}
+
+static bool adxl_measuring(const adxl343_model *m){
+	return (m->regs[ADXL343_REG_PWR_CTL] & ADXL343_MEASURE) != 0;
+}
+
+static uint8_t adxl_fifo_mode(const adxl343_model *m){
+	return m->regs[ADXL343_REG_FIFO_CTL] >> 6;
+}
+
+static uint8_t adxl_watermark(const adxl343_model *m){
+	return m->regs[ADXL343_REG_FIFO_CTL] & 0x1F;
+}
+
+static bool adxl_per_sample(const adxl343_model *m){
+	return (m->regs[ADXL343_REG_ACT_INACT_CTL] & 0x77) ||
+		   (m->regs[ADXL343_REG_TAP_AXES] & 0x07) ||
+		   (m->regs[ADXL343_REG_INT_ENABLE] & ADXL343_INT_FREE_FALL);
+}
+
+// lround() without the libm call, two of them per axis and sample. Exact:
+// x - trunc(x) loses nothing at these magnitudes
+static long adxl_round(double x){
+
+	long whole = (long)x;
+	double frac = x - (double)whole;
+
+	if(frac >= 0.5){
+		whole++;
+	} else if(frac <= -0.5){
+		whole--;
+	}
+	return whole;
+}
+
+static int16_t adxl_mg_to_lsb(const adxl343_model *m, double mg){
+
+	uint8_t format = m->regs[ADXL343_REG_DATA_FMT];
+	uint8_t range = format & 0x03;
+	double limit = 2000.0 * (1 << range);
+	double lsb_per_g = (format & ADXL343_FULL_RES) ? 256.0 : 256.0 / (1 << range);
+
+	if(mg > limit){
+		mg = limit;
+	} else if(mg < -limit){
+		mg = -limit;
+	}
+
+	return (int16_t)adxl_round(mg * lsb_per_g / 1000.0);
+}
+
+static void adxl_load_output(adxl343_model *m, const int16_t *sample){
+
+	for(uint8_t i = 0; i < 3; i++){
+		m->regs[ADXL343_REG_DATA_X0 + 2 * i] = (uint8_t)(sample[i] & 0xFF);
+		m->regs[ADXL343_REG_DATA_X0 + 2 * i + 1] = (uint8_t)((uint16_t)sample[i] >> 8);
+	}
+}
+
+static void adxl_fifo_flags(adxl343_model *m){
+
+	uint8_t source = m->regs[ADXL343_REG_INT_SOURCE] & ~(ADXL343_INT_DATA_READY | ADXL343_INT_WATERMARK);
+	uint8_t wm = adxl_watermark(m);
+
+	if(m->fifo_count > 0){
+		source |= ADXL343_INT_DATA_READY;
+	}
+	if(wm > 0 && m->fifo_count >= wm){
+		source |= ADXL343_INT_WATERMARK;
+	}
+	m->regs[ADXL343_REG_INT_SOURCE] = source;
+	m->regs[ADXL343_REG_FIFO_STATUS] = m->fifo_count;
+}
+
+static void adxl_update_pins(adxl343_model *m){
+
+	uint8_t active = m->regs[ADXL343_REG_INT_SOURCE] & m->regs[ADXL343_REG_INT_ENABLE];
+	uint8_t map = m->regs[ADXL343_REG_INT_MAP];
+	bool int1 = (active & ~map) != 0;
+	bool int2 = (active & map) != 0;
+
+	if(int1 && !m->int1_level){
+		m->interrupts++;
+		if(m->int1_pin != 0){
+			host_gpio_exti(m->int1_pin);
+		}
+	}
+	if(int2 && !m->int2_level){
+		m->interrupts++;
+		if(m->int2_pin != 0){
+			host_gpio_exti(m->int2_pin);
+		}
+	}
+	m->int1_level = int1;
+	m->int2_level = int2;
+}
+
+//----------------------------------------- DETECTION --------------------------------------------------
+
+static void adxl_detect(adxl343_model *m, const double *mg){
+
+	uint8_t ctl = m->regs[ADXL343_REG_ACT_INACT_CTL];
+	uint8_t enable = m->regs[ADXL343_REG_INT_ENABLE];
+	uint8_t events = 0;
+	double period_ms = (double)adxl_period_us(m) / 1000.0;
+	bool link = (m->regs[ADXL343_REG_PWR_CTL] & ADXL343_LINK) != 0;
+
+	// Activity: any enabled axis above THRESH_ACT (dc or ac coupled). Linked,
+	// only once inactivity was seen, then inactivity is looked for again
+	uint8_t act_axes = (ctl >> 4) & 0x07;
+	if(act_axes && m->regs[ADXL343_REG_THRESH_ACT] && !(link && m->link_active)){
+		double thr = m->regs[ADXL343_REG_THRESH_ACT] * ADXL343_MG_PER_THR;
+		uint8_t status = 0;
+
+		for(uint8_t i = 0; i < 3; i++){
+			double value = (ctl & 0x80) ? mg[i] - m->ac_reference[i] : mg[i];
+			if((act_axes & (0x04 >> i)) && fabs(value) > thr){
+				status |= 0x40 >> i;
+			}
+		}
+
+		if(status){
+			events |= ADXL343_INT_ACTIVITY;
+			m->regs[ADXL343_REG_ACT_TAP_STATUS] = (m->regs[ADXL343_REG_ACT_TAP_STATUS] & 0x0F) | status;
+			if(link){
+				m->link_active = true;
+				m->inactive_samples = 0;
+			}
+		}
+	}
+
+	// Inactivity: all enabled axes below THRESH_INACT for TIME_INACT seconds.
+	// Linked, from power-up and after each activity. Ac coupled, the reference
+	// follows every sample above the threshold
+	uint8_t inact_axes = ctl & 0x07;
+	if(inact_axes && m->regs[ADXL343_REG_THRESH_INACT] && !(link && !m->link_active)){
+		double thr = m->regs[ADXL343_REG_THRESH_INACT] * ADXL343_MG_PER_THR;
+		bool quiet = true;
+
+		for(uint8_t i = 0; i < 3; i++){
+			double value = (ctl & 0x08) ? mg[i] - m->inact_reference[i] : mg[i];
+			if((inact_axes & (0x04 >> i)) && fabs(value) >= thr){
+				quiet = false;
+			}
+		}
+
+		if(quiet){
+			uint32_t needed = (uint32_t)(m->regs[ADXL343_REG_TIME_INACT] * 1000.0 / period_ms);
+			m->inactive_samples++;
+			if(m->inactive_samples == (needed ? needed : 1)){
+				events |= ADXL343_INT_INACTIVITY;
+				if(link){
+					m->link_active = false;
+					memcpy(m->ac_reference, m->last_mg, sizeof(m->ac_reference));
+				}
+			}
+		} else {
+			m->inactive_samples = 0;
+			memcpy(m->inact_reference, m->last_mg, sizeof(m->inact_reference));
+		}
+	}
+
+	// Free fall: all axes below THRESH_FF for TIME_FF
+	if(m->regs[ADXL343_REG_THRESH_FF]){
+		double thr = m->regs[ADXL343_REG_THRESH_FF] * ADXL343_MG_PER_THR;
+
+		if(fabs(mg[0]) < thr && fabs(mg[1]) < thr && fabs(mg[2]) < thr){
+			uint32_t needed = (uint32_t)(m->regs[ADXL343_REG_TIME_FF] * ADXL343_MS_PER_FF / period_ms);
+			m->free_fall_samples++;
+			if(m->free_fall_samples == (needed ? needed : 1)){
+				events |= ADXL343_INT_FREE_FALL;
+			}
+		} else {
+			m->free_fall_samples = 0;
+		}
+	}
+
+	// Single tap: an enabled axis goes above THRESH_TAP for no longer than DUR
+	uint8_t tap_axes = m->regs[ADXL343_REG_TAP_AXES] & 0x07;
+	if(tap_axes && m->regs[ADXL343_REG_THRESH_TAP]){
+		double thr = m->regs[ADXL343_REG_THRESH_TAP] * ADXL343_MG_PER_THR;
+		uint8_t status = 0;
+
+		for(uint8_t i = 0; i < 3; i++){
+			if((tap_axes & (0x04 >> i)) && fabs(mg[i]) > thr){
+				status |= 0x04 >> i;
+			}
+		}
+
+		if(status){
+			m->tap_samples++;
+			m->regs[ADXL343_REG_ACT_TAP_STATUS] = (m->regs[ADXL343_REG_ACT_TAP_STATUS] & 0xF0) | status;
+		} else if(m->tap_samples > 0){
+			uint64_t duration = m->tap_samples * adxl_period_us(m);
+			uint64_t max_duration = (uint64_t)m->regs[ADXL343_REG_DUR] * ADXL343_US_PER_DUR;
+
+			// At low ODR a single sample may already outlast DUR
+			if(m->tap_samples == 1 || duration <= max_duration){
+				events |= ADXL343_INT_SINGLE_TAP;
+			}
+			m->tap_samples = 0;
+		}
+	}
+
+	m->regs[ADXL343_REG_INT_SOURCE] |= events & enable;
+}
+
+//----------------------------------------- SAMPLING ---------------------------------------------------
+
+static void adxl_sample(adxl343_model *m, uint64_t t_us){
+
+	double mg[3];
+	int16_t raw[3];
+
+	for(uint8_t i = 0; i < 3; i++){
+		mg[i] = host_waveform_eval(&m->axis[i], t_us);
+		raw[i] = adxl_mg_to_lsb(m, mg[i]);
+		m->last_mg[i] = (int16_t)adxl_round(mg[i]);
+	}
+
+	m->samples++;
+
+	if(adxl_per_sample(m)){
+		adxl_detect(m, mg);
+	}
+
+	if(adxl_fifo_mode(m) == FIFO_BYPASS){
+		if(m->regs[ADXL343_REG_INT_SOURCE] & ADXL343_INT_DATA_READY){
+			m->regs[ADXL343_REG_INT_SOURCE] |= ADXL343_INT_OVERRUN;
+			m->overruns++;
+		}
+		adxl_load_output(m, raw);
+		m->regs[ADXL343_REG_INT_SOURCE] |= ADXL343_INT_DATA_READY;
+	} else {
+		if(m->fifo_count == ADXL343_FIFO_DEPTH){
+			m->regs[ADXL343_REG_INT_SOURCE] |= ADXL343_INT_OVERRUN;
+
+			// Nobody asked for the entry with the watermark masked (parked)
+			if(m->regs[ADXL343_REG_INT_ENABLE] & ADXL343_INT_WATERMARK){
+				m->overruns++;
+			} else {
+				m->discarded++;
+			}
+
+			if(adxl_fifo_mode(m) != FIFO_STREAM){
+				adxl_update_pins(m);
+				return;
+			}
+			m->fifo_head = (m->fifo_head + 1) % ADXL343_FIFO_DEPTH;
+			m->fifo_count--;
+		}
+
+		uint8_t tail = (m->fifo_head + m->fifo_count) % ADXL343_FIFO_DEPTH;
+		memcpy(m->fifo[tail], raw, sizeof(raw));
+		m->fifo_count++;
+
+		adxl_load_output(m, m->fifo[m->fifo_head]);
+		adxl_fifo_flags(m);
+	}
+
+	adxl_update_pins(m);
+}
+
+// Upcoming samples (at most limit) that leave every enabled detector where
+// it is, bar the inactivity count. 0 when the waveform bounds cannot tell
+static uint64_t adxl_quiet_samples(const adxl343_model *m, uint64_t limit){
+
+	uint8_t ctl = m->regs[ADXL343_REG_ACT_INACT_CTL];
+	bool link = (m->regs[ADXL343_REG_PWR_CTL] & ADXL343_LINK) != 0;
+	uint64_t period = adxl_period_us(m);
+	double lo[3];
+	double hi[3];
+
+	// FIFO mode keeps the oldest entries, so none can be skipped
+	if(limit == 0 || (adxl_fifo_mode(m) != FIFO_BYPASS && adxl_fifo_mode(m) != FIFO_STREAM)){
+		return 0;
+	}
+
+	for(uint8_t i = 0; i < 3; i++){
+		host_waveform_bounds(&m->axis[i], m->next_sample_us, m->next_sample_us + (limit - 1) * period, &lo[i], &hi[i]);
+	}
+
+	uint8_t act_axes = (ctl >> 4) & 0x07;
+	if(act_axes && m->regs[ADXL343_REG_THRESH_ACT] && !(link && m->link_active)){
+		double thr = m->regs[ADXL343_REG_THRESH_ACT] * ADXL343_MG_PER_THR;
+
+		for(uint8_t i = 0; i < 3; i++){
+			double ref = (ctl & 0x80) ? m->ac_reference[i] : 0.0;
+			if((act_axes & (0x04 >> i)) && (hi[i] - ref > thr || lo[i] - ref < -thr)){
+				return 0;
+			}
+		}
+	}
+
+	// Only the all-quiet case is predictable: it just counts up
+	uint8_t inact_axes = ctl & 0x07;
+	if(inact_axes && m->regs[ADXL343_REG_THRESH_INACT] && !(link && !m->link_active)){
+		double thr = m->regs[ADXL343_REG_THRESH_INACT] * ADXL343_MG_PER_THR;
+		double period_ms = (double)period / 1000.0;
+		uint32_t needed = (uint32_t)(m->regs[ADXL343_REG_TIME_INACT] * 1000.0 / period_ms);
+
+		for(uint8_t i = 0; i < 3; i++){
+			double ref = (ctl & 0x08) ? m->inact_reference[i] : 0.0;
+			if((inact_axes & (0x04 >> i)) && (hi[i] - ref >= thr || lo[i] - ref <= -thr)){
+				return 0;
+			}
+		}
+
+		// The sample that completes TIME_INACT goes through adxl_detect()
+		needed = needed ? needed : 1;
+		if(m->inactive_samples < needed && limit > needed - m->inactive_samples - 1){
+			limit = needed - m->inactive_samples - 1;
+		}
+	}
+
+	// Free fall ruled out by one axis staying above THRESH_FF
+	if(m->regs[ADXL343_REG_THRESH_FF]){
+		double thr = m->regs[ADXL343_REG_THRESH_FF] * ADXL343_MG_PER_THR;
+		bool held = false;
+
+		for(uint8_t i = 0; i < 3; i++){
+			if(lo[i] >= thr || hi[i] <= -thr){
+				held = true;
+			}
+		}
+		if(!held){
+			return 0;
+		}
+	}
+
+	uint8_t tap_axes = m->regs[ADXL343_REG_TAP_AXES] & 0x07;
+	if(tap_axes && m->regs[ADXL343_REG_THRESH_TAP]){
+		double thr = m->regs[ADXL343_REG_THRESH_TAP] * ADXL343_MG_PER_THR;
+
+		if(m->tap_samples > 0){
+			return 0;
+		}
+		for(uint8_t i = 0; i < 3; i++){
+			if((tap_axes & (0x04 >> i)) && (hi[i] > thr || lo[i] < -thr)){
+				return 0;
+			}
+		}
+	}
+
+	return limit;
+}
+
+// Counts for samples nobody will see: the FIFO-depth samples computed after
+// them overwrite every entry they would have left
+static void adxl_skip(adxl343_model *m, uint64_t count){
+
+	uint8_t ctl = m->regs[ADXL343_REG_ACT_INACT_CTL];
+	bool link = (m->regs[ADXL343_REG_PWR_CTL] & ADXL343_LINK) != 0;
+	uint64_t lost;
+
+	m->samples += count;
+	m->next_sample_us += count * adxl_period_us(m);
+
+	if(adxl_per_sample(m)){
+		if((ctl & 0x07) && m->regs[ADXL343_REG_THRESH_INACT] && !(link && !m->link_active)){
+			m->inactive_samples += count;
+		}
+		m->free_fall_samples = 0;
+	}
+
+	if(adxl_fifo_mode(m) == FIFO_BYPASS){
+		lost = (m->regs[ADXL343_REG_INT_SOURCE] & ADXL343_INT_DATA_READY) ? count : count - 1;
+		m->regs[ADXL343_REG_INT_SOURCE] |= ADXL343_INT_DATA_READY;
+	} else {
+		lost = (m->fifo_count + count > ADXL343_FIFO_DEPTH) ? m->fifo_count + count - ADXL343_FIFO_DEPTH : 0;
+		m->fifo_head = (m->fifo_head + lost) % ADXL343_FIFO_DEPTH;
+		m->fifo_count = (uint8_t)(m->fifo_count + count - lost);
+	}
+
+	if(lost > 0){
+		m->regs[ADXL343_REG_INT_SOURCE] |= ADXL343_INT_OVERRUN;
+		if(adxl_fifo_mode(m) != FIFO_BYPASS && !(m->regs[ADXL343_REG_INT_ENABLE] & ADXL343_INT_WATERMARK)){
+			m->discarded += lost;
+		} else {
+			m->overruns += lost;
+		}
+	}
+}
+
+static void adxl_catch_up(adxl343_model *m, uint64_t now){
+
+	uint64_t period = adxl_period_us(m);
+	uint64_t quiet;
+
+	if(!adxl_measuring(m) || m->next_sample_us > now){
+		return;
+	}
+
+	// Only the last FIFO-depth samples matter, unless a detector needs them
+	uint64_t due = (now - m->next_sample_us) / period + 1;
+	if(!adxl_per_sample(m)){
+		quiet = due;
+	} else if(m->quiet_until_us > m->next_sample_us){
+		quiet = (m->quiet_until_us - m->next_sample_us + period - 1) / period;
+		quiet = (quiet < due) ? quiet : due;
+	} else {
+		quiet = 0;
+	}
+	if(quiet > ADXL343_FIFO_DEPTH && (adxl_fifo_mode(m) == FIFO_BYPASS || adxl_fifo_mode(m) == FIFO_STREAM)){
+		adxl_skip(m, quiet - ADXL343_FIFO_DEPTH);
+	}
+
+	while(m->next_sample_us <= now){
+		adxl_sample(m, m->next_sample_us);
+		m->next_sample_us += period;
+	}
+}
+
+static void adxl_reschedule(adxl343_model *m){
+
+	uint64_t period = adxl_period_us(m);
+	uint8_t enable = m->regs[ADXL343_REG_INT_ENABLE];
+	uint64_t at = HOST_NO_EVENT;
+
+	host_cancel(adxl_tick, m);
+
+	if(!adxl_measuring(m)){
+		m->quiet_until_us = 0;
+		return;
+	}
+
+	// A proven run stays valid until a register or the waveform changes. A
+	// failed proof (the signal is busy) is not retried for a FIFO depth
+	if(adxl_per_sample(m) && m->quiet_until_us <= m->next_sample_us && m->quiet_retry_us <= m->next_sample_us){
+		m->quiet_until_us = m->next_sample_us + adxl_quiet_samples(m, ADXL343_QUIET_MAX_US / period) * period;
+		if(m->quiet_until_us == m->next_sample_us){
+			m->quiet_retry_us = m->next_sample_us + ADXL343_FIFO_DEPTH * period;
+		}
+	}
+
+	if(enable & ADXL343_INT_DATA_READY){
+		at = m->next_sample_us;
+	} else if(adxl_fifo_mode(m) != FIFO_BYPASS){
+		uint8_t wm = adxl_watermark(m);
+
+		if((enable & ADXL343_INT_WATERMARK) && wm > 0 && m->fifo_count < wm){
+			at = m->next_sample_us + (wm - m->fifo_count - 1) * period;
+		}
+		if((enable & ADXL343_INT_OVERRUN) && m->fifo_count < ADXL343_FIFO_DEPTH){
+			uint64_t full = m->next_sample_us + (ADXL343_FIFO_DEPTH - m->fifo_count) * period;
+			if(full < at){
+				at = full;
+			}
+		}
+	}
+
+	// The first sample not proven quiet goes through the detectors on time
+	if(adxl_per_sample(m)){
+		uint64_t first = (m->quiet_until_us > m->next_sample_us) ? m->quiet_until_us : m->next_sample_us;
+		if(first < at){
+			at = first;
+		}
+	}
+
+	if(at != HOST_NO_EVENT){
+		host_schedule(at, adxl_tick, m);
+	}
+}
+
+static void adxl_tick(void *ctx){
+
+	adxl343_model *m = (adxl343_model *)ctx;
+
+	adxl_catch_up(m, host_now_us());
+	adxl_reschedule(m);
+}
+
+static void adxl_fifo_clear(adxl343_model *m){
+
+	m->fifo_head = 0;
+	m->fifo_count = 0;
+	adxl_fifo_flags(m);
+}
+
+static void adxl_fifo_pop(adxl343_model *m){
+
+	if(adxl_fifo_mode(m) == FIFO_BYPASS){
+		m->regs[ADXL343_REG_INT_SOURCE] &= ~(ADXL343_INT_DATA_READY | ADXL343_INT_OVERRUN);
+		return;
+	}
+
+	if(m->fifo_count > 0){
+		m->fifo_head = (m->fifo_head + 1) % ADXL343_FIFO_DEPTH;
+		m->fifo_count--;
+	}
+	if(m->fifo_count > 0){
+		adxl_load_output(m, m->fifo[m->fifo_head]);
+	}
+
+	m->regs[ADXL343_REG_INT_SOURCE] &= ~ADXL343_INT_OVERRUN;
+	adxl_fifo_flags(m);
+}
+
+//----------------------------------------- I2C --------------------------------------------------------
+
+static void adxl_write_reg(adxl343_model *m, uint8_t reg, uint8_t value){
+
+	uint8_t old;
+
+	if(reg >= ADXL343_MODEL_REGS){
+		return;
+	}
+
+	switch(reg){
+		case 0x00:
+		case ADXL343_REG_ACT_TAP_STATUS:
+		case ADXL343_REG_INT_SOURCE:
+		case ADXL343_REG_FIFO_STATUS:
+			break;
+
+		case ADXL343_REG_PWR_CTL:
+			old = m->regs[reg];
+			m->regs[reg] = value;
+			if((value & ADXL343_MEASURE) && !(old & ADXL343_MEASURE)){
+				m->next_sample_us = host_now_us() + adxl_period_us(m);
+			}
+			m->link_active = true;
+			m->inactive_samples = 0;
+			break;
+
+		case ADXL343_REG_FIFO_CTL:
+			old = m->regs[reg];
+			m->regs[reg] = value;
+			if((old >> 6) != (value >> 6)){
+				adxl_fifo_clear(m);
+			} else {
+				adxl_fifo_flags(m);
+			}
+			break;
+
+		case ADXL343_REG_ACT_INACT_CTL:
+			m->regs[reg] = value;
+			memcpy(m->ac_reference, m->last_mg, sizeof(m->ac_reference));
+			memcpy(m->inact_reference, m->last_mg, sizeof(m->inact_reference));
+			m->inactive_samples = 0;
+			break;
+
+		default:
+			if(reg < ADXL343_REG_DATA_X0 || reg > ADXL343_REG_DATA_Z1){
+				m->regs[reg] = value;
+			}
+			break;
+	}
+}
+
+static HAL_StatusTypeDef adxl_i2c_write(void *ctx, const uint8_t *pData, uint16_t size){
+
+	adxl343_model *m = (adxl343_model *)ctx;
+
+	if(size == 0){
+		return HAL_OK;
+	}
+
+	adxl_catch_up(m, host_now_us());
+
+	m->pointer = pData[0];
+
+	// A bare register pointer (the read address) changes nothing
+	for(uint16_t i = 1; i < size; i++){
+		adxl_write_reg(m, m->pointer++, pData[i]);
+		m->quiet_until_us = 0;
+		m->quiet_retry_us = 0;
+	}
+
+	adxl_update_pins(m);
+	adxl_reschedule(m);
+	return HAL_OK;
+}
+
+static HAL_StatusTypeDef adxl_i2c_read(void *ctx, uint8_t *pData, uint16_t size){
+
+	adxl343_model *m = (adxl343_model *)ctx;
+	bool data_read = false;
+	bool source_read = false;
+
+	adxl_catch_up(m, host_now_us());
+
+	for(uint16_t i = 0; i < size; i++){
+		uint8_t reg = m->pointer++;
+
+		if(reg >= ADXL343_MODEL_REGS){
+			pData[i] = 0;
+			continue;
+		}
+
+		if(reg >= ADXL343_REG_DATA_X0 && reg <= ADXL343_REG_DATA_Z1){
+			data_read = true;
+		}
+		if(reg == ADXL343_REG_INT_SOURCE){
+			source_read = true;
+		}
+		pData[i] = m->regs[reg];
+	}
+
+	if(source_read){
+		m->regs[ADXL343_REG_INT_SOURCE] &= ~ADXL343_LATCHED_INT;
+	}
+	if(data_read){
+		adxl_fifo_pop(m);
+	}
+
+	adxl_update_pins(m);
+	adxl_reschedule(m);
+	return HAL_OK;
+}
+
+//----------------------------------------- SETUP ------------------------------------------------------
+
+void adxl343_model_init(adxl343_model *m, uint16_t int1_pin, uint16_t int2_pin){
+
+	memset(m, 0, sizeof(*m));
+
+	m->int1_pin = int1_pin;
+	m->int2_pin = int2_pin;
+
+	m->regs[0x00] = ADXL343_DEVID;
+	m->regs[ADXL343_REG_BW_RATE] = 0x0A;		// 100 Hz
+
+	m->axis[2].offset = 1000.0;
+}
+
+uint8_t adxl343_model_attach(adxl343_model *m, uint16_t addr){
+
+	host_i2c_device dev = {addr, adxl_i2c_write, adxl_i2c_read, m};
+
+	return host_i2c_attach(&dev);
+}
+
+// Brings the model up to now: after editing m->axis[] (the quiet run ahead
+// was proven on the old waveform) and before reading its counters
+void adxl343_model_sync(adxl343_model *m){
+
+	adxl_catch_up(m, host_now_us());
+	m->quiet_until_us = 0;
+	m->quiet_retry_us = 0;
+	adxl_reschedule(m);
+}
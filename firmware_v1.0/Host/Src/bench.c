@@ -0,0 +1,874 @@
+/*
+ * bench.c
+ *
+ *  Host benchmark for the application modules. Runs app_fsm(), log_write(),
+ *  an I2C engine job and the sensor conversions against the HAL shim and
+ *  reports wall-clock cost next to the virtual (on-target) time and bus
+ *  traffic per call.
+ *
+ *  Before timing, the fixed-point conversion kernels are checked against
+ *  the float formulas they replaced over their whole input range; the run
+ *  fails if any result is off by more than the rounding half-step. The
+ *  series codec is round-tripped over a week of modelled sensor data, the
+ *  EEPROM blocks also from their second record on as if their anchor had
+ *  been overwritten, and its size compared with fixed binary records and
+ *  the entropy of the deltas. Last, the whole firmware
+ *  runs from main() with the temperature held over its alert limit and has
+ *  to keep cycling through DATA_READ and COMMS.
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: dst2001055
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "hal_host.h"
+#include "sensor_models.h"
+#include "gpio.h"
+#include "i2c.h"
+#include "usart.h"
+#include "rtc.h"
+#include "tim.h"
+#include "app.h"
+#include "mal.h"
+#include "frame.h"
+#include "series.h"
+#include "stats.h"
+#include "vibration.h"
+
+#define BENCH_DEFAULT_ITER 1000
+
+#define BENCH_HELD_SETTLE_US	(10ULL * 60 * 1000000)		// threshold crossed and served by then
+#define BENCH_HELD_RUN_US		(70ULL * 60 * 1000000)
+#define BENCH_HELD_MIN_CYCLES	60							// one DATA_READ/COMMS cycle a minute at least
+
+typedef void (*bench_fn)(void);
+
+static hdc2080_model hdc2080;
+static adxl343_model adxl343;
+
+extern int firmware_main(void);
+
+static volatile float bench_sink;
+static uint16_t bench_raw;
+
+//----------------------------------------- SETUP ------------------------------------------------------
+
+static void bench_setup(void){
+
+	host_reset();
+
+	// ADXL343 INT1/INT2 land on PB5/PB6
+	hdc2080_model_init(&hdc2080, INT_HDC2080_PIN);
+	adxl343_model_init(&adxl343, GPIO_PIN_5, GPIO_PIN_6);
+	host_profile_storage_room(&hdc2080, &adxl343);
+
+	hdc2080_model_attach(&hdc2080, HDC2080_ADDR);
+	adxl343_model_attach(&adxl343, ADXL343_ADDR);
+
+	MX_GPIO_Init();
+	MX_I2C1_Init();
+	MX_LPUART1_UART_Init();
+	MX_USART2_UART_Init();
+	MX_RTC_Init();
+	MX_TIM21_Init();
+
+	init_device();
+}
+
+//----------------------------------------- CASES ------------------------------------------------------
+
+static void bench_app_fsm(void){
+	app_fsm();
+}
+
+static void bench_read_sensors(void){
+	state_read_sensors();
+}
+
+// Drain the TX ring every call so the DMA path is measured end to end
+// instead of dropping lines once the ring is full
+static void bench_log_write(void){
+	LOG_WRITE(INFO_LOG, LOG_TEMPERATURE, 25);
+	flush_UART_tx(UART_TX_FLUSH_MS);
+}
+
+// HDC2080 trigger and an ADXL343 XYZ read chained in one engine job, with
+// the CPU asleep until the completion callback
+static uint8_t bench_hdc_trigger[1] = {0x01};
+static uint8_t bench_adxl_data[6];
+static volatile bool bench_job_done;
+
+static const i2c_xfer bench_chain[] = {
+	{HDC2080, I2C_OP_REG_WRITE, HDC2080_REG_MEASURE, bench_hdc_trigger, sizeof(bench_hdc_trigger)},
+	{ADXL343, I2C_OP_REG_READ, ADXL343_REG_DATAX0, bench_adxl_data, sizeof(bench_adxl_data)},
+};
+
+static void bench_chain_done(uint8_t error, void *ctx){
+	(void)error;
+	(void)ctx;
+	bench_job_done = true;
+}
+
+static void bench_i2c_chain(void){
+
+	i2c_job job = {bench_chain, sizeof(bench_chain) / sizeof(bench_chain[0]), bench_chain_done, NULL};
+
+	bench_job_done = false;
+	submit_i2c_job(&job);
+
+	while(!bench_job_done){
+		__WFI();
+	}
+}
+
+static void bench_get_temperature(void){
+	bench_sink = get_temperature();
+}
+
+static void bench_get_humidity(void){
+	bench_sink = get_humidity();
+}
+
+static void bench_get_accel(void){
+	bench_sink = get_accel().z_axis_accel;
+}
+
+//----------------------------------------- CONVERSIONS ------------------------------------------------
+
+// Float reference: the conversions as they were before the fixed-point kernels
+__attribute__((noinline)) static float ref_temperature(uint16_t raw){
+	return ((raw * 165.0f) / 65536.0f) - (40.5f + 0.08f * (3.3f - 1.8f));
+}
+
+__attribute__((noinline)) static float ref_humidity(uint16_t raw){
+	return (raw / 65536.0f) * 100.0f;
+}
+
+__attribute__((noinline)) static float ref_accel(int32_t raw_sum, uint16_t samples){
+	return (raw_sum * 0.004f / samples) * 1000;
+}
+
+static uint8_t ref_temp_code(uint8_t temp_max){
+	return (uint8_t)(256.0f * (temp_max + 40.0f) / 165.0f);
+}
+
+static uint8_t ref_hum_code(uint8_t hum_max){
+	return (uint8_t)(256.0f * hum_max / 100.0f);
+}
+
+// Fixed result vs float reference scaled to the same unit: worst error and
+// how many inputs fall outside the rounding half-step. Print mismatches count
+// the logged integer (the _whole() kernels) differing from roundf() of the
+// reference; both fail the check
+typedef struct{
+	uint32_t inputs;
+	uint32_t out_of_tolerance;
+	uint32_t print_mismatches;
+	double max_error;
+}check_result;
+
+static void check_value(check_result *r, int32_t fixed, double ref, double scale, int32_t printed){
+
+	double error = fabs(fixed - ref * scale);
+
+	r->inputs++;
+	if(error > r->max_error){
+		r->max_error = error;
+	}
+	if(error > 0.5 + 1e-3){
+		r->out_of_tolerance++;
+	}
+	if(scale != 1 && printed != (int32_t)roundf(ref)){
+		r->print_mismatches++;
+	}
+}
+
+static uint32_t report_check(const char *name, const check_result *r){
+
+	printf("%-28s %8u inputs  max err %.3f  %u out of tolerance  %u print mismatches\r\n", name,
+			r->inputs, r->max_error, r->out_of_tolerance, r->print_mismatches);
+	return r->out_of_tolerance + r->print_mismatches;
+}
+
+static uint32_t check_conversions(void){
+
+	check_result temp = {0}, hum = {0}, accel = {0}, code = {0};
+	uint32_t failures = 0;
+
+	for(uint32_t raw = 0; raw <= 0xFFFF; raw++){
+		check_value(&temp, convert_temperature(raw), ref_temperature(raw), CENTI, convert_temperature_whole(raw));
+		check_value(&hum, convert_humidity(raw), ref_humidity(raw), CENTI, convert_humidity_whole(raw));
+	}
+
+	// One sample over the full register range, then FIFO/loop means at +-4 g
+	for(int32_t raw = INT16_MIN / ACCEL_MG_PER_LSB; raw <= INT16_MAX / ACCEL_MG_PER_LSB; raw++){
+		check_value(&accel, convert_accel(raw, 1), ref_accel(raw, 1), 1, 0);
+	}
+	for(int32_t sum = -1024 * ACCEL_FIFO_WATERMARK; sum <= 1024 * ACCEL_FIFO_WATERMARK; sum++){
+		check_value(&accel, convert_accel(sum, SAMPLE_SIZE), ref_accel(sum, SAMPLE_SIZE), 1, 0);
+		check_value(&accel, convert_accel(sum, ACCEL_FIFO_WATERMARK), ref_accel(sum, ACCEL_FIFO_WATERMARK), 1, 0);
+	}
+
+	// 100 %RH is left out: the float cast of 256.0 to uint8_t is undefined
+	for(uint8_t t = TEMP_MIN_LIMIT; t <= TEMP_MAX_LIMIT; t++){
+		check_value(&code, temp_threshold_code(t), ref_temp_code(t), 1, 0);
+	}
+	for(uint8_t h = HUM_MIN_LIMIT; h < HUM_MAX_LIMIT; h++){
+		check_value(&code, hum_threshold_code(h), ref_hum_code(h), 1, 0);
+	}
+
+	failures += report_check("convert_temperature()", &temp);
+	failures += report_check("convert_humidity()", &hum);
+	failures += report_check("convert_accel()", &accel);
+	failures += report_check("temp/hum_threshold_code()", &code);
+	printf("\r\n");
+
+	return failures;
+}
+
+// One T, RH and XYZ conversion per call, sweeping the raw input. The host has
+// an FPU and a divider, so only the on-target cost favours the fixed kernels
+static void bench_convert_float(void){
+	bench_raw += 0x9E37;
+	bench_sink = ref_temperature(bench_raw) + ref_humidity(bench_raw) + ref_accel((int16_t)bench_raw, 1)
+			+ ref_accel((int16_t)(bench_raw >> 3), 1) + ref_accel((int16_t)(bench_raw << 3), 1);
+}
+
+//---- SOFT FLOAT ----
+// The M0+ has no FPU: the float reference runs as libgcc calls there. These
+// do the same IEEE single work with integer operations only (no divider, the
+// quotient is built bit by bit), so timing them next to the fixed kernels
+// compares what the target would execute. Normal numbers, round to nearest
+// even; check_soft_float() proves them bit exact against the host FPU
+typedef uint32_t soft_float;
+
+static uint32_t soft_f32(float f){
+
+	uint32_t bits;
+
+	memcpy(&bits, &f, sizeof(bits));
+	return bits;
+}
+
+// sign, m * 2^e -> soft_float, m != 0
+static soft_float soft_round(uint32_t sign, int32_t e, uint64_t m){
+
+	int8_t msb = 63 - __builtin_clzll(m);
+
+	if(msb > 23){
+		uint8_t shift = msb - 23;
+		uint64_t rest = m & ((1ULL << shift) - 1);
+		uint64_t half = 1ULL << (shift - 1);
+
+		m >>= shift;
+		e += shift;
+		if(rest > half || (rest == half && (m & 1))){
+			m++;
+			if(m == (1ULL << 24)){
+				m >>= 1;
+				e++;
+			}
+		}
+	} else {
+		m <<= 23 - msb;
+		e -= 23 - msb;
+	}
+
+	return (sign << 31) | ((uint32_t)(e + 23 + 127) << 23) | ((uint32_t)m & 0x7FFFFF);
+}
+
+static uint64_t soft_mant(soft_float a, int32_t *e){
+
+	*e = (int32_t)((a >> 23) & 0xFF) - 127 - 23;
+	return (a & 0x7FFFFF) | 0x800000;
+}
+
+static soft_float soft_from_int(int32_t v){
+
+	if(v == 0){
+		return 0;
+	}
+	return soft_round(v < 0, 0, v < 0 ? -(int64_t)v : v);
+}
+
+static soft_float soft_mul(soft_float a, soft_float b){
+
+	int32_t ea, eb;
+
+	if((a & 0x7FFFFFFF) == 0 || (b & 0x7FFFFFFF) == 0){
+		return (a ^ b) & 0x80000000;
+	}
+	uint64_t m = soft_mant(a, &ea) * soft_mant(b, &eb);
+	return soft_round((a ^ b) >> 31, ea + eb, m);
+}
+
+static soft_float soft_div(soft_float a, soft_float b){
+
+	int32_t ea, eb;
+	uint64_t rem, den, q = 0;
+
+	if((a & 0x7FFFFFFF) == 0){
+		return (a ^ b) & 0x80000000;
+	}
+	rem = soft_mant(a, &ea);
+	den = soft_mant(b, &eb);
+
+	// 41 quotient bits by shift and subtract, the remainder left is the sticky bit
+	for(uint8_t i = 0; i <= 40; i++){
+		q <<= 1;
+		if(rem >= den){
+			rem -= den;
+			q |= 1;
+		}
+		rem <<= 1;
+	}
+	return soft_round((a ^ b) >> 31, ea - eb - 41, (q << 1) | (rem != 0));
+}
+
+static soft_float soft_add(soft_float a, soft_float b){
+
+	int32_t ea, eb;
+
+	if((a & 0x7FFFFFFF) == 0) return b;
+	if((b & 0x7FFFFFFF) == 0) return a;
+	if(((a >> 23) & 0xFF) < ((b >> 23) & 0xFF)){
+		soft_float t = a;
+		a = b;
+		b = t;
+	}
+
+	uint64_t ma = soft_mant(a, &ea) << 30;
+	uint64_t mb = soft_mant(b, &eb) << 30;
+	uint32_t shift = (uint32_t)(ea - eb);
+
+	mb = (shift >= 64) ? 1 : (mb >> shift) | ((mb & ((1ULL << shift) - 1)) != 0);
+
+	if((a ^ b) >> 31){
+		if(ma == mb){
+			return 0;
+		}
+		return ma > mb ? soft_round(a >> 31, ea - 30, ma - mb) : soft_round(b >> 31, ea - 30, mb - ma);
+	}
+	return soft_round(a >> 31, ea - 30, ma + mb);
+}
+
+// ref_*() step by step, as the compiler emits them (x / 2^16 becomes x * 2^-16)
+static soft_float soft_temperature(uint16_t raw){
+	return soft_add(soft_mul(soft_mul(soft_from_int(raw), soft_f32(165.0f)), soft_f32(1.0f / 65536.0f)),
+			soft_f32(-(40.5f + 0.08f * (3.3f - 1.8f))));
+}
+
+static soft_float soft_humidity(uint16_t raw){
+	return soft_mul(soft_mul(soft_from_int(raw), soft_f32(1.0f / 65536.0f)), soft_f32(100.0f));
+}
+
+static soft_float soft_accel(int32_t raw_sum, uint16_t samples){
+	return soft_mul(soft_div(soft_mul(soft_from_int(raw_sum), soft_f32(0.004f)), soft_from_int(samples)), soft_f32(1000.0f));
+}
+
+static uint32_t check_soft_float(void){
+
+	uint32_t mismatches = 0;
+
+	for(uint32_t raw = 0; raw <= 0xFFFF; raw++){
+		mismatches += soft_temperature(raw) != soft_f32(ref_temperature(raw));
+		mismatches += soft_humidity(raw) != soft_f32(ref_humidity(raw));
+	}
+	for(int32_t sum = -1024 * ACCEL_FIFO_WATERMARK; sum <= 1024 * ACCEL_FIFO_WATERMARK; sum++){
+		mismatches += soft_accel(sum, 1) != soft_f32(ref_accel(sum, 1));
+		mismatches += soft_accel(sum, SAMPLE_SIZE) != soft_f32(ref_accel(sum, SAMPLE_SIZE));
+	}
+
+	printf("%-28s %8u mismatches against the host FPU\r\n\r\n", "soft float reference", mismatches);
+
+	return mismatches;
+}
+
+// bench_convert_float() without an FPU: the target's view of the float path.
+// The fixed kernels' div_round() still uses the host divider, which favours
+// them less than the M0+ software division would
+static volatile soft_float bench_soft_sink;
+
+static void bench_convert_soft(void){
+	bench_raw += 0x9E37;
+	bench_soft_sink = soft_add(soft_add(soft_add(soft_add(soft_temperature(bench_raw), soft_humidity(bench_raw)),
+			soft_accel((int16_t)bench_raw, 1)), soft_accel((int16_t)(bench_raw >> 3), 1)), soft_accel((int16_t)(bench_raw << 3), 1));
+}
+
+static void bench_convert_fixed(void){
+	bench_raw += 0x9E37;
+	bench_sink = convert_temperature(bench_raw) + convert_humidity(bench_raw) + convert_accel((int16_t)bench_raw, 1)
+			+ convert_accel((int16_t)(bench_raw >> 3), 1) + convert_accel((int16_t)(bench_raw << 3), 1);
+}
+
+//----------------------------------------- SERIES -----------------------------------------------------
+
+#define BENCH_SERIES_BLOCK 64
+#define BENCH_SERIES_PENDING 1024
+#define BENCH_HIST_BINS 4096
+
+static const uint8_t bench_series_steps[SERIES_MAX_CHANNELS] = {
+	SERIES_TEMP_STEP, SERIES_HUM_STEP, SERIES_ACCEL_STEP, SERIES_ACCEL_STEP, SERIES_ACCEL_STEP
+};
+
+typedef struct{
+	const char *name;
+	void (*profile)(hdc2080_model *hdc, adxl343_model *adxl);
+	uint8_t channels;
+	uint32_t period_ms;
+	uint32_t samples;
+	uint16_t block_size;
+	uint16_t chunk;
+	int32_t step;
+	bool records;		// EEPROM: linked blocks, whole records, orphans checked
+}series_case;
+
+static const series_case series_cases[] = {
+	{"EEPROM T/H 15 min", host_profile_storage_room, MEM_SERIES_CHANNELS, MEM_SENSOR_PERIOD_MS, 7 * 96,
+			MEM_SERIES_BLOCK, MEM_SERIES_CHUNK, MEM_SERIES_STEP, true},
+	{"T/H/XYZ 5.3 s room", host_profile_storage_room, SERIES_MAX_CHANNELS, 5300, 86400 * 10 / 53,
+			BENCH_SERIES_BLOCK, BENCH_SERIES_BLOCK, 0, false},
+	{"T/H/XYZ 5.3 s truck", host_profile_truck, SERIES_MAX_CHANNELS, 5300, 86400 * 10 / 53,
+			BENCH_SERIES_BLOCK, BENCH_SERIES_BLOCK, 0, false},
+};
+
+static void series_model_sample(hdc2080_model *hdc, adxl343_model *adxl, uint64_t t_us, series_sample *sample){
+
+	sample->time = (uint32_t)(t_us / 1000000);
+	sample->value[SERIES_TEMP] = (int16_t)lround(host_waveform_eval(&hdc->temperature, t_us) * CENTI);
+	sample->value[SERIES_HUM] = (int16_t)lround(host_waveform_eval(&hdc->humidity, t_us) * CENTI);
+	for(uint8_t a = 0; a < 3; a++){
+		sample->value[SERIES_ACCEL_X + a] = (int16_t)lround(host_waveform_eval(&adxl->axis[a], t_us));
+	}
+}
+
+static int32_t bench_quantise(int32_t value, uint8_t step){
+	return (value >= 0 ? value + step / 2 : value - step / 2) / step;
+}
+
+// Decode an opened block and compare with what went in, quantised
+static uint32_t series_check_block(series_decoder *decoder, const series_sample *in, uint16_t count, uint8_t channels){
+
+	series_sample out;
+	uint32_t errors = 0;
+	uint16_t n = 0;
+
+	while(series_next(decoder, &out)){
+		if(n >= count || out.time != in[n].time){
+			errors++;
+		} else {
+			for(uint8_t c = 0; c < channels; c++){
+				uint8_t step = bench_series_steps[c];
+
+				if(out.value[c] != bench_quantise(in[n].value[c], step) * step){
+					errors++;
+				}
+			}
+		}
+		n++;
+	}
+
+	return errors + (n != count ? 1 : 0);
+}
+
+// Zero-order entropy of the quantised channel deltas and time steps: what any
+// coder of independent deltas needs at least, in bytes per sample
+static double series_entropy(uint32_t (*hist)[BENCH_HIST_BINS], uint8_t channels, uint32_t samples){
+
+	double bits = 0.0;
+
+	for(uint8_t c = 0; c <= channels; c++){
+		for(uint32_t b = 0; b < BENCH_HIST_BINS; b++){
+			if(hist[c][b] != 0){
+				double p = (double)hist[c][b] / samples;
+
+				bits -= p * log2(p);
+			}
+		}
+	}
+
+	return bits / 8.0;
+}
+
+static uint32_t check_series(void){
+
+	static series_sample pending[BENCH_SERIES_PENDING];
+	static uint32_t hist[SERIES_MAX_CHANNELS + 1][BENCH_HIST_BINS];
+	uint32_t failures = 0;
+
+	for(uint8_t i = 0; i < sizeof(series_cases) / sizeof(series_cases[0]); i++){
+		const series_case *sc = &series_cases[i];
+		hdc2080_model hdc;
+		adxl343_model adxl;
+		uint8_t block[BENCH_SERIES_BLOCK];
+		series_encoder enc;
+		series_sample prev = {0};
+		uint64_t bytes = 0;
+		uint32_t blocks = 0, errors = 0, orphans = 0;
+		uint16_t count = 0;
+
+		memset(hist, 0, sizeof(hist));
+		sc->profile(&hdc, &adxl);
+		series_begin(&enc, block, sc->block_size, sc->chunk, sc->channels, sc->step);
+
+		for(uint32_t k = 0; k <= sc->samples; k++){
+			series_sample sample;
+			bool last = (k == sc->samples);
+
+			if(!last){
+				series_model_sample(&hdc, &adxl, (uint64_t)k * sc->period_ms * 1000, &sample);
+
+				for(uint8_t c = 0; k > 0 && c < sc->channels; c++){
+					int32_t delta = bench_quantise(sample.value[c], bench_series_steps[c]) -
+									bench_quantise(prev.value[c], bench_series_steps[c]);
+
+					hist[c][zigzag_encode(delta) < BENCH_HIST_BINS ? zigzag_encode(delta) : BENCH_HIST_BINS - 1]++;
+				}
+				if(k > 0){
+					uint32_t step = sample.time - prev.time;
+
+					hist[sc->channels][step < BENCH_HIST_BINS ? step : BENCH_HIST_BINS - 1]++;
+				}
+				prev = sample;
+			}
+
+			if(last || count == BENCH_SERIES_PENDING || !series_add(&enc, &sample)){
+				bool linked = sc->records && !last && series_linkable(&enc, &sample);
+				uint16_t len = series_finish(&enc, linked);
+				series_decoder decoder;
+
+				errors += series_open(&decoder, block, len, sc->chunk, sc->channels, sc->step) ?
+						  series_check_block(&decoder, pending, count, sc->channels) : count;
+				bytes += sc->records ? (len + sc->chunk - 1) / sc->chunk * sc->chunk : len;
+				blocks++;
+
+				// Once the anchor record is overwritten, the rest decodes back from the next anchor
+				if(linked && len > sc->chunk){
+					if(series_open_orphans(&decoder, &block[sc->chunk], len - sc->chunk, sc->chunk, sc->channels, sc->step,
+										   &pending[count - 1])){
+						errors += series_check_block(&decoder, &pending[1], count - 1, sc->channels);
+					} else {
+						errors++;
+					}
+					orphans++;
+				}
+
+				if(last){
+					break;
+				}
+
+				if(linked){
+					pending[0] = pending[count - 1];
+					count = 1;
+					series_continue(&enc);
+				} else {
+					count = 0;
+					series_begin(&enc, block, sc->block_size, sc->chunk, sc->channels, sc->step);
+				}
+				series_add(&enc, &sample);
+			}
+			pending[count++] = sample;
+		}
+
+		// Fixed binary record: u32 time + int16 per channel
+		double packed = 4.0 + 2.0 * sc->channels;
+		double per_sample = (double)bytes / sc->samples;
+		double entropy = series_entropy(hist, sc->channels, sc->samples - 1);
+
+		printf("series %-22s %6u samples %4u blocks %4u orphaned  %5.2f B/sample vs %4.1f packed (%.1fx, entropy %.2f B %.1fx)  %u errors\r\n",
+				sc->name, sc->samples, blocks, orphans, per_sample, packed, packed / per_sample, entropy, packed / entropy, errors);
+		failures += errors;
+	}
+	printf("\r\n");
+
+	return failures;
+}
+
+//----------------------------------------- STATS ------------------------------------------------------
+
+// Fixed-point Welford against exact integer sums over the series cases' 5-channel
+// inputs: min/max must match, mean and sd within one unit
+static uint32_t check_stats(void){
+
+	uint32_t failures = 0;
+
+	for(uint8_t i = 1; i < sizeof(series_cases) / sizeof(series_cases[0]); i++){
+		const series_case *sc = &series_cases[i];
+		hdc2080_model hdc;
+		adxl343_model adxl;
+		channel_stats stats[SERIES_MAX_CHANNELS];
+		int64_t sum[SERIES_MAX_CHANNELS] = {0}, sum2[SERIES_MAX_CHANNELS] = {0};
+		int16_t min[SERIES_MAX_CHANNELS], max[SERIES_MAX_CHANNELS];
+		double mean_error = 0, sd_error = 0;
+		uint32_t errors = 0;
+
+		sc->profile(&hdc, &adxl);
+		for(uint8_t c = 0; c < SERIES_MAX_CHANNELS; c++){
+			stats_reset(&stats[c]);
+		}
+
+		for(uint32_t k = 0; k < sc->samples; k++){
+			series_sample sample;
+
+			series_model_sample(&hdc, &adxl, (uint64_t)k * sc->period_ms * 1000, &sample);
+			for(uint8_t c = 0; c < SERIES_MAX_CHANNELS; c++){
+				int16_t v = sample.value[c];
+
+				stats_add(&stats[c], v, sample.time);
+				sum[c] += v;
+				sum2[c] += (int64_t)v * v;
+				if(k == 0 || v < min[c]) min[c] = v;
+				if(k == 0 || v > max[c]) max[c] = v;
+			}
+		}
+
+		for(uint8_t c = 0; c < SERIES_MAX_CHANNELS; c++){
+			double n = sc->samples;
+			double mean = sum[c] / n;
+			double sd = sqrt((sum2[c] - (double)sum[c] * sum[c] / n) / (n - 1));
+			double e_mean = fabs(stats_mean(&stats[c]) - mean);
+			double e_sd = fabs(stats_stddev(&stats[c]) - sd);
+
+			if(e_mean > mean_error) mean_error = e_mean;
+			if(e_sd > sd_error) sd_error = e_sd;
+			if(stats[c].min != min[c] || stats[c].max != max[c] || stats[c].count != sc->samples || e_mean > 1.0 || e_sd > 1.0){
+				errors++;
+			}
+		}
+
+		printf("stats  %-22s %6u samples  max mean err %.2f  max sd err %.2f  %u errors\r\n",
+				sc->name, sc->samples, mean_error, sd_error, errors);
+		failures += errors;
+	}
+	printf("\r\n");
+
+	return failures;
+}
+
+//----------------------------------------- VIBRATION --------------------------------------------------
+
+typedef struct{
+	const char *name;
+	double hz;			// tone on X, 0 -> noise only
+	double amp_mg;
+	int8_t band;		// where the tone must land, -1 -> none
+}vibration_case;
+
+// Bin-centred tones at the 50 Hz ODR, 1 g on Z and a little noise on every axis
+static const vibration_case vibration_cases[] = {
+	{"noise only",        0.0,    0.0, -1},
+	{"3.125 Hz 300 mg",   3.125,  300.0, VIB_BAND_SWAY},
+	{"6.25 Hz 200 mg",    6.25,   200.0, VIB_BAND_LOW},
+	{"12.5 Hz 500 mg",    12.5,   500.0, VIB_BAND_MID},
+	{"18.75 Hz 100 mg",   18.75,  100.0, VIB_BAND_HIGH},
+};
+
+// 800 FIFO entries (16 s) through vibration_add(): rms within 1 mg and
+// p-p exact against the same raw samples, the tone's band within 3 % of
+// A / sqrt(2) and the other bands under the noise floor
+static uint32_t check_vibration(void){
+
+	uint32_t failures = 0;
+
+	for(uint8_t i = 0; i < sizeof(vibration_cases) / sizeof(vibration_cases[0]); i++){
+		const vibration_case *vc = &vibration_cases[i];
+		const uint16_t n = 800;
+		double sum[3] = {0}, sum2[3] = {0};
+		int16_t min[3] = {0}, max[3] = {0};
+		double rms_error = 0;
+		uint32_t errors = 0;
+
+		vibration_reset();
+
+		for(uint16_t k = 0; k < n; k++){
+			double t = k / 50.0;
+			double mg[3] = {0, 0, 1000};
+			int16_t raw[3];
+
+			mg[0] += vc->amp_mg * sin(2 * M_PI * vc->hz * t + 0.3);
+			for(uint8_t axis = 0; axis < 3; axis++){
+				mg[axis] += 8.0 * sin(k * (axis + 1.7) * 12.9898);	// deterministic noise, about 6 mg RMS
+				raw[axis] = (int16_t)lround(mg[axis] / ACCEL_MG_PER_LSB);
+
+				sum[axis] += raw[axis];
+				sum2[axis] += (double)raw[axis] * raw[axis];
+				if(k == 0 || raw[axis] < min[axis]) min[axis] = raw[axis];
+				if(k == 0 || raw[axis] > max[axis]) max[axis] = raw[axis];
+			}
+			vibration_add(raw);
+		}
+
+		vibration_features features = vibration_take();
+
+		for(uint8_t axis = 0; axis < 3; axis++){
+			double rms = sqrt(sum2[axis] / n - (sum[axis] / n) * (sum[axis] / n)) * ACCEL_MG_PER_LSB;
+			double e_rms = fabs(features.rms[axis] - rms);
+
+			if(e_rms > rms_error) rms_error = e_rms;
+			if(e_rms > 1.0 || features.peak_to_peak[axis] != (max[axis] - min[axis]) * ACCEL_MG_PER_LSB){
+				errors++;
+			}
+		}
+
+		for(uint8_t b = 0; b < VIB_BANDS; b++){
+			double expected = (b == vc->band) ? vc->amp_mg / sqrt(2) : 0;
+
+			if(b == vc->band ? fabs(features.band[b] - expected) > expected * 0.03 : features.band[b] > 10){
+				errors++;
+			}
+		}
+		if(features.samples != n){
+			errors++;
+		}
+
+		printf("vibration %-19s rms %3u/%3u/%3u mg  bands %3u %3u %3u %3u mg  crest X %u.%02u  max rms err %.2f  %u errors\r\n",
+				vc->name, features.rms[0], features.rms[1], features.rms[2],
+				features.band[0], features.band[1], features.band[2], features.band[3],
+				features.crest[0] / 100, features.crest[0] % 100, rms_error, errors);
+		failures += errors;
+	}
+	printf("\r\n");
+
+	return failures;
+}
+
+// After bench_setup(): every IRQ that calls post_event() must sit at
+// EVENT_IRQ_PRIORITY, the lock-free event queue depends on it
+static uint32_t check_irq_priorities(void){
+
+	static const struct{ const char *name; IRQn_Type irq; } producers[] = {
+		{"EXTI4_15", EXTI4_15_IRQn},
+		{"I2C1",     I2C1_IRQn},
+		{"TIM21",    TIM21_IRQn},
+	};
+	uint32_t failures = 0;
+
+	for(uint8_t i = 0; i < sizeof(producers) / sizeof(producers[0]); i++){
+		int16_t priority = host_nvic_priority(producers[i].irq);
+		bool ok = (priority == EVENT_IRQ_PRIORITY);
+
+		printf("event irq %-8s priority %d  %s\r\n", producers[i].name, priority, ok ? "ok" : "FAIL");
+		failures += !ok;
+	}
+	printf("\r\n");
+
+	return failures;
+}
+
+// The real main loop with the temperature held above TEMP_HIGH_ALERT_VAL:
+// the HDC2080 reports TH on every 1 Hz sample, the FSM must keep cycling
+// ANOMALY -> DATA_READ -> COMMS and sending readings instead of sitting in
+// ANOMALY
+static fsm_state_stats held_read, held_comms, held_anomaly;
+
+static void held_snapshot(void *ctx){
+
+	(void)ctx;
+
+	held_read = get_fsm_stats(DATA_READ);
+	held_comms = get_fsm_stats(COMMS);
+	held_anomaly = get_fsm_stats(ANOMALY);
+}
+
+static uint32_t check_held_threshold(void){
+
+	host_reset();
+
+	hdc2080_model_init(&hdc2080, INT_HDC2080_PIN);
+	adxl343_model_init(&adxl343, GPIO_PIN_5, GPIO_PIN_6);
+	host_profile_storage_room(&hdc2080, &adxl343);
+	hdc2080.temperature.offset = TEMP_HIGH_ALERT_VAL + 10;
+
+	hdc2080_model_attach(&hdc2080, HDC2080_ADDR);
+	adxl343_model_attach(&adxl343, ADXL343_ADDR);
+
+	host_schedule(BENCH_HELD_SETTLE_US, held_snapshot, NULL);
+	host_run_until(firmware_main, BENCH_HELD_RUN_US);
+
+	uint32_t reads = get_fsm_stats(DATA_READ).entries - held_read.entries;
+	uint32_t comms = get_fsm_stats(COMMS).entries - held_comms.entries;
+	uint32_t anomalies = get_fsm_stats(ANOMALY).entries - held_anomaly.entries;
+	bool ok = reads >= BENCH_HELD_MIN_CYCLES && comms >= BENCH_HELD_MIN_CYCLES && anomalies >= BENCH_HELD_MIN_CYCLES;
+
+	printf("held threshold %llu min: %u DATA_READ, %u COMMS, %u ANOMALY entries  %s\r\n\r\n",
+			(BENCH_HELD_RUN_US - BENCH_HELD_SETTLE_US) / 60000000ULL, reads, comms, anomalies, ok ? "ok" : "FAIL");
+
+	return ok ? 0 : 1;
+}
+
+//----------------------------------------- RUNNER -----------------------------------------------------
+
+static uint64_t wall_ns(void){
+
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000U + (uint64_t)ts.tv_nsec;
+}
+
+static void run_bench(const char *name, bench_fn fn, uint32_t iterations){
+
+	uint64_t start_ns, start_us;
+
+	host_clear_stats();
+	start_us = host_now_us();
+	start_ns = wall_ns();
+
+	for(uint32_t i = 0; i < iterations; i++){
+		fn();
+	}
+
+	double n = iterations;
+	double host_ns = (double)(wall_ns() - start_ns) / n;
+	double target_us = (double)(host_now_us() - start_us) / n;
+
+	printf("%-22s %10.1f %12.1f %8.2f %8.1f %9.1f %9.1f %7.2f\r\n", name, host_ns, target_us,
+			host_counters.i2c_transactions / n, host_counters.i2c_bytes / n,
+			host_counters.i2c_busy_us / n, host_counters.uart_bytes / n,
+			host_counters.rtc_reads / n);
+}
+
+int main(int argc, char **argv){
+
+	uint32_t iterations = BENCH_DEFAULT_ITER;
+
+	if(argc > 1){
+		iterations = (uint32_t)strtoul(argv[1], NULL, 0);
+		if(iterations == 0){
+			iterations = BENCH_DEFAULT_ITER;
+		}
+	}
+
+	if(check_conversions() != 0 || check_soft_float() != 0 || check_series() != 0 || check_stats() != 0 || check_vibration() != 0){
+		return 1;
+	}
+
+	bench_setup();
+
+	if(check_irq_priorities() != 0){
+		return 1;
+	}
+
+	printf("%-22s %10s %12s %8s %8s %9s %9s %7s\r\n", "case", "host ns", "target us",
+			"i2c xfer", "i2c B", "i2c us", "uart B", "rtc rd");
+
+	run_bench("app_fsm()", bench_app_fsm, iterations);
+	run_bench("state_read_sensors()", bench_read_sensors, iterations);
+	run_bench("LOG_WRITE()+flush", bench_log_write, iterations);
+	run_bench("i2c job HDC+ADXL", bench_i2c_chain, iterations);
+	run_bench("get_temperature()", bench_get_temperature, iterations);
+	run_bench("get_humidity()", bench_get_humidity, iterations);
+	run_bench("get_accel()", bench_get_accel, iterations);
+	run_bench("convert float ref", bench_convert_float, iterations);
+	run_bench("convert soft float", bench_convert_soft, iterations);
+	run_bench("convert fixed", bench_convert_fixed, iterations);
+	printf("\r\n");
+
+	// Last: runs the whole firmware from main(), the cases above want bench_setup() alone
+	return check_held_threshold() != 0 ? 1 : 0;
+}
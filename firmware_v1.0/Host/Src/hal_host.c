@@ -0,0 +1,1354 @@
+/*
+ * hal_host.c
+ *
+ *  Host implementation of the HAL calls used by the firmware. Every blocking
+ *  call advances a virtual microsecond clock by the time the real peripheral
+ *  would take, so HAL_Delay() returns instantly while HAL_GetTick() and the
+ *  RTC still see time pass.
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: dst2001055
+ */
+
+#include <setjmp.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include "hal_host.h"
+
+I2C_TypeDef   host_I2C1    = {"I2C1"};
+USART_TypeDef host_LPUART1 = {"LPUART1"};
+USART_TypeDef host_USART2  = {"USART2"};
+RTC_TypeDef   host_RTC     = {"RTC"};
+TIM_TypeDef   host_TIM21   = {"TIM21"};
+
+DMA_Channel_TypeDef host_DMA1_Channel2 = {"DMA1_Channel2"};
+DMA_Channel_TypeDef host_DMA1_Channel4 = {"DMA1_Channel4"};
+
+GPIO_TypeDef host_GPIO[3];
+
+host_stats host_counters;
+
+__IO uint32_t uwTick;
+
+typedef struct{
+	uint64_t at_us;
+	host_event_fn fn;
+	void *ctx;
+	bool used;
+}host_event;
+
+typedef struct{
+	TIM_HandleTypeDef *htim;
+	bool running;
+}host_timer;
+
+enum host_i2c_kind{
+	HOST_I2C_TX,
+	HOST_I2C_RX,
+	HOST_I2C_MEM_TX,
+	HOST_I2C_MEM_RX
+};
+
+typedef struct{
+	I2C_HandleTypeDef *hi2c;
+	host_i2c_device *dev;		// NULL -> address NACK
+	uint8_t kind;
+	uint8_t reg;
+	uint8_t *pData;
+	uint16_t size;
+}host_i2c_xfer;
+
+typedef struct{
+	UART_HandleTypeDef *huart;
+	host_uart_sink sink;
+	void *ctx;
+}host_uart;
+
+static uint64_t now_us;
+static bool in_isr;
+static uint32_t primask;
+static host_advance_hook advance_hook;
+static host_bus_hook bus_hook;
+
+static jmp_buf run_env;
+static bool run_active;
+static uint64_t run_until_us;
+
+static host_event events[HOST_MAX_EVENTS];
+static uint8_t event_top;		// slots at and above it are all free
+static uint64_t next_event_us = HOST_NO_EVENT;
+static uint8_t next_event_slot;	// lowest slot due at next_event_us
+static host_i2c_device i2c_devs[HOST_MAX_I2C_DEVS];
+static uint8_t i2c_dev_count;
+static host_timer timers[HOST_MAX_TIMERS];
+static host_uart uarts[HOST_MAX_UARTS];
+static int16_t nvic_priority[HOST_NVIC_IRQS];		// -1: never configured
+static host_i2c_xfer i2c_pending;
+
+// RTC is kept as seconds since 01/01/2000 at the moment it was last set
+static uint32_t rtc_base_s;
+static uint64_t rtc_base_us;
+static uint64_t rtc_wut_period_us;
+
+// SysTick stops while suspended, HAL_GetTick() only catches up through uwTick
+static bool tick_suspended;
+static uint64_t tick_suspend_us;
+static uint64_t tick_lost_us;
+
+static bool stop_wake;
+static uint16_t exti_pending;
+
+// Data EEPROM, mapped at DATA_EEPROM_BASE on first reset
+static volatile uint32_t *eeprom;
+static bool eeprom_unlocked;
+static uint32_t eeprom_cycles[HOST_EEPROM_WORDS];	// erase/program cycles per word, never cleared by stats
+
+static void eeprom_map(void);
+
+//----------------------------------------- CLOCK ------------------------------------------------------
+
+void host_reset(void){
+
+	now_us = 0;
+	in_isr = false;
+	primask = 0;
+	advance_hook = NULL;
+	bus_hook = NULL;
+	run_active = false;
+	next_event_us = HOST_NO_EVENT;
+	next_event_slot = 0;
+	i2c_dev_count = 0;
+	rtc_base_s = 0;
+	rtc_base_us = 0;
+	rtc_wut_period_us = 0;
+	tick_suspended = false;
+	tick_suspend_us = 0;
+	tick_lost_us = 0;
+	uwTick = 0;
+	stop_wake = false;
+	exti_pending = 0;
+
+	memset(events, 0, sizeof(events));
+	event_top = 0;
+	memset(i2c_devs, 0, sizeof(i2c_devs));
+	memset(timers, 0, sizeof(timers));
+	memset(uarts, 0, sizeof(uarts));
+	memset(&i2c_pending, 0, sizeof(i2c_pending));
+	memset(nvic_priority, 0xFF, sizeof(nvic_priority));
+	memset(host_GPIO, 0, sizeof(host_GPIO));
+
+	// A fresh part: erased EEPROM reads 0
+	eeprom_map();
+	memset((void *)eeprom, 0, HOST_EEPROM_WORDS * 4);
+	memset(eeprom_cycles, 0, sizeof(eeprom_cycles));
+	eeprom_unlocked = false;
+
+	host_clear_stats();
+}
+
+uint64_t host_now_us(void){
+	return now_us;
+}
+
+static void refresh_next_event(void){
+
+	next_event_us = HOST_NO_EVENT;
+
+	while(event_top > 0 && !events[event_top - 1].used){
+		event_top--;
+	}
+
+	for(uint8_t i = 0; i < event_top; i++){
+		if(events[i].used && events[i].at_us < next_event_us){
+			next_event_us = events[i].at_us;
+			next_event_slot = i;
+		}
+	}
+}
+
+// Events fire in time order as "interrupts". An event raised while another
+// one runs stays pending until thread context advances the clock again,
+// like two IRQs sharing the same NVIC priority.
+static void advance(uint64_t us, uint8_t kind){
+
+	uint64_t target = now_us + us;
+	bool stop = false;
+
+	if(run_active && !in_isr && target >= run_until_us){
+		target = run_until_us;
+		stop = true;
+	}
+
+	if(advance_hook != NULL && target > now_us){
+		advance_hook(target - now_us, kind);
+	}
+
+	while(!in_isr && next_event_us <= target){
+		host_event *next = &events[next_event_slot];
+		host_event fired = *next;
+		next->used = false;
+		refresh_next_event();
+
+		if(fired.at_us > now_us){
+			now_us = fired.at_us;
+		}
+
+		in_isr = true;
+		host_counters.events_fired++;
+		fired.fn(fired.ctx);
+		in_isr = false;
+	}
+
+	if(target > now_us){
+		now_us = target;
+	}
+
+	if(stop){
+		run_active = false;
+		longjmp(run_env, 1);
+	}
+}
+
+void host_advance_us(uint64_t us){
+	advance(us, HOST_TIME_OTHER);
+}
+
+void host_set_advance_hook(host_advance_hook hook){
+	advance_hook = hook;
+}
+
+void host_set_bus_hook(host_bus_hook hook){
+	bus_hook = hook;
+}
+
+// Run a never-returning entry point (firmware_main) until the virtual clock
+// reaches until_us. Returns true if the horizon was reached.
+bool host_run_until(int (*entry)(void), uint64_t until_us){
+
+	if(setjmp(run_env) != 0){
+		return true;
+	}
+
+	run_until_us = until_us;
+	run_active = true;
+	entry();
+	run_active = false;
+
+	return false;
+}
+
+//----------------------------------------- EVENTS -----------------------------------------------------
+
+uint8_t host_schedule(uint64_t at_us, host_event_fn fn, void *ctx){
+
+	for(uint8_t i = 0; i < HOST_MAX_EVENTS; i++){
+		if(!events[i].used){
+			events[i].at_us = at_us;
+			events[i].fn = fn;
+			events[i].ctx = ctx;
+			events[i].used = true;
+			if(i >= event_top){
+				event_top = i + 1;
+			}
+			if(at_us < next_event_us || (at_us == next_event_us && i < next_event_slot)){
+				next_event_us = at_us;
+				next_event_slot = i;
+			}
+			return 0;
+		}
+	}
+	return 1;
+}
+
+void host_cancel(host_event_fn fn, void *ctx){
+
+	bool next_removed = false;
+
+	for(uint8_t i = 0; i < event_top; i++){
+		if(events[i].used && events[i].fn == fn && events[i].ctx == ctx){
+			events[i].used = false;
+			next_removed |= (i == next_event_slot);
+		}
+	}
+
+	// Any other event leaves the earliest one where it is
+	if(next_removed){
+		refresh_next_event();
+	}
+}
+
+uint64_t host_next_event_us(void){
+	return next_event_us;
+}
+
+//----------------------------------------- STATS ------------------------------------------------------
+
+void host_clear_stats(void){
+	memset(&host_counters, 0, sizeof(host_counters));
+}
+
+//----------------------------------------- CORTEX / SYSTEM --------------------------------------------
+
+// Kept for the bench only: events model one shared priority either way
+void HAL_NVIC_SetPriority(IRQn_Type IRQn, uint32_t PreemptPriority, uint32_t SubPriority){
+	UNUSED(SubPriority);
+	if((uint32_t)IRQn < HOST_NVIC_IRQS){
+		nvic_priority[IRQn] = (int16_t)PreemptPriority;
+	}
+}
+
+int16_t host_nvic_priority(IRQn_Type IRQn){
+	return ((uint32_t)IRQn < HOST_NVIC_IRQS) ? nvic_priority[IRQn] : -1;
+}
+
+void HAL_NVIC_EnableIRQ(IRQn_Type IRQn){
+	UNUSED(IRQn);
+}
+
+void HAL_NVIC_DisableIRQ(IRQn_Type IRQn){
+	UNUSED(IRQn);
+}
+
+// Interrupts are host events, which only fire while the clock advances, so
+// PRIMASK only matters to EXTI lines raised meanwhile (a wake-up from STOP
+// with PRIMASK set): their handlers run once it is cleared
+static void exti_flush(void){
+
+	while(exti_pending != 0 && primask == 0 && !in_isr){
+		uint16_t pin = exti_pending & (uint16_t)-exti_pending;
+
+		exti_pending &= (uint16_t)~pin;
+		host_gpio_exti(pin);
+	}
+}
+
+void __disable_irq(void){
+	primask = 1;
+}
+
+void __enable_irq(void){
+	primask = 0;
+	exti_flush();
+}
+
+uint32_t __get_PRIMASK(void){
+	return primask;
+}
+
+void __set_PRIMASK(uint32_t priMask){
+	primask = priMask;
+	exti_flush();
+}
+
+// Handler mode while a host event (interrupt) runs. 15 = SysTick, the exact
+// exception number doesn't matter to the firmware
+uint32_t __get_IPSR(void){
+	return in_isr ? 15U : 0U;
+}
+
+// get_tick_us() reads it three times in a row, at the same instant
+SysTick_Type *host_systick(void){
+
+	static SysTick_Type systick;
+	static uint64_t systick_us = HOST_NO_EVENT;
+
+	if(now_us - tick_lost_us != systick_us){
+		systick_us = now_us - tick_lost_us;
+		systick.LOAD = HOST_SYSCLK_HZ / 1000U - 1U;
+		systick.VAL = systick.LOAD - (uint32_t)((systick_us % 1000U) * (systick.LOAD + 1U) / 1000U);
+	}
+
+	return &systick;
+}
+
+SCB_Type *host_scb(void){
+
+	static SCB_Type scb;
+
+	scb.ICSR = 0;
+
+	return &scb;
+}
+
+// Sleep until the next interrupt: a pending event or the next SysTick
+void __WFI(void){
+
+	uint64_t wake_us = ((now_us - tick_lost_us) / 1000U + 1U) * 1000U + tick_lost_us;
+
+	// Nothing left to wake the core without SysTick
+	if(tick_suspended){
+		if(next_event_us == HOST_NO_EVENT){
+			return;
+		}
+		wake_us = next_event_us > now_us ? next_event_us : now_us;
+	}
+
+	if(next_event_us > now_us && next_event_us < wake_us){
+		wake_us = next_event_us;
+	}
+
+	host_counters.sleep_us += wake_us - now_us;
+	advance(wake_us - now_us, HOST_TIME_SLEEP);
+}
+
+HAL_StatusTypeDef HAL_Init(void){
+	return HAL_OK;
+}
+
+void HAL_IncTick(void){
+	host_advance_us(1000);
+}
+
+void HAL_Delay(uint32_t Delay){
+	host_counters.delay_us += (uint64_t)Delay * 1000;
+	advance((uint64_t)Delay * 1000, HOST_TIME_DELAY);
+}
+
+uint32_t HAL_GetTick(void){
+
+	uint64_t tick_us = (tick_suspended ? tick_suspend_us : now_us) - tick_lost_us;
+
+	return (uint32_t)(tick_us / 1000) + uwTick;
+}
+
+void HAL_SuspendTick(void){
+
+	if(!tick_suspended){
+		tick_suspended = true;
+		tick_suspend_us = now_us;
+	}
+}
+
+void HAL_ResumeTick(void){
+
+	if(tick_suspended){
+		tick_suspended = false;
+		tick_lost_us += now_us - tick_suspend_us;
+	}
+}
+
+HAL_StatusTypeDef HAL_RCC_OscConfig(RCC_OscInitTypeDef *RCC_OscInitStruct){
+	UNUSED(RCC_OscInitStruct);
+	return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_RCC_ClockConfig(RCC_ClkInitTypeDef *RCC_ClkInitStruct, uint32_t FLatency){
+	UNUSED(RCC_ClkInitStruct);
+	UNUSED(FLatency);
+	return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_RCCEx_PeriphCLKConfig(RCC_PeriphCLKInitTypeDef *PeriphClkInit){
+	UNUSED(PeriphClkInit);
+	return HAL_OK;
+}
+
+void HAL_PWR_EnableBkUpAccess(void){
+}
+
+// STOP: no SysTick and no peripheral clocks, only an EXTI line or the RTC
+// wake-up timer end it. Events that raise neither (sensor model ticks) run
+// without waking the core. Like WFI, a wake-up also ends it with PRIMASK set
+void HAL_PWR_EnterSTOPMode(uint32_t Regulator, uint8_t STOPEntry){
+
+	uint64_t start_us = now_us;
+
+	UNUSED(Regulator);
+	UNUSED(STOPEntry);
+
+	host_counters.stop_entries++;
+	stop_wake = false;
+
+	while(!stop_wake && next_event_us != HOST_NO_EVENT){
+		advance(next_event_us > now_us ? next_event_us - now_us : 0, HOST_TIME_STOP);
+	}
+
+	host_counters.stop_us += now_us - start_us;
+}
+
+//----------------------------------------- DATA EEPROM ------------------------------------------------
+
+static void eeprom_map(void){
+
+	if(eeprom != NULL){
+		return;
+	}
+
+	void *map = mmap((void *)(uintptr_t)DATA_EEPROM_BASE, HOST_EEPROM_WORDS * 4, PROT_READ | PROT_WRITE,
+			MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED_NOREPLACE, -1, 0);
+
+	if(map != (void *)(uintptr_t)DATA_EEPROM_BASE){
+		fprintf(stderr, "hal_host: cannot map the data EEPROM at 0x%08lX\n", DATA_EEPROM_BASE);
+		exit(1);
+	}
+	eeprom = map;
+}
+
+uint32_t host_eeprom_cycles(uint16_t word){
+	return word < HOST_EEPROM_WORDS ? eeprom_cycles[word] : 0;
+}
+
+HAL_StatusTypeDef HAL_FLASHEx_DATAEEPROM_Unlock(void){
+	eeprom_unlocked = true;
+	return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_FLASHEx_DATAEEPROM_Lock(void){
+	eeprom_unlocked = false;
+	return HAL_OK;
+}
+
+// Erase and program both cost one cycle of the word and stall the CPU for tprog
+static HAL_StatusTypeDef eeprom_store(uint32_t Address, uint32_t mask, uint32_t Data){
+
+	uint32_t offset = Address - DATA_EEPROM_BASE;
+
+	if(!eeprom_unlocked || Address < DATA_EEPROM_BASE || Address > DATA_EEPROM_END){
+		return HAL_ERROR;
+	}
+
+	uint16_t word = offset / 4;
+	uint8_t shift = (offset % 4) * 8;
+
+	eeprom[word] = (eeprom[word] & ~(mask << shift)) | ((Data & mask) << shift);
+	eeprom_cycles[word]++;
+
+	advance(HOST_EEPROM_PROG_US, HOST_TIME_OTHER);
+	return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_FLASHEx_DATAEEPROM_Erase(uint32_t Address){
+
+	if(Address % 4 != 0){
+		return HAL_ERROR;
+	}
+	host_counters.eeprom_erases++;
+	return eeprom_store(Address, 0xFFFFFFFFU, 0);
+}
+
+HAL_StatusTypeDef HAL_FLASHEx_DATAEEPROM_Program(uint32_t TypeProgram, uint32_t Address, uint32_t Data){
+
+	uint32_t mask;
+
+	switch(TypeProgram){
+		case FLASH_TYPEPROGRAMDATA_BYTE:
+			mask = 0xFFU;
+			break;
+		case FLASH_TYPEPROGRAMDATA_HALFWORD:
+			mask = 0xFFFFU;
+			break;
+		default:
+			mask = 0xFFFFFFFFU;
+			break;
+	}
+
+	// Unaligned accesses fault on the target
+	if(Address % ((mask == 0xFFU) ? 1 : (mask == 0xFFFFU) ? 2 : 4) != 0){
+		return HAL_ERROR;
+	}
+	host_counters.eeprom_programs++;
+	return eeprom_store(Address, mask, Data);
+}
+
+//----------------------------------------- GPIO -------------------------------------------------------
+
+void HAL_GPIO_Init(GPIO_TypeDef *GPIOx, GPIO_InitTypeDef *GPIO_Init){
+	UNUSED(GPIOx);
+	UNUSED(GPIO_Init);
+}
+
+void HAL_GPIO_DeInit(GPIO_TypeDef *GPIOx, uint32_t GPIO_Pin){
+	UNUSED(GPIOx);
+	UNUSED(GPIO_Pin);
+}
+
+GPIO_PinState HAL_GPIO_ReadPin(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin){
+	return (GPIOx->IDR & GPIO_Pin) ? GPIO_PIN_SET : GPIO_PIN_RESET;
+}
+
+void HAL_GPIO_WritePin(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin, GPIO_PinState PinState){
+	if(PinState == GPIO_PIN_SET){
+		GPIOx->ODR |= GPIO_Pin;
+	} else {
+		GPIOx->ODR &= ~(uint32_t)GPIO_Pin;
+	}
+}
+
+void HAL_GPIO_TogglePin(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin){
+	GPIOx->ODR ^= GPIO_Pin;
+}
+
+void HAL_GPIO_EXTI_IRQHandler(uint16_t GPIO_Pin){
+	HAL_GPIO_EXTI_Callback(GPIO_Pin);
+}
+
+// Raise an EXTI line from the host side, run as an interrupt
+void host_gpio_exti(uint16_t pin){
+
+	bool nested = in_isr;
+
+	stop_wake = true;
+
+	if(primask != 0){
+		exti_pending |= pin;
+		return;
+	}
+
+	in_isr = true;
+	HAL_GPIO_EXTI_IRQHandler(pin);
+	in_isr = nested;
+}
+
+//----------------------------------------- I2C --------------------------------------------------------
+
+uint8_t host_i2c_attach(const host_i2c_device *dev){
+
+	for(uint8_t i = 0; i < i2c_dev_count; i++){
+		if(i2c_devs[i].addr == dev->addr){
+			i2c_devs[i] = *dev;
+			return 0;
+		}
+	}
+
+	if(i2c_dev_count >= HOST_MAX_I2C_DEVS){
+		return 1;
+	}
+
+	i2c_devs[i2c_dev_count++] = *dev;
+	return 0;
+}
+
+static host_i2c_device *find_i2c_dev(uint16_t addr){
+
+	for(uint8_t i = 0; i < i2c_dev_count; i++){
+		if(i2c_devs[i].addr == addr){
+			return &i2c_devs[i];
+		}
+	}
+	return NULL;
+}
+
+static bool i2c_acked(const host_i2c_xfer *xfer){
+
+	if(xfer->dev == NULL){
+		return false;
+	}
+
+	switch(xfer->kind){
+		case HOST_I2C_RX:
+			return xfer->dev->read != NULL;
+		case HOST_I2C_MEM_RX:
+			return xfer->dev->read != NULL && xfer->dev->write != NULL;
+		default:
+			return xfer->dev->write != NULL;
+	}
+}
+
+// START + address byte + data bytes (9 clocks each incl. ACK) + STOP.
+// Register accesses add the register byte, a register read also a repeated
+// START and the address byte again. A NACK ends after the address byte
+static uint64_t i2c_bus_us(const host_i2c_xfer *xfer, bool ack){
+
+	uint64_t bits = 9 + 2;
+	uint16_t bytes = 0;
+
+	if(ack){
+		bytes = xfer->size;
+		if(xfer->kind == HOST_I2C_MEM_TX || xfer->kind == HOST_I2C_MEM_RX){
+			bytes++;
+		}
+		bits += (uint64_t)bytes * 9;
+
+		if(xfer->kind == HOST_I2C_MEM_RX){
+			bits += 1 + 9;
+			host_counters.i2c_repeated_starts++;
+		}
+	}
+
+	uint64_t us = (bits * HOST_I2C_BIT_NS + 999) / 1000;
+
+	host_counters.i2c_transactions++;
+	host_counters.i2c_bytes += bytes;
+	host_counters.i2c_busy_us += us;
+
+	return us;
+}
+
+// What the device sees once the transaction is on the wire
+static HAL_StatusTypeDef i2c_device_op(const host_i2c_xfer *xfer){
+
+	host_i2c_device *dev = xfer->dev;
+	uint8_t burst[1 + HOST_I2C_MAX_BURST];
+	HAL_StatusTypeDef status;
+
+	switch(xfer->kind){
+		case HOST_I2C_TX:
+			return dev->write(dev->ctx, xfer->pData, xfer->size);
+
+		case HOST_I2C_RX:
+			return dev->read(dev->ctx, xfer->pData, xfer->size);
+
+		case HOST_I2C_MEM_TX:
+			if(xfer->size > HOST_I2C_MAX_BURST){
+				return HAL_ERROR;
+			}
+			burst[0] = xfer->reg;
+			memcpy(&burst[1], xfer->pData, xfer->size);
+			return dev->write(dev->ctx, burst, xfer->size + 1);
+
+		case HOST_I2C_MEM_RX:
+			status = dev->write(dev->ctx, &xfer->reg, 1);
+			if(status != HAL_OK){
+				return status;
+			}
+			return dev->read(dev->ctx, xfer->pData, xfer->size);
+
+		default:
+			return HAL_ERROR;
+	}
+}
+
+static void i2c_it_done(void *ctx){
+
+	host_i2c_xfer *xfer = (host_i2c_xfer *)ctx;
+	I2C_HandleTypeDef *hi2c = xfer->hi2c;
+	HAL_StatusTypeDef status = HAL_ERROR;
+
+	if(xfer->dev != NULL){
+		status = i2c_device_op(xfer);
+	}
+
+	hi2c->State = HAL_I2C_STATE_READY;
+
+	if(status != HAL_OK){
+		HAL_I2C_ErrorCallback(hi2c);
+		return;
+	}
+
+	switch(xfer->kind){
+		case HOST_I2C_TX:
+			HAL_I2C_MasterTxCpltCallback(hi2c);
+			break;
+		case HOST_I2C_RX:
+			HAL_I2C_MasterRxCpltCallback(hi2c);
+			break;
+		case HOST_I2C_MEM_TX:
+			HAL_I2C_MemTxCpltCallback(hi2c);
+			break;
+		case HOST_I2C_MEM_RX:
+			HAL_I2C_MemRxCpltCallback(hi2c);
+			break;
+	}
+}
+
+HAL_StatusTypeDef HAL_I2C_Init(I2C_HandleTypeDef *hi2c){
+
+	if(hi2c->State == HAL_I2C_STATE_RESET){
+		HAL_I2C_MspInit(hi2c);
+	}
+	hi2c->State = HAL_I2C_STATE_READY;
+
+	return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_I2C_DeInit(I2C_HandleTypeDef *hi2c){
+
+	// Drops a transfer in flight, its completion interrupt never comes
+	host_cancel(i2c_it_done, &i2c_pending);
+	HAL_I2C_MspDeInit(hi2c);
+	hi2c->State = HAL_I2C_STATE_RESET;
+
+	return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_I2CEx_ConfigAnalogFilter(I2C_HandleTypeDef *hi2c, uint32_t AnalogFilter){
+	UNUSED(hi2c);
+	UNUSED(AnalogFilter);
+	return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_I2CEx_ConfigDigitalFilter(I2C_HandleTypeDef *hi2c, uint32_t DigitalFilter){
+	UNUSED(hi2c);
+	UNUSED(DigitalFilter);
+	return HAL_OK;
+}
+
+// Polled transfer: the CPU spins for the whole transaction
+static HAL_StatusTypeDef i2c_polled(I2C_HandleTypeDef *hi2c, uint16_t DevAddress, uint8_t kind, uint8_t reg, uint8_t *pData, uint16_t Size){
+
+	host_i2c_xfer xfer = {hi2c, find_i2c_dev(DevAddress), kind, reg, pData, Size};
+
+	if(hi2c->State != HAL_I2C_STATE_READY){
+		return HAL_BUSY;
+	}
+
+	bool ack = i2c_acked(&xfer);
+
+	advance(i2c_bus_us(&xfer, ack), HOST_TIME_I2C);
+
+	if(!ack){
+		host_counters.i2c_nacks++;
+		return HAL_ERROR;
+	}
+
+	return i2c_device_op(&xfer);
+}
+
+HAL_StatusTypeDef HAL_I2C_Master_Transmit(I2C_HandleTypeDef *hi2c, uint16_t DevAddress, uint8_t *pData, uint16_t Size, uint32_t Timeout){
+	UNUSED(Timeout);
+	return i2c_polled(hi2c, DevAddress, HOST_I2C_TX, 0, pData, Size);
+}
+
+HAL_StatusTypeDef HAL_I2C_Master_Receive(I2C_HandleTypeDef *hi2c, uint16_t DevAddress, uint8_t *pData, uint16_t Size, uint32_t Timeout){
+	UNUSED(Timeout);
+	return i2c_polled(hi2c, DevAddress, HOST_I2C_RX, 0, pData, Size);
+}
+
+HAL_StatusTypeDef HAL_I2C_Mem_Write(I2C_HandleTypeDef *hi2c, uint16_t DevAddress, uint16_t MemAddress, uint16_t MemAddSize, uint8_t *pData, uint16_t Size, uint32_t Timeout){
+	UNUSED(MemAddSize);
+	UNUSED(Timeout);
+	return i2c_polled(hi2c, DevAddress, HOST_I2C_MEM_TX, (uint8_t)MemAddress, pData, Size);
+}
+
+HAL_StatusTypeDef HAL_I2C_Mem_Read(I2C_HandleTypeDef *hi2c, uint16_t DevAddress, uint16_t MemAddress, uint16_t MemAddSize, uint8_t *pData, uint16_t Size, uint32_t Timeout){
+	UNUSED(MemAddSize);
+	UNUSED(Timeout);
+	return i2c_polled(hi2c, DevAddress, HOST_I2C_MEM_RX, (uint8_t)MemAddress, pData, Size);
+}
+
+// Interrupt transfer: the bus runs on its own and the device sees the data
+// when the completion interrupt fires
+static HAL_StatusTypeDef i2c_start_it(I2C_HandleTypeDef *hi2c, uint16_t DevAddress, uint8_t kind, uint8_t reg, uint8_t *pData, uint16_t Size){
+
+	host_i2c_xfer xfer = {hi2c, find_i2c_dev(DevAddress), kind, reg, pData, Size};
+
+	if(hi2c->State != HAL_I2C_STATE_READY){
+		return HAL_BUSY;
+	}
+
+	bool ack = i2c_acked(&xfer);
+	uint64_t bus_us = i2c_bus_us(&xfer, ack);
+
+	if(host_schedule(now_us + bus_us, i2c_it_done, &i2c_pending) != 0){
+		return HAL_ERROR;
+	}
+
+	if(bus_hook != NULL){
+		bus_hook(bus_us, HOST_TIME_I2C);
+	}
+
+	if(!ack){
+		xfer.dev = NULL;
+		host_counters.i2c_nacks++;
+	}
+
+	i2c_pending = xfer;
+	hi2c->State = (kind == HOST_I2C_RX || kind == HOST_I2C_MEM_RX) ? HAL_I2C_STATE_BUSY_RX : HAL_I2C_STATE_BUSY_TX;
+
+	return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_I2C_Master_Transmit_IT(I2C_HandleTypeDef *hi2c, uint16_t DevAddress, uint8_t *pData, uint16_t Size){
+	return i2c_start_it(hi2c, DevAddress, HOST_I2C_TX, 0, pData, Size);
+}
+
+HAL_StatusTypeDef HAL_I2C_Master_Receive_IT(I2C_HandleTypeDef *hi2c, uint16_t DevAddress, uint8_t *pData, uint16_t Size){
+	return i2c_start_it(hi2c, DevAddress, HOST_I2C_RX, 0, pData, Size);
+}
+
+HAL_StatusTypeDef HAL_I2C_Mem_Write_IT(I2C_HandleTypeDef *hi2c, uint16_t DevAddress, uint16_t MemAddress, uint16_t MemAddSize, uint8_t *pData, uint16_t Size){
+	UNUSED(MemAddSize);
+	return i2c_start_it(hi2c, DevAddress, HOST_I2C_MEM_TX, (uint8_t)MemAddress, pData, Size);
+}
+
+HAL_StatusTypeDef HAL_I2C_Mem_Read_IT(I2C_HandleTypeDef *hi2c, uint16_t DevAddress, uint16_t MemAddress, uint16_t MemAddSize, uint8_t *pData, uint16_t Size){
+	UNUSED(MemAddSize);
+	return i2c_start_it(hi2c, DevAddress, HOST_I2C_MEM_RX, (uint8_t)MemAddress, pData, Size);
+}
+
+void HAL_I2C_EV_IRQHandler(I2C_HandleTypeDef *hi2c){
+	UNUSED(hi2c);
+}
+
+void HAL_I2C_ER_IRQHandler(I2C_HandleTypeDef *hi2c){
+	UNUSED(hi2c);
+}
+
+HAL_StatusTypeDef host_regfile_write(void *ctx, const uint8_t *pData, uint16_t size){
+
+	host_regfile *rf = (host_regfile *)ctx;
+
+	if(size == 0){
+		return HAL_OK;
+	}
+
+	rf->pointer = pData[0] % HOST_REGFILE_SIZE;
+
+	for(uint16_t i = 1; i < size; i++){
+		rf->regs[rf->pointer] = pData[i];
+		rf->pointer = (rf->pointer + 1) % HOST_REGFILE_SIZE;
+	}
+	return HAL_OK;
+}
+
+HAL_StatusTypeDef host_regfile_read(void *ctx, uint8_t *pData, uint16_t size){
+
+	host_regfile *rf = (host_regfile *)ctx;
+
+	for(uint16_t i = 0; i < size; i++){
+		pData[i] = rf->regs[rf->pointer];
+		rf->pointer = (rf->pointer + 1) % HOST_REGFILE_SIZE;
+	}
+	return HAL_OK;
+}
+
+//----------------------------------------- UART -------------------------------------------------------
+
+void host_uart_set_sink(UART_HandleTypeDef *huart, host_uart_sink sink, void *ctx){
+
+	for(uint8_t i = 0; i < HOST_MAX_UARTS; i++){
+		if(uarts[i].huart == huart || uarts[i].huart == NULL){
+			uarts[i].huart = huart;
+			uarts[i].sink = sink;
+			uarts[i].ctx = ctx;
+			return;
+		}
+	}
+}
+
+static host_uart *find_uart(UART_HandleTypeDef *huart){
+
+	for(uint8_t i = 0; i < HOST_MAX_UARTS; i++){
+		if(uarts[i].huart == huart){
+			return &uarts[i];
+		}
+	}
+	return NULL;
+}
+
+static uint64_t uart_time_us(UART_HandleTypeDef *huart, uint16_t size){
+
+	uint32_t baud = huart->Init.BaudRate ? huart->Init.BaudRate : 115200U;
+
+	return ((uint64_t)size * HOST_UART_FRAME_BITS * 1000000U + baud - 1) / baud;
+}
+
+HAL_StatusTypeDef HAL_UART_Init(UART_HandleTypeDef *huart){
+
+	HAL_UART_MspInit(huart);
+	huart->gState = HAL_UART_STATE_READY;
+
+	return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_UART_Transmit(UART_HandleTypeDef *huart, uint8_t *pData, uint16_t Size, uint32_t Timeout){
+
+	host_uart *port = find_uart(huart);
+	uint64_t us = uart_time_us(huart, Size);
+
+	UNUSED(Timeout);
+
+	if(port != NULL && port->sink != NULL){
+		port->sink(port->ctx, pData, Size);
+	}
+
+	host_counters.uart_writes++;
+	host_counters.uart_bytes += Size;
+	host_counters.uart_busy_us += us;
+
+	// Polled transmit: the CPU is held for every byte on the wire
+	advance(us, HOST_TIME_UART);
+
+	return HAL_OK;
+}
+
+static void uart_dma_done(void *ctx){
+
+	UART_HandleTypeDef *huart = (UART_HandleTypeDef *)ctx;
+
+	huart->gState = HAL_UART_STATE_READY;
+	HAL_UART_TxCpltCallback(huart);
+}
+
+// DMA transmit: the bytes reach the sink straight away, the completion
+// interrupt fires once the last stop bit would have left the pin
+HAL_StatusTypeDef HAL_UART_Transmit_DMA(UART_HandleTypeDef *huart, uint8_t *pData, uint16_t Size){
+
+	host_uart *port = find_uart(huart);
+	uint64_t us = uart_time_us(huart, Size);
+
+	if(huart->gState != HAL_UART_STATE_READY){
+		return HAL_BUSY;
+	}
+
+	if(pData == NULL || Size == 0){
+		return HAL_ERROR;
+	}
+
+	if(host_schedule(now_us + us, uart_dma_done, huart) != 0){
+		return HAL_ERROR;
+	}
+
+	huart->gState = HAL_UART_STATE_BUSY_TX;
+
+	if(bus_hook != NULL){
+		bus_hook(us, HOST_TIME_UART);
+	}
+
+	if(port != NULL && port->sink != NULL){
+		port->sink(port->ctx, pData, Size);
+	}
+
+	host_counters.uart_writes++;
+	host_counters.uart_dma_transfers++;
+	host_counters.uart_bytes += Size;
+	host_counters.uart_busy_us += us;
+
+	return HAL_OK;
+}
+
+void HAL_UART_IRQHandler(UART_HandleTypeDef *huart){
+	UNUSED(huart);
+}
+
+//----------------------------------------- DMA --------------------------------------------------------
+
+HAL_StatusTypeDef HAL_DMA_Init(DMA_HandleTypeDef *hdma){
+	UNUSED(hdma);
+	return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_DMA_DeInit(DMA_HandleTypeDef *hdma){
+	UNUSED(hdma);
+	return HAL_OK;
+}
+
+void HAL_DMA_IRQHandler(DMA_HandleTypeDef *hdma){
+	UNUSED(hdma);
+}
+
+//----------------------------------------- RTC --------------------------------------------------------
+
+static const uint8_t days_in_month[12] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+
+static uint8_t bcd_to_bin(uint8_t value){
+	return (uint8_t)((value >> 4) * 10 + (value & 0x0F));
+}
+
+static uint8_t bin_to_bcd(uint8_t value){
+	return (uint8_t)(((value / 10) << 4) | (value % 10));
+}
+
+static bool leap_year(uint8_t year){
+	return (year % 4) == 0;
+}
+
+static uint32_t rtc_now_s(void){
+	return rtc_base_s + (uint32_t)((now_us - rtc_base_us) / 1000000U);
+}
+
+static uint32_t rtc_subsecond_us(void){
+	return (uint32_t)((now_us - rtc_base_us) % 1000000U);
+}
+
+static void rtc_split(uint32_t secs, RTC_TimeTypeDef *sTime, RTC_DateTypeDef *sDate){
+
+	// The calendar walk only changes once a day; long simulations read the
+	// RTC millions of times, so keep the last day's result, and the last
+	// second's: GetTime() and GetDate() come in pairs
+	static uint32_t cached_day = UINT32_MAX;
+	static uint8_t cached_year, cached_month, cached_date;
+	static uint32_t cached_secs = UINT32_MAX;
+	static uint8_t cached_hours, cached_minutes, cached_seconds;
+
+	uint32_t days = secs / 86400U;
+
+	if(secs != cached_secs){
+		uint32_t tod = secs % 86400U;
+
+		cached_secs = secs;
+		cached_hours = (uint8_t)(tod / 3600U);
+		cached_minutes = (uint8_t)((tod / 60U) % 60U);
+		cached_seconds = (uint8_t)(tod % 60U);
+	}
+
+	if(days != cached_day){
+		uint32_t left = days;
+		uint8_t year = 0;
+		uint8_t month = 0;
+
+		while(left >= (leap_year(year) ? 366U : 365U)){
+			left -= leap_year(year) ? 366U : 365U;
+			year++;
+		}
+
+		for(;;){
+			uint8_t dim = days_in_month[month] + ((month == 1 && leap_year(year)) ? 1 : 0);
+			if(left < dim){
+				break;
+			}
+			left -= dim;
+			month++;
+		}
+
+		cached_day = days;
+		cached_year = year;
+		cached_month = month;
+		cached_date = (uint8_t)left;
+	}
+
+	if(sTime != NULL){
+		sTime->Hours = cached_hours;
+		sTime->Minutes = cached_minutes;
+		sTime->Seconds = cached_seconds;
+	}
+
+	if(sDate != NULL){
+		sDate->Year = cached_year;
+		sDate->Month = cached_month + 1;
+		sDate->Date = cached_date + 1;
+		// 01/01/2000 was a Saturday, RTC_WEEKDAY_MONDAY = 1
+		sDate->WeekDay = (uint8_t)((days + 5) % 7 + 1);
+	}
+}
+
+static uint32_t rtc_join(const RTC_TimeTypeDef *sTime, const RTC_DateTypeDef *sDate){
+
+	uint32_t days = 0;
+
+	for(uint8_t y = 0; y < sDate->Year; y++){
+		days += leap_year(y) ? 366U : 365U;
+	}
+
+	for(uint8_t m = 0; m + 1 < sDate->Month && m < 12; m++){
+		days += days_in_month[m] + ((m == 1 && leap_year(sDate->Year)) ? 1 : 0);
+	}
+
+	days += sDate->Date ? sDate->Date - 1U : 0U;
+
+	return days * 86400U + sTime->Hours * 3600U + sTime->Minutes * 60U + sTime->Seconds;
+}
+
+static void rtc_rebase(uint32_t secs){
+	rtc_base_s = secs;
+	rtc_base_us = now_us;
+}
+
+HAL_StatusTypeDef HAL_RTC_Init(RTC_HandleTypeDef *hrtc){
+	HAL_RTC_MspInit(hrtc);
+	return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_RTC_SetTime(RTC_HandleTypeDef *hrtc, RTC_TimeTypeDef *sTime, uint32_t Format){
+
+	RTC_TimeTypeDef time = *sTime;
+	RTC_DateTypeDef date;
+
+	UNUSED(hrtc);
+
+	if(Format == RTC_FORMAT_BCD){
+		time.Hours = bcd_to_bin(time.Hours);
+		time.Minutes = bcd_to_bin(time.Minutes);
+		time.Seconds = bcd_to_bin(time.Seconds);
+	}
+
+	if(time.Hours > 23 || time.Minutes > 59 || time.Seconds > 59){
+		return HAL_ERROR;
+	}
+
+	rtc_split(rtc_now_s(), NULL, &date);
+	rtc_rebase(rtc_join(&time, &date));
+
+	return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_RTC_SetDate(RTC_HandleTypeDef *hrtc, RTC_DateTypeDef *sDate, uint32_t Format){
+
+	RTC_TimeTypeDef time;
+	RTC_DateTypeDef date = *sDate;
+
+	UNUSED(hrtc);
+
+	if(Format == RTC_FORMAT_BCD){
+		date.Year = bcd_to_bin(date.Year);
+		date.Month = bcd_to_bin(date.Month);
+		date.Date = bcd_to_bin(date.Date);
+	}
+
+	if(date.Month < 1 || date.Month > 12 || date.Date < 1 || date.Date > 31 || date.Year > 99){
+		return HAL_ERROR;
+	}
+
+	rtc_split(rtc_now_s(), &time, NULL);
+	rtc_rebase(rtc_join(&time, &date));
+
+	return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_RTC_GetTime(RTC_HandleTypeDef *hrtc, RTC_TimeTypeDef *sTime, uint32_t Format){
+
+	uint32_t prediv = hrtc->Init.SynchPrediv;
+
+	host_counters.rtc_reads++;
+
+	rtc_split(rtc_now_s(), sTime, NULL);
+
+	// SSR counts down from PREDIV_S over one second
+	sTime->SecondFraction = prediv;
+	sTime->SubSeconds = prediv - (uint32_t)(((uint64_t)rtc_subsecond_us() * (prediv + 1)) / 1000000U);
+
+	if(Format == RTC_FORMAT_BCD){
+		sTime->Hours = bin_to_bcd(sTime->Hours);
+		sTime->Minutes = bin_to_bcd(sTime->Minutes);
+		sTime->Seconds = bin_to_bcd(sTime->Seconds);
+	}
+
+	return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_RTC_GetDate(RTC_HandleTypeDef *hrtc, RTC_DateTypeDef *sDate, uint32_t Format){
+
+	UNUSED(hrtc);
+
+	host_counters.rtc_reads++;
+
+	rtc_split(rtc_now_s(), NULL, sDate);
+
+	if(Format == RTC_FORMAT_BCD){
+		sDate->Year = bin_to_bcd(sDate->Year);
+		sDate->Month = bin_to_bcd(sDate->Month);
+		sDate->Date = bin_to_bcd(sDate->Date);
+	}
+
+	return HAL_OK;
+}
+
+// Periodic like the real auto-reload, until deactivated
+static void rtc_wakeup_event(void *ctx){
+
+	UNUSED(ctx);
+
+	host_counters.rtc_wakeups++;
+	stop_wake = true;
+	host_schedule(now_us + rtc_wut_period_us, rtc_wakeup_event, NULL);
+}
+
+HAL_StatusTypeDef HAL_RTC_WaitForSynchro(RTC_HandleTypeDef *hrtc){
+	UNUSED(hrtc);
+	return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_RTCEx_SetWakeUpTimer_IT(RTC_HandleTypeDef *hrtc, uint32_t WakeUpCounter, uint32_t WakeUpClock){
+
+	UNUSED(hrtc);
+	UNUSED(WakeUpClock);
+
+	if(WakeUpCounter > 0xFFFF){
+		return HAL_ERROR;
+	}
+
+	host_cancel(rtc_wakeup_event, NULL);
+	rtc_wut_period_us = ((uint64_t)(WakeUpCounter + 1) * 1000000U + HOST_RTC_WUT_HZ / 2) / HOST_RTC_WUT_HZ;
+	host_schedule(now_us + rtc_wut_period_us, rtc_wakeup_event, NULL);
+
+	return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_RTCEx_DeactivateWakeUpTimer(RTC_HandleTypeDef *hrtc){
+	UNUSED(hrtc);
+	host_cancel(rtc_wakeup_event, NULL);
+	return HAL_OK;
+}
+
+void HAL_RTCEx_WakeUpTimerIRQHandler(RTC_HandleTypeDef *hrtc){
+	UNUSED(hrtc);
+}
+
+//----------------------------------------- TIM --------------------------------------------------------
+
+static host_timer *find_timer(TIM_HandleTypeDef *htim, bool create){
+
+	for(uint8_t i = 0; i < HOST_MAX_TIMERS; i++){
+		if(timers[i].htim == htim){
+			return &timers[i];
+		}
+	}
+
+	if(!create){
+		return NULL;
+	}
+
+	for(uint8_t i = 0; i < HOST_MAX_TIMERS; i++){
+		if(timers[i].htim == NULL){
+			timers[i].htim = htim;
+			return &timers[i];
+		}
+	}
+	return NULL;
+}
+
+static uint64_t timer_period_us(TIM_HandleTypeDef *htim){
+
+	uint64_t ticks = (uint64_t)(htim->Init.Prescaler + 1) * (htim->Init.Period + 1);
+
+	return (ticks * 1000000U) / HOST_SYSCLK_HZ;
+}
+
+static void timer_elapsed(void *ctx){
+
+	host_timer *tim = (host_timer *)ctx;
+
+	HAL_TIM_PeriodElapsedCallback(tim->htim);
+
+	// Auto-reload unless the callback stopped the timer
+	if(tim->running){
+		host_schedule(now_us + timer_period_us(tim->htim), timer_elapsed, tim);
+	}
+}
+
+HAL_StatusTypeDef HAL_TIM_Base_Init(TIM_HandleTypeDef *htim){
+	HAL_TIM_Base_MspInit(htim);
+	return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_TIM_ConfigClockSource(TIM_HandleTypeDef *htim, TIM_ClockConfigTypeDef *sClockSourceConfig){
+	UNUSED(htim);
+	UNUSED(sClockSourceConfig);
+	return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_TIMEx_MasterConfigSynchronization(TIM_HandleTypeDef *htim, TIM_MasterConfigTypeDef *sMasterConfig){
+	UNUSED(htim);
+	UNUSED(sMasterConfig);
+	return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_TIM_Base_Start_IT(TIM_HandleTypeDef *htim){
+
+	host_timer *tim = find_timer(htim, true);
+
+	if(tim == NULL){
+		return HAL_ERROR;
+	}
+
+	host_cancel(timer_elapsed, tim);
+	tim->running = true;
+
+	if(host_schedule(now_us + timer_period_us(htim), timer_elapsed, tim) != 0){
+		return HAL_ERROR;
+	}
+	return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_TIM_Base_Stop(TIM_HandleTypeDef *htim){
+
+	host_timer *tim = find_timer(htim, false);
+
+	if(tim != NULL){
+		tim->running = false;
+		host_cancel(timer_elapsed, tim);
+	}
+	return HAL_OK;
+}
@@ -0,0 +1,274 @@
+/*
+ * hdc2080_model.c
+ *
+ *  HDC2080 register model: on-demand and auto-measurement (AMM) conversions
+ *  with datasheet latencies, DRDY/threshold status and the INT pin driving
+ *  an EXTI line on its rising edge.
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: dst2001055
+ */
+
+#include <string.h>
+#include "sensor_models.h"
+
+#define HDC2080_SOFT_RESET	0x80
+#define HDC2080_AMM_MASK	0x70
+#define HDC2080_AMM_SHIFT	4
+#define HDC2080_DRDY_INT_EN	0x04
+#define HDC2080_INT_MODE	0x01
+#define HDC2080_MEAS_TRIG	0x01
+#define HDC2080_STATUS_MASK	0xF8
+
+// T[C] = raw * 165 / 65536 - (40.5 + 0.08 * (VDD - 1.8)), VDD = 3.3 V
+#define HDC2080_TEMP_OFFSET	40.62
+
+static const uint32_t amm_period_ms[8] = {0, 120000, 60000, 10000, 5000, 1000, 500, 200};
+static const uint16_t temp_conv_us[4] = {610, 350, 225, 610};
+static const uint16_t hum_conv_us[4] = {660, 400, 275, 660};
+
+static void hdc_amm_tick(void *ctx);
+static void hdc_conversion_done(void *ctx);
+
+static void hdc_defaults(hdc2080_model *m){
+
+	memset(m->regs, 0, sizeof(m->regs));
+
+	m->regs[HDC2080_REG_TEMP_THR_L] = 0x01;
+	m->regs[HDC2080_REG_TEMP_THR_H] = 0xFF;
+	m->regs[HDC2080_REG_RH_THR_L] = 0x00;
+	m->regs[HDC2080_REG_RH_THR_H] = 0xFF;
+
+	m->regs[HDC2080_REG_MANUF_ID] = 0x49;
+	m->regs[HDC2080_REG_MANUF_ID + 1] = 0x54;
+	m->regs[HDC2080_REG_DEVICE_ID] = 0xD0;
+	m->regs[HDC2080_REG_DEVICE_ID + 1] = 0x07;
+
+	m->converting = false;
+	m->amm_running = false;
+	host_cancel(hdc_conversion_done, m);
+	host_cancel(hdc_amm_tick, m);
+}
+
+static void hdc_update_pin(hdc2080_model *m){
+
+	uint8_t pending = m->regs[HDC2080_REG_STATUS] & m->regs[HDC2080_REG_INT_EN] & HDC2080_STATUS_MASK;
+	bool level = (m->regs[HDC2080_REG_CONFIG] & HDC2080_DRDY_INT_EN) && pending;
+
+	if(level && !m->int_level){
+		m->int_level = true;
+		m->interrupts++;
+		if(m->int_pin != 0){
+			host_gpio_exti(m->int_pin);
+		}
+	} else if(!level){
+		m->int_level = false;
+	}
+}
+
+static void hdc_start_conversion(hdc2080_model *m){
+
+	uint8_t meas = m->regs[HDC2080_REG_MEAS_CONFIG];
+	uint8_t mode = (meas >> 1) & 0x03;
+	uint32_t latency = temp_conv_us[(meas >> 6) & 0x03];
+
+	if(m->converting){
+		return;
+	}
+
+	if(mode == 0){
+		latency += hum_conv_us[(meas >> 4) & 0x03];
+	}
+
+	m->converting = true;
+	host_schedule(host_now_us() + latency, hdc_conversion_done, m);
+}
+
+static uint16_t hdc_quantize(double raw, uint8_t res_bits){
+
+	// 14/11/9-bit results are left aligned in the 16-bit register
+	static const uint16_t res_mask[4] = {0xFFFC, 0xFFE0, 0xFF80, 0xFFFC};
+
+	if(raw < 0.0){
+		raw = 0.0;
+	} else if(raw > 65535.0){
+		raw = 65535.0;
+	}
+	return (uint16_t)raw & res_mask[res_bits & 0x03];
+}
+
+static void hdc_conversion_done(void *ctx){
+
+	hdc2080_model *m = (hdc2080_model *)ctx;
+	uint64_t now = host_now_us();
+	uint8_t meas = m->regs[HDC2080_REG_MEAS_CONFIG];
+	uint8_t mode = (meas >> 1) & 0x03;
+	uint8_t status = m->regs[HDC2080_REG_STATUS];
+
+	double temp = host_waveform_eval(&m->temperature, now);
+	uint16_t temp_raw = hdc_quantize((temp + HDC2080_TEMP_OFFSET) * 65536.0 / 165.0, meas >> 6);
+
+	m->regs[HDC2080_REG_TEMP_L] = temp_raw & 0xFF;
+	m->regs[HDC2080_REG_TEMP_L + 1] = temp_raw >> 8;
+
+	if(mode == 0){
+		double hum = host_waveform_eval(&m->humidity, now);
+		uint16_t hum_raw = hdc_quantize(hum * 65536.0 / 100.0, meas >> 4);
+
+		m->regs[HDC2080_REG_HUM_L] = hum_raw & 0xFF;
+		m->regs[HDC2080_REG_HUM_L + 1] = hum_raw >> 8;
+	}
+
+	uint8_t temp_msb = m->regs[HDC2080_REG_TEMP_L + 1];
+	uint8_t hum_msb = m->regs[HDC2080_REG_HUM_L + 1];
+	uint8_t limits = 0;
+
+	if(temp_msb > m->regs[HDC2080_REG_TEMP_THR_H]) limits |= 1 << HDC2080_TH_BIT;
+	if(temp_msb < m->regs[HDC2080_REG_TEMP_THR_L]) limits |= 1 << HDC2080_TL_BIT;
+	if(hum_msb > m->regs[HDC2080_REG_RH_THR_H]) limits |= 1 << HDC2080_HH_BIT;
+	if(hum_msb < m->regs[HDC2080_REG_RH_THR_L]) limits |= 1 << HDC2080_HL_BIT;
+
+	// Comparator mode tracks the limits, level mode latches until read
+	if(m->regs[HDC2080_REG_CONFIG] & HDC2080_INT_MODE){
+		status &= (1 << HDC2080_DRDY_BIT);
+	}
+	status |= limits | (1 << HDC2080_DRDY_BIT);
+
+	m->regs[HDC2080_REG_STATUS] = status;
+	m->regs[HDC2080_REG_MEAS_CONFIG] &= ~HDC2080_MEAS_TRIG;
+	m->converting = false;
+	m->conversions++;
+
+	hdc_update_pin(m);
+}
+
+static void hdc_amm_tick(void *ctx){
+
+	hdc2080_model *m = (hdc2080_model *)ctx;
+	uint8_t amm = (m->regs[HDC2080_REG_CONFIG] & HDC2080_AMM_MASK) >> HDC2080_AMM_SHIFT;
+
+	if(amm == 0){
+		m->amm_running = false;
+		return;
+	}
+
+	hdc_start_conversion(m);
+	host_schedule(host_now_us() + amm_period_ms[amm] * 1000ULL, hdc_amm_tick, m);
+}
+
+//----------------------------------------- I2C --------------------------------------------------------
+
+static void hdc_write_reg(hdc2080_model *m, uint8_t reg, uint8_t value){
+
+	uint8_t old_amm;
+
+	switch(reg){
+		case HDC2080_REG_STATUS:
+		case HDC2080_REG_MANUF_ID:
+		case HDC2080_REG_MANUF_ID + 1:
+		case HDC2080_REG_DEVICE_ID:
+		case HDC2080_REG_DEVICE_ID + 1:
+			break;
+
+		case HDC2080_REG_CONFIG:
+			if(value & HDC2080_SOFT_RESET){
+				hdc_defaults(m);
+				break;
+			}
+
+			old_amm = m->regs[reg] & HDC2080_AMM_MASK;
+			m->regs[reg] = value;
+
+			// Writing AMM only sets the rate: the auto measurement starts
+			// with MEAS_TRIG, a new rate applies once it is running
+			if((value & HDC2080_AMM_MASK) != old_amm){
+				host_cancel(hdc_amm_tick, m);
+				if(!(value & HDC2080_AMM_MASK)){
+					m->amm_running = false;
+				} else if(m->amm_running){
+					uint8_t amm = (value & HDC2080_AMM_MASK) >> HDC2080_AMM_SHIFT;
+					host_schedule(host_now_us() + amm_period_ms[amm] * 1000ULL, hdc_amm_tick, m);
+				}
+			}
+			break;
+
+		case HDC2080_REG_MEAS_CONFIG:
+			m->regs[reg] = value;
+			if(value & HDC2080_MEAS_TRIG){
+				uint8_t amm = (m->regs[HDC2080_REG_CONFIG] & HDC2080_AMM_MASK) >> HDC2080_AMM_SHIFT;
+
+				if(amm != 0 && !m->amm_running){
+					m->amm_running = true;
+					host_schedule(host_now_us() + amm_period_ms[amm] * 1000ULL, hdc_amm_tick, m);
+				}
+				hdc_start_conversion(m);
+			}
+			break;
+
+		default:
+			m->regs[reg] = value;
+			break;
+	}
+}
+
+static HAL_StatusTypeDef hdc_i2c_write(void *ctx, const uint8_t *pData, uint16_t size){
+
+	hdc2080_model *m = (hdc2080_model *)ctx;
+
+	if(size == 0){
+		return HAL_OK;
+	}
+
+	m->pointer = pData[0];
+
+	for(uint16_t i = 1; i < size; i++){
+		hdc_write_reg(m, m->pointer++, pData[i]);
+	}
+
+	hdc_update_pin(m);
+	return HAL_OK;
+}
+
+static HAL_StatusTypeDef hdc_i2c_read(void *ctx, uint8_t *pData, uint16_t size){
+
+	hdc2080_model *m = (hdc2080_model *)ctx;
+	bool status_read = false;
+
+	for(uint16_t i = 0; i < size; i++){
+		if(m->pointer == HDC2080_REG_STATUS){
+			status_read = true;
+		}
+		pData[i] = m->regs[m->pointer++];
+	}
+
+	if(status_read){
+		if(m->regs[HDC2080_REG_CONFIG] & HDC2080_INT_MODE){
+			m->regs[HDC2080_REG_STATUS] &= ~(1 << HDC2080_DRDY_BIT);
+		} else {
+			m->regs[HDC2080_REG_STATUS] = 0;
+		}
+		hdc_update_pin(m);
+	}
+
+	return HAL_OK;
+}
+
+//----------------------------------------- SETUP ------------------------------------------------------
+
+void hdc2080_model_init(hdc2080_model *m, uint16_t int_pin){
+
+	memset(m, 0, sizeof(*m));
+
+	m->int_pin = int_pin;
+	m->temperature.offset = 25.0;
+	m->humidity.offset = 50.0;
+
+	hdc_defaults(m);
+}
+
+uint8_t hdc2080_model_attach(hdc2080_model *m, uint16_t addr){
+
+	host_i2c_device dev = {addr, hdc_i2c_write, hdc_i2c_read, m};
+
+	return host_i2c_attach(&dev);
+}
@@ -0,0 +1,600 @@
+/*
+ * sim.c
+ *
+ *  Discrete-event simulator. Runs the real firmware_main() against the HAL
+ *  shim and the sensor models on the virtual clock, so HAL_Delay() and
+ *  wait_delay() cost nothing and months of operation replay in seconds.
+ *  Scripted events (button gestures, EXTI lines, profile changes) are
+ *  injected at exact virtual times.
+ *
+ *  Script format, one event per line ('#' starts a comment):
+ *
+ *      <time> <event> [args]
+ *
+ *  <time> is a number with an optional unit: ms, s (default), m, h or d.
+ *  Events:
+ *      button <n>              n presses of USER_BTN, 200 ms apart
+ *      exti <pin>              raise EXTI line <pin> (0-15)
+ *      profile <name>          storage | runaway | truck
+ *      temp <C>                temperature baseline
+ *      hum <%RH>               humidity baseline
+ *      shock <mg>              one 20 ms half-sine on the Z axis
+ *      report                  print the totals so far
+ *
+ *  -b stands in for the BLE module on the COMMS UART: the uplink frames are
+ *  passed through to a pseudo-terminal, whose path is printed at start, for
+ *  a gateway tool to read like the module's serial port
+ *  (python BAT_Decoder.py --port /dev/pts/N). -b <file> writes them to a
+ *  file or FIFO instead. Like a module with no central connected, the pty
+ *  drops what its buffer cannot hold.
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: dst2001055
+ */
+
+#define _GNU_SOURCE
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+
+#include "hal_host.h"
+#include "sensor_models.h"
+#include "app.h"
+#include "mal.h"
+
+#define SIM_DEFAULT_DAYS	30.0
+#define SIM_MAX_EVENTS		256
+#define SIM_LINE_LEN		128
+#define SIM_PRESS_GAP_US	200000U
+#define SIM_SHOCK_MS		20.0
+
+#define SIM_US_PER_S		1000000.0
+#define SIM_US_PER_DAY		86400000000.0
+
+#define SIM_EEPROM_ENDURANCE 100000.0	// data EEPROM erase/program cycles per word
+
+extern int firmware_main(void);
+extern enum states CURRENT_STATE;
+
+enum sim_event_type{SIM_BUTTON, SIM_EXTI, SIM_PROFILE, SIM_TEMP, SIM_HUM, SIM_SHOCK, SIM_REPORT};
+
+typedef struct{
+	uint64_t at_us;
+	uint8_t type;
+	double value;
+	char name[16];
+}sim_event;
+
+typedef struct{
+	uint32_t entries;
+	uint64_t resident_us;
+	uint64_t active_us;
+	uint64_t i2c_us;
+	uint64_t uart_us;
+}sim_state_stats;
+
+static const char *i2c_dev_names[I2C_DEV_COUNT] = {"HDC2080", "ADXL343"};
+
+static const char *state_names[STATE_COUNT] = {
+	"IDLE", "DATA_READ", "COMMS", "ANOMALY", "RECONNECT", "LOGS", "CLEAN_MEM", "SHOCK"
+};
+
+static hdc2080_model hdc2080;
+static adxl343_model adxl343;
+
+static sim_event script[SIM_MAX_EVENTS];
+static uint16_t script_len;
+static uint16_t script_next;
+
+static uint8_t presses_left;
+
+static sim_state_stats state_stats[STATE_COUNT];
+static uint8_t last_state = STATE_COUNT;
+
+static uint64_t log_bytes;
+static uint64_t log_records;
+static bool in_frame;
+static bool echo_log;
+
+static uint64_t ble_bytes;
+static uint64_t ble_dropped;
+static int ble_fd = -1;
+static int ble_peer_fd = -1;		// our own end of the pty, keeps it open and raw
+
+//----------------------------------------- OBSERVERS --------------------------------------------------
+
+// Every clock advance is charged to the state the FSM is in at that moment
+static void sim_on_advance(uint64_t us, uint8_t kind){
+
+	uint8_t state = (uint8_t)CURRENT_STATE;
+
+	if(state >= STATE_COUNT){
+		return;
+	}
+
+	if(state != last_state){
+		state_stats[state].entries++;
+		last_state = state;
+	}
+
+	state_stats[state].resident_us += us;
+
+	switch(kind){
+	case HOST_TIME_DELAY:
+	case HOST_TIME_SLEEP:
+	case HOST_TIME_STOP:
+		break;
+	case HOST_TIME_I2C:
+		state_stats[state].i2c_us += us;
+		state_stats[state].active_us += us;
+		break;
+	case HOST_TIME_UART:
+		state_stats[state].uart_us += us;
+		state_stats[state].active_us += us;
+		break;
+	default:
+		state_stats[state].active_us += us;
+		break;
+	}
+}
+
+// Interrupt and DMA transfers run on while the CPU sleeps or moves on to the
+// next state: their bus time goes to the state that started them
+static void sim_on_bus(uint64_t us, uint8_t kind){
+
+	uint8_t state = (uint8_t)CURRENT_STATE;
+
+	if(state >= STATE_COUNT){
+		return;
+	}
+
+	if(kind == HOST_TIME_I2C){
+		state_stats[state].i2c_us += us;
+	} else {
+		state_stats[state].uart_us += us;
+	}
+	state_stats[state].active_us += us;
+}
+
+static void sim_log_sink(void *ctx, const uint8_t *pData, uint16_t size){
+
+	(void)ctx;
+
+	const uint8_t *p = pData;
+	const uint8_t *end = pData + size;
+
+	// Text lines end in '\n', binary frames are wrapped in two 0x00
+	log_bytes += size;
+	while(p < end){
+		const uint8_t *zero = memchr(p, 0x00, end - p);
+		const uint8_t *stop = (zero != NULL) ? zero : end;
+
+		for(const uint8_t *nl = p; !in_frame && (nl = memchr(nl, '\n', stop - nl)) != NULL; nl++){
+			log_records++;
+		}
+		if(zero == NULL){
+			break;
+		}
+		in_frame = !in_frame;
+		log_records += in_frame ? 1 : 0;
+		p = zero + 1;
+	}
+
+	if(echo_log){
+		fwrite(pData, 1, size, stdout);
+	}
+}
+
+// Mock BLE module: transparent bridge from the COMMS UART to the pty or file
+static void sim_ble_sink(void *ctx, const uint8_t *pData, uint16_t size){
+
+	(void)ctx;
+
+	ble_bytes += size;
+
+	while(ble_fd >= 0 && size > 0){
+		ssize_t n = write(ble_fd, pData, size);
+
+		if(n < 0 && errno == EINTR){
+			continue;
+		}
+		if(n <= 0){
+			ble_dropped += size;
+			break;
+		}
+		pData += n;
+		size -= (uint16_t)n;
+	}
+}
+
+static uint8_t sim_ble_open(const char *path){
+
+	if(path != NULL){
+		ble_fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+		if(ble_fd < 0){
+			perror(path);
+			return 1;
+		}
+		return 0;
+	}
+
+	struct termios tio;
+
+	ble_fd = posix_openpt(O_RDWR | O_NOCTTY);
+	if(ble_fd < 0 || grantpt(ble_fd) != 0 || unlockpt(ble_fd) != 0){
+		perror("pty");
+		return 1;
+	}
+
+	ble_peer_fd = ioctl(ble_fd, TIOCGPTPEER, O_RDWR | O_NOCTTY);
+	if(ble_peer_fd < 0 || tcgetattr(ble_peer_fd, &tio) != 0){
+		perror("pty");
+		return 1;
+	}
+
+	// Binary frames: no echo, no line editing, no CR/LF translation
+	cfmakeraw(&tio);
+	tcsetattr(ble_peer_fd, TCSANOW, &tio);
+	fcntl(ble_fd, F_SETFL, O_NONBLOCK);
+
+	fprintf(stderr, "BLE module on %s\n", ptsname(ble_fd));
+	return 0;
+}
+
+//----------------------------------------- REPORT -----------------------------------------------------
+
+static void sim_report(double wall_s){
+
+	double now_s = host_now_us() / SIM_US_PER_S;
+	uint32_t cycles = state_stats[DATA_READ].entries;
+
+	printf("\r\n--- %.2f simulated days", now_s * SIM_US_PER_S / SIM_US_PER_DAY);
+	if(wall_s > 0.0){
+		printf(" in %.3f s wall (%.1f days/s)", wall_s, now_s * SIM_US_PER_S / SIM_US_PER_DAY / wall_s);
+	}
+	printf(" ---\r\n");
+
+	printf("cycles (DATA_READ entries) %u\r\n\r\n", cycles);
+
+	// active s: CPU held by polled transfers and the like, plus the bus time of
+	// the transfers the state started (i2c s, uart s), so it may overlap.
+	// run s / wcet ms: the firmware's own per-state timing (get_fsm_stats())
+	printf("%-10s %10s %14s %12s %10s %10s %10s %10s\r\n", "state", "entries", "resident s", "active s",
+			"i2c s", "uart s", "run s", "wcet ms");
+	for(uint8_t i = 0; i < STATE_COUNT; i++){
+		fsm_state_stats fsm = get_fsm_stats(i);
+		printf("%-10s %10u %14.1f %12.3f %10.3f %10.3f %10.3f %10.3f\r\n", state_names[i], state_stats[i].entries,
+				state_stats[i].resident_us / SIM_US_PER_S, state_stats[i].active_us / SIM_US_PER_S,
+				state_stats[i].i2c_us / SIM_US_PER_S, state_stats[i].uart_us / SIM_US_PER_S,
+				fsm.run_us / SIM_US_PER_S, fsm.max_run_us / 1000.0);
+	}
+
+	printf("\r\nI2C   %u transactions (%u repeated START), %u bytes, %u NACKs, %.3f s busy\r\n",
+			host_counters.i2c_transactions, host_counters.i2c_repeated_starts, host_counters.i2c_bytes,
+			host_counters.i2c_nacks, host_counters.i2c_busy_us / SIM_US_PER_S);
+	printf("\r\n%-8s %10s %8s %10s |", "I2C dev", "xfers", "errors", "bytes");
+	for(uint8_t b = 0; b < I2C_LATENCY_BINS; b++){
+		char label[12];
+		if(b < I2C_LATENCY_BINS - 1){
+			snprintf(label, sizeof(label), "<%uus", I2C_LATENCY_BASE_US << b);
+		} else {
+			snprintf(label, sizeof(label), ">=%uus", I2C_LATENCY_BASE_US << (b - 1));
+		}
+		printf(" %8s", label);
+	}
+	printf("\r\n");
+	for(uint8_t d = 0; d < I2C_DEV_COUNT; d++){
+		i2c_dev_stats dev = get_i2c_stats(d);
+		printf("%-8s %10u %8u %10u |", i2c_dev_names[d], dev.transactions, dev.errors, dev.bytes);
+		for(uint8_t b = 0; b < I2C_LATENCY_BINS; b++){
+			printf(" %8u", dev.latency[b]);
+		}
+		printf("\r\n");
+	}
+	printf("\r\n");
+	printf("UART  %u writes, %llu bytes, %.3f s busy\r\n", host_counters.uart_writes,
+			(unsigned long long)host_counters.uart_bytes, host_counters.uart_busy_us / SIM_US_PER_S);
+	uart_tx_stats tx = get_UART_tx_stats();
+	printf("TX    %u bytes queued, %u dropped (%u messages), %u DMA transfers, high-water %u/%u\r\n", tx.bytes_queued,
+			tx.bytes_dropped, tx.messages_dropped, tx.dma_transfers, tx.high_water, UART_TX_BUF_SIZE);
+	printf("LOG   %llu records, %llu bytes (%.1f kB/day)\r\n", (unsigned long long)log_records,
+			(unsigned long long)log_bytes, now_s > 0.0 ? log_bytes / 1024.0 / (now_s * SIM_US_PER_S / SIM_US_PER_DAY) : 0.0);
+	printf("RTC   %u reads, %u wake-up timer events\r\n", host_counters.rtc_reads, host_counters.rtc_wakeups);
+	uplink_stats up = get_uplink_stats();
+	printf("BLE   %u frames (%u anomaly), %u readings (%.1f per frame), %llu bytes (%.1f kB/day), %u frames dropped",
+			up.frames, up.anomaly_frames, up.readings, up.frames > 0 ? (double)up.readings / up.frames : 0.0,
+			(unsigned long long)ble_bytes, now_s > 0.0 ? ble_bytes / 1024.0 / (now_s * SIM_US_PER_S / SIM_US_PER_DAY) : 0.0,
+			up.dropped);
+	if(ble_fd >= 0){
+		printf(", %llu bytes not taken by the mock", (unsigned long long)ble_dropped);
+	}
+	printf("\r\n");
+	printf("CPU   %.2f%% STOP (%u entries), %.2f%% sleep, %.2f%% run\r\n",
+			now_s > 0.0 ? host_counters.stop_us / (now_s * SIM_US_PER_S) * 100.0 : 0.0, host_counters.stop_entries,
+			now_s > 0.0 ? host_counters.sleep_us / (now_s * SIM_US_PER_S) * 100.0 : 0.0,
+			now_s > 0.0 ? (now_s * SIM_US_PER_S - host_counters.stop_us - host_counters.sleep_us) / (now_s * SIM_US_PER_S) * 100.0 : 0.0);
+	event_queue_stats evt = get_event_stats();
+	printf("EVT   %u posted, %u dropped, high-water %u/%u, max latency %u ms\r\n", evt.posted, evt.dropped,
+			evt.high_water, EVENT_QUEUE_LEN, evt.max_latency_ms);
+
+	uint32_t wear_min = UINT32_MAX, wear_max = 0;
+	for(uint16_t w = 0; w < MEM_SLOTS * MEM_RECORD_SIZE / 4; w++){
+		uint32_t cycles = host_eeprom_cycles(w);
+		wear_min = cycles < wear_min ? cycles : wear_min;
+		wear_max = cycles > wear_max ? cycles : wear_max;
+	}
+	printf("MEM   %u/%u records, %u programs, %u erases, %u..%u cycles per word", mem_count(), (unsigned)MEM_SLOTS,
+			host_counters.eeprom_programs, host_counters.eeprom_erases, wear_min, wear_max);
+	if(wear_max > 0){
+		printf(" (%.1f years to %u)", SIM_EEPROM_ENDURANCE / wear_max * now_s / (SIM_US_PER_DAY / SIM_US_PER_S) / 365.0,
+				(unsigned)SIM_EEPROM_ENDURANCE);
+	}
+	printf("\r\n");
+	printf("HDC   %u conversions, %u interrupts\r\n", hdc2080.conversions, hdc2080.interrupts);
+	adxl343_model_sync(&adxl343);
+	printf("ADXL  %u samples, %u overruns, %u parked discards, %u interrupts\r\n", adxl343.samples, adxl343.overruns,
+			adxl343.discarded, adxl343.interrupts);
+}
+
+//----------------------------------------- SCRIPT -----------------------------------------------------
+
+static void sim_press(void *ctx){
+
+	(void)ctx;
+
+	host_gpio_exti(USER_BTN);
+
+	if(--presses_left > 0){
+		host_schedule(host_now_us() + SIM_PRESS_GAP_US, sim_press, NULL);
+	}
+}
+
+static void sim_apply(const sim_event *ev){
+
+	double now_s = host_now_us() / SIM_US_PER_S;
+
+	switch(ev->type){
+	case SIM_BUTTON:
+		presses_left = (uint8_t)ev->value;
+		if(presses_left > 0){
+			sim_press(NULL);
+		}
+		break;
+	case SIM_EXTI:
+		host_gpio_exti((uint16_t)(1U << (uint8_t)ev->value));
+		break;
+	case SIM_PROFILE:
+		if(strcmp(ev->name, "runaway") == 0){
+			host_profile_thermal_runaway(&hdc2080, &adxl343, now_s);
+		} else if(strcmp(ev->name, "truck") == 0){
+			host_profile_truck(&hdc2080, &adxl343);
+		} else {
+			host_profile_storage_room(&hdc2080, &adxl343);
+		}
+		adxl343_model_sync(&adxl343);
+		break;
+	case SIM_TEMP:
+		hdc2080.temperature.offset = ev->value;
+		break;
+	case SIM_HUM:
+		hdc2080.humidity.offset = ev->value;
+		break;
+	case SIM_SHOCK:
+		adxl343.axis[2].pulse_at_s = now_s;
+		adxl343.axis[2].pulse_every_s = 0.0;
+		adxl343.axis[2].pulse_ms = SIM_SHOCK_MS;
+		adxl343.axis[2].pulse_amp = ev->value;
+		adxl343_model_sync(&adxl343);
+		break;
+	case SIM_REPORT:
+		sim_report(0.0);
+		break;
+	}
+}
+
+// Only the next script entry sits in the shim's event table at any time
+static void sim_script_event(void *ctx){
+
+	(void)ctx;
+
+	sim_apply(&script[script_next++]);
+
+	if(script_next < script_len){
+		host_schedule(script[script_next].at_us, sim_script_event, NULL);
+	}
+}
+
+static uint8_t parse_time(const char *tok, uint64_t *at_us){
+
+	char *unit;
+	double value = strtod(tok, &unit);
+	double scale = SIM_US_PER_S;
+
+	if(unit == tok){
+		return 1;
+	}
+
+	if(strcmp(unit, "ms") == 0){
+		scale = 1000.0;
+	} else if(strcmp(unit, "m") == 0){
+		scale = 60.0 * SIM_US_PER_S;
+	} else if(strcmp(unit, "h") == 0){
+		scale = 3600.0 * SIM_US_PER_S;
+	} else if(strcmp(unit, "d") == 0){
+		scale = SIM_US_PER_DAY;
+	} else if(*unit != '\0' && strcmp(unit, "s") != 0){
+		return 1;
+	}
+
+	*at_us = (uint64_t)(value * scale);
+	return 0;
+}
+
+static uint8_t parse_event(const char *cmd, const char *arg, sim_event *ev){
+
+	static const char *names[] = {"button", "exti", "profile", "temp", "hum", "shock", "report"};
+
+	for(uint8_t i = 0; i < sizeof(names) / sizeof(names[0]); i++){
+		if(strcmp(cmd, names[i]) == 0){
+			ev->type = i;
+			ev->value = (arg != NULL) ? strtod(arg, NULL) : 0.0;
+			if(arg != NULL){
+				snprintf(ev->name, sizeof(ev->name), "%s", arg);
+			}
+			return 0;
+		}
+	}
+	return 1;
+}
+
+static int compare_events(const void *a, const void *b){
+
+	const sim_event *ea = a;
+	const sim_event *eb = b;
+
+	return (ea->at_us > eb->at_us) - (ea->at_us < eb->at_us);
+}
+
+static uint8_t load_script(const char *path){
+
+	char line[SIM_LINE_LEN];
+	uint32_t line_no = 0;
+	FILE *f = fopen(path, "r");
+
+	if(f == NULL){
+		fprintf(stderr, "batmon_sim: cannot open %s\n", path);
+		return 1;
+	}
+
+	while(fgets(line, sizeof(line), f) != NULL){
+		line_no++;
+
+		char *hash = strchr(line, '#');
+		if(hash != NULL){
+			*hash = '\0';
+		}
+
+		char *tok_time = strtok(line, " \t\r\n");
+		char *tok_cmd = strtok(NULL, " \t\r\n");
+		char *tok_arg = strtok(NULL, " \t\r\n");
+
+		if(tok_time == NULL){
+			continue;
+		}
+
+		if(script_len >= SIM_MAX_EVENTS){
+			fprintf(stderr, "batmon_sim: %s: more than %d events\n", path, SIM_MAX_EVENTS);
+			fclose(f);
+			return 1;
+		}
+
+		sim_event *ev = &script[script_len];
+		memset(ev, 0, sizeof(*ev));
+
+		if(tok_cmd == NULL || parse_time(tok_time, &ev->at_us) != 0 || parse_event(tok_cmd, tok_arg, ev) != 0){
+			fprintf(stderr, "batmon_sim: %s:%u: bad event\n", path, line_no);
+			fclose(f);
+			return 1;
+		}
+		script_len++;
+	}
+
+	fclose(f);
+
+	// Stable enough: equal times keep no particular order, scripts should not rely on it
+	qsort(script, script_len, sizeof(script[0]), compare_events);
+	return 0;
+}
+
+//----------------------------------------- MAIN -------------------------------------------------------
+
+static uint64_t wall_ns(void){
+
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000U + (uint64_t)ts.tv_nsec;
+}
+
+static void usage(void){
+	fprintf(stderr, "usage: batmon_sim [-d days] [-p storage|runaway|truck] [-s script] [-b [file]] [-v]\n");
+}
+
+int main(int argc, char **argv){
+
+	double days = SIM_DEFAULT_DAYS;
+	const char *profile = "storage";
+	const char *script_path = NULL;
+	const char *ble_path = NULL;
+	bool ble = false;
+
+	for(int i = 1; i < argc; i++){
+		if(strcmp(argv[i], "-d") == 0 && i + 1 < argc){
+			days = strtod(argv[++i], NULL);
+		} else if(strcmp(argv[i], "-p") == 0 && i + 1 < argc){
+			profile = argv[++i];
+		} else if(strcmp(argv[i], "-s") == 0 && i + 1 < argc){
+			script_path = argv[++i];
+		} else if(strcmp(argv[i], "-b") == 0){
+			ble = true;
+			if(i + 1 < argc && argv[i + 1][0] != '-'){
+				ble_path = argv[++i];
+			}
+		} else if(strcmp(argv[i], "-v") == 0){
+			echo_log = true;
+		} else {
+			usage();
+			return 2;
+		}
+	}
+
+	if(days <= 0.0){
+		usage();
+		return 2;
+	}
+
+	if(script_path != NULL && load_script(script_path) != 0){
+		return 1;
+	}
+
+	if(ble && sim_ble_open(ble_path) != 0){
+		return 1;
+	}
+
+	host_reset();
+
+	// ADXL343 INT1/INT2 land on PB5/PB6
+	hdc2080_model_init(&hdc2080, INT_HDC2080_PIN);
+	adxl343_model_init(&adxl343, GPIO_PIN_5, GPIO_PIN_6);
+
+	sim_event start = {0, SIM_PROFILE, 0.0, ""};
+	snprintf(start.name, sizeof(start.name), "%s", profile);
+	sim_apply(&start);
+
+	hdc2080_model_attach(&hdc2080, HDC2080_ADDR);
+	adxl343_model_attach(&adxl343, ADXL343_ADDR);
+
+	host_uart_set_sink(DEBUG_UART, sim_log_sink, NULL);
+	host_uart_set_sink(COMMS_UART, sim_ble_sink, NULL);
+	host_set_advance_hook(sim_on_advance);
+	host_set_bus_hook(sim_on_bus);
+
+	if(script_len > 0){
+		host_schedule(script[0].at_us, sim_script_event, NULL);
+	}
+
+	uint64_t start_ns = wall_ns();
+
+	host_run_until(firmware_main, (uint64_t)(days * SIM_US_PER_DAY));
+
+	sim_report((wall_ns() - start_ns) / 1e9);
+
+	return 0;
+}
@@ -0,0 +1,190 @@
+/*
+ * waveform.c
+ *
+ *  Scriptable physical-quantity waveforms for the sensor models and the
+ *  stock environment profiles used by the bench and simulator.
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: dst2001055
+ */
+
+#include <math.h>
+#include <string.h>
+#include "sensor_models.h"
+
+#define HOST_PI 3.14159265358979323846
+
+// Stateless hash so the same instant always yields the same noise
+static double noise_at(uint64_t t_us){
+
+	uint64_t x = t_us * 0x9E3779B97F4A7C15ULL;
+
+	x ^= x >> 31;
+	x *= 0xBF58476D1CE4E5B9ULL;
+	x ^= x >> 29;
+
+	return ((double)(x >> 11) / (double)(1ULL << 53)) * 2.0 - 1.0;
+}
+
+double host_waveform_eval(const host_waveform *wf, uint64_t t_us){
+
+	double t = (double)t_us / 1e6;
+	double value = wf->offset;
+
+	if((wf->ramp_per_s != 0.0 || wf->ramp_per_s2 != 0.0) && t > wf->ramp_start_s){
+		double dt = t - wf->ramp_start_s;
+		value += wf->ramp_per_s * dt + 0.5 * wf->ramp_per_s2 * dt * dt;
+	}
+
+	if(wf->sine_amp != 0.0){
+		value += wf->sine_amp * sin(2.0 * HOST_PI * wf->sine_hz * t);
+	}
+
+	if(wf->noise_amp != 0.0){
+		value += wf->noise_amp * noise_at(t_us);
+	}
+
+	if(wf->pulse_amp != 0.0 && wf->pulse_ms > 0.0 && t >= wf->pulse_at_s){
+		double phase = t - wf->pulse_at_s;
+		double width = wf->pulse_ms / 1000.0;
+
+		if(wf->pulse_every_s > 0.0){
+			phase = fmod(phase, wf->pulse_every_s);
+		}
+
+		if(phase < width){
+			value += wf->pulse_amp * sin(HOST_PI * phase / width);
+		}
+	}
+
+	return value;
+}
+
+// Range of the waveform over [from_us, to_us], loose but never too narrow:
+// sine and noise count at full amplitude, a pulse if one overlaps at all
+void host_waveform_bounds(const host_waveform *wf, uint64_t from_us, uint64_t to_us, double *lo, double *hi){
+
+	double a = (double)from_us / 1e6;
+	double b = (double)to_us / 1e6;
+	double low = wf->offset;
+	double high = wf->offset;
+
+	if((wf->ramp_per_s != 0.0 || wf->ramp_per_s2 != 0.0) && b > wf->ramp_start_s){
+		double dt[3] = {(a > wf->ramp_start_s) ? a - wf->ramp_start_s : 0.0, b - wf->ramp_start_s, 0.0};
+		uint8_t points = 2;
+
+		// Turning point of a decelerating ramp inside the interval
+		if(wf->ramp_per_s2 != 0.0){
+			double vertex = -wf->ramp_per_s / wf->ramp_per_s2;
+			if(vertex > dt[0] && vertex < dt[1]){
+				dt[points++] = vertex;
+			}
+		}
+
+		double ramp_lo = 0.0;
+		double ramp_hi = 0.0;
+
+		for(uint8_t i = 0; i < points; i++){
+			double r = wf->ramp_per_s * dt[i] + 0.5 * wf->ramp_per_s2 * dt[i] * dt[i];
+			if(i == 0 || r < ramp_lo) ramp_lo = r;
+			if(i == 0 || r > ramp_hi) ramp_hi = r;
+		}
+		// Before ramp_start_s the ramp term is 0
+		if(a <= wf->ramp_start_s){
+			if(ramp_lo > 0.0) ramp_lo = 0.0;
+			if(ramp_hi < 0.0) ramp_hi = 0.0;
+		}
+		low += ramp_lo;
+		high += ramp_hi;
+	}
+
+	low -= fabs(wf->sine_amp) + fabs(wf->noise_amp);
+	high += fabs(wf->sine_amp) + fabs(wf->noise_amp);
+
+	if(wf->pulse_amp != 0.0 && wf->pulse_ms > 0.0 && b >= wf->pulse_at_s){
+		double start = (a > wf->pulse_at_s) ? a : wf->pulse_at_s;
+		double phase = start - wf->pulse_at_s;
+		double width = wf->pulse_ms / 1000.0;
+		bool overlap;
+
+		if(wf->pulse_every_s > 0.0){
+			phase = fmod(phase, wf->pulse_every_s);
+			overlap = phase < width || phase + (b - start) >= wf->pulse_every_s;
+		} else {
+			overlap = phase < width;
+		}
+
+		if(overlap){
+			if(wf->pulse_amp < 0.0) low += wf->pulse_amp;
+			else high += wf->pulse_amp;
+		}
+	}
+
+	*lo = low;
+	*hi = high;
+}
+
+//----------------------------------------- PROFILES ---------------------------------------------------
+
+// Climate-controlled room: slow daily swing, unit standing still
+void host_profile_storage_room(hdc2080_model *hdc, adxl343_model *adxl){
+
+	memset(&hdc->temperature, 0, sizeof(hdc->temperature));
+	memset(&hdc->humidity, 0, sizeof(hdc->humidity));
+
+	hdc->temperature.offset = 22.0;
+	hdc->temperature.sine_amp = 2.0;
+	hdc->temperature.sine_hz = 1.0 / 86400.0;
+	hdc->temperature.noise_amp = 0.05;
+
+	hdc->humidity.offset = 45.0;
+	hdc->humidity.sine_amp = 5.0;
+	hdc->humidity.sine_hz = 1.0 / 86400.0;
+	hdc->humidity.noise_amp = 0.2;
+
+	for(uint8_t i = 0; i < 3; i++){
+		memset(&adxl->axis[i], 0, sizeof(adxl->axis[i]));
+		adxl->axis[i].noise_amp = 4.0;
+	}
+	adxl->axis[2].offset = 1000.0;
+}
+
+// Storage room until start_s, then a cell venting: accelerating temperature
+// rise and humidity dropping as the air heats up
+void host_profile_thermal_runaway(hdc2080_model *hdc, adxl343_model *adxl, double start_s){
+
+	host_profile_storage_room(hdc, adxl);
+
+	hdc->temperature.ramp_start_s = start_s;
+	hdc->temperature.ramp_per_s = 0.01;
+	hdc->temperature.ramp_per_s2 = 0.0002;
+
+	hdc->humidity.ramp_start_s = start_s;
+	hdc->humidity.ramp_per_s = -0.01;
+}
+
+// Portable unit on a pallet: engine/road vibration on Z, sway on X/Y and
+// a pothole every 90 s
+void host_profile_truck(hdc2080_model *hdc, adxl343_model *adxl){
+
+	host_profile_storage_room(hdc, adxl);
+
+	hdc->temperature.offset = 28.0;
+	hdc->humidity.offset = 60.0;
+
+	adxl->axis[0].sine_amp = 80.0;
+	adxl->axis[0].sine_hz = 3.0;
+	adxl->axis[0].noise_amp = 40.0;
+
+	adxl->axis[1].sine_amp = 50.0;
+	adxl->axis[1].sine_hz = 1.7;
+	adxl->axis[1].noise_amp = 40.0;
+
+	adxl->axis[2].sine_amp = 150.0;
+	adxl->axis[2].sine_hz = 12.0;
+	adxl->axis[2].noise_amp = 60.0;
+	adxl->axis[2].pulse_at_s = 30.0;
+	adxl->axis[2].pulse_every_s = 90.0;
+	adxl->axis[2].pulse_ms = 20.0;
+	adxl->axis[2].pulse_amp = 1500.0;
+}